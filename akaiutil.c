@@ -25,6 +25,7 @@
 #include "akaiutil.h"
 #include "akaiutil_file.h"
 #include "akaiutil_take.h"
+#include "akaiutil_cat.h"
 
 
 
@@ -56,6 +57,13 @@ u_int savecurvolindex;
 
 char dirnamebuf[DIRNAMEBUF_LEN+1]; /* +1 for '\0' */
 
+/* resident volume directories */
+static struct vol_res_s vol_res[VOL_RES_NUM];
+static u_int vol_res_age=0; /* age of youngest entry */
+
+/* hashed name indices, Note: one for each partition in part[] */
+static struct akai_partnameidx_s akai_partnameidx[PART_NUM_MAX];
+
 /* filter tags */
 u_char curfiltertag[AKAI_FILE_TAGNUM];
 
@@ -71,6 +79,7 @@ open_disk(char *name,int readonly,OFF64_T startoff,u_int pseudodisksize,u_int ps
 #endif /* _VISUALCPP */
 	u_int disksize;
 	u_int i;
+	u_int disk0;
 
 	if (name==NULL){
 		return -1;
@@ -151,6 +160,10 @@ open_disk(char *name,int readonly,OFF64_T startoff,u_int pseudodisksize,u_int ps
 		/* discard disk, keep old disk_num */
 		return -1;
 	}
+	/* map disk-file into memory for reading if enabled and possible (shared by all pseudo-disks) */
+	/* Note: if not possible, e.g. device, use fd */
+	io_map_open(fd);
+	disk0=disk_num; /* first disk of disk-file */
 	for (i=0;(disk_num<DISK_NUM_MAX)&&(i<PSEUDODISK_NUM_MAX);){
 		if ((pseudodisksize>0)&&(pseudodisknum>0)){ /* pseudo-disk size and max. number of pseudo-disks given? */
 			/* take given pseudodisksize as usable disk size */
@@ -217,6 +230,11 @@ open_disk(char *name,int readonly,OFF64_T startoff,u_int pseudodisksize,u_int ps
 		}
 	}
 
+	if (akai_cat_enable&&(disk_num>disk0)){
+		/* catalog file for all pseudo-disks of disk-file */
+		akai_cat_open(name,fd,disk0,disk_num-disk0); /* Note: ignore error, no catalog */
+	}
+
 	return 0;
 }
 
@@ -235,7 +253,8 @@ close_alldisks(void)
 		disk_num--;
 		fd=disk[disk_num].fd;
 		if (fd>=0){ /* opened? */
-			/* close */
+			/* unmap (if mapped) and close */
+			io_map_close(fd);
 			CLOSE(disk[disk_num].fd);
 			/* mark all disks with same fd as closed */
 			for (i=0;i<=disk_num;i++){
@@ -286,8 +305,7 @@ akai_disksize(int fd,OFF64_T startoff,u_int disksizemax)
 		siz>>=1;
 		/* can read 1 block at off ? */
 		if ((off>=disksizemax) /* beyond max. disk limit? */
-			||(LSEEK64(fd,startoff+((OFF64_T)off),SEEK_SET)<0)
-			||(READ(fd,bbuf,AKAI_DISKSIZE_GRAN)!=(int)AKAI_DISKSIZE_GRAN)){
+			||(PREAD64(fd,bbuf,AKAI_DISKSIZE_GRAN,startoff+((OFF64_T)off))!=(int)AKAI_DISKSIZE_GRAN)){
 			/* block at off is not readable -> off is too high */
 #ifdef DEBUG
 			PRINTF_ERR("akai_disksize: off=%08x siz=%08x high\n",off,siz);
@@ -353,6 +371,11 @@ akai_io_blks(struct part_s *pp,u_char *buf,u_int bstart,u_int bsize,int cacheall
 		return -1;
 	}
 
+	if (mode==IO_BLKS_WRITE){
+		/* volume directories in catalog might be affected */
+		akai_cat_write_blks(pp,bstart,bsize);
+	}
+
 	return io_blks(pp->diskp->fd,
 #ifdef _VISUALCPP
 				   pp->diskp->fldrn,
@@ -367,6 +390,53 @@ akai_io_blks(struct part_s *pp,u_char *buf,u_int bstart,u_int bsize,int cacheall
 
 
 
+/* returns pointer to blocks of partition in memory-mapped disk-file (or NULL if not mapped) */
+/* Note: for reading only, writes must go through akai_io_blks() */
+u_char *
+akai_io_blks_ptr(struct part_s *pp,u_int bstart,u_int bsize)
+{
+
+	if ((pp==NULL)||(pp->diskp==NULL)){
+		return NULL;
+	}
+
+	if (((bstart+bsize)>pp->bsize)
+		||((pp->bstart+bstart+bsize)>pp->diskp->bsize)){
+		return NULL;
+	}
+
+	return io_blks_ptr(pp->diskp->fd,
+					   pp->diskp->startoff,
+					   pp->bstart+bstart,
+					   bsize,
+					   pp->blksize);
+}
+
+/* copy bytes skip...skip+len-1 of blocks of partition to outfd within kernel */
+/* returns 0 if done, 1 if not possible (caller must read and write), -1 if error */
+int
+akai_io_blks_copy(struct part_s *pp,u_int bstart,u_int bsize,u_int skip,u_int len,int outfd)
+{
+
+	if ((pp==NULL)||(pp->diskp==NULL)){
+		return -1;
+	}
+
+	if (((bstart+bsize)>pp->bsize)
+		||((pp->bstart+bstart+bsize)>pp->diskp->bsize)){
+		return -1;
+	}
+
+	return io_blks_copy(pp->diskp->fd,
+						pp->diskp->startoff,
+						pp->bstart+bstart,
+						bsize,
+						pp->blksize,
+						skip,len,outfd);
+}
+
+
+
 /* open external file read-only */
 int
 akai_openreadonly_extfile(char *name)
@@ -556,6 +626,39 @@ akai_check_fatblk(u_int blk,u_int bsize,u_int bsyssize)
 
 
 
+/* returns number of physically contiguous blocks (max. bmax) in FAT chain starting at blk */
+/* and next block in chain behind them in *nextblkp */
+int
+akai_get_fatrun(struct part_s *pp,u_int blk,u_int bmax,u_int *nextblkp)
+{
+	u_int n;
+	u_int nblk;
+
+	if ((pp==NULL)||(pp->fat==NULL)||(nextblkp==NULL)||(bmax==0)){
+		return -1;
+	}
+	if (akai_check_fatblk(blk,pp->bsize,pp->bsyssize)<0){
+		return -1;
+	}
+
+	for (n=1;;n++){
+		/* next block */
+		nblk=(pp->fat[blk][1]<<8)+pp->fat[blk][0];
+		if ((n>=bmax)||(nblk!=(blk+1))){ /* enough or not contiguous? */
+			break;
+		}
+		if (akai_check_fatblk(nblk,pp->bsize,pp->bsyssize)<0){ /* end of chain or invalid? */
+			break; /* Note: let caller decide */
+		}
+		blk=nblk;
+	}
+
+	*nextblkp=nblk;
+	return (int)n;
+}
+
+
+
 int
 print_fatchain(struct part_s *pp,u_int blk)
 {
@@ -997,10 +1100,19 @@ akai_scanbad(struct part_s *pp,int markflag)
 int
 akai_read_file(int outfd,u_char *outbuf,struct file_s *fp,u_int begin,u_int end)
 {
-	u_char fbuf[AKAI_HD_BLOCKSIZE];
-	u_int fblk,fchunk,fremain,skipbyte;
-	u_char (*fatp)[2];
+	u_char *fbuf;
+	u_char *bp;
+	struct part_s *pp;
+	u_int fblk,nblk,fchunk,fremain,skipbyte;
+	u_int blksize;
+	int n,nmax;
 	int err;
+	int copied;
+	int ret;
+#ifdef IO_MAP
+	struct iovec iov[AKAI_FILE_IOVMAX];
+	int iovcnt;
+#endif /* IO_MAP */
 
 	if ((outfd<0)&&(outbuf==NULL)){
 		return -1;
@@ -1012,14 +1124,15 @@ akai_read_file(int outfd,u_char *outbuf,struct file_s *fp,u_int begin,u_int end)
 	if ((fp->volp==NULL)||(fp->volp->type==AKAI_VOL_TYPE_INACT)){
 		return -1;
 	}
-	if ((fp->volp->partp==NULL)||(!fp->volp->partp->valid)){
+	pp=fp->volp->partp;
+	if ((pp==NULL)||(!pp->valid)){
 		return -1;
 	}
-	fatp=fp->volp->partp->fat;
-	if (fatp==NULL){
+	if (pp->fat==NULL){
 		return -1;
 	}
-	if ((fp->volp->partp->blksize==0)||(fp->volp->partp->blksize>AKAI_HD_BLOCKSIZE)){
+	blksize=pp->blksize;
+	if ((blksize==0)||(blksize>AKAI_HD_BLOCKSIZE)){
 		return -1;
 	}
 
@@ -1035,52 +1148,159 @@ akai_read_file(int outfd,u_char *outbuf,struct file_s *fp,u_int begin,u_int end)
 	fblk=fp->bstart; /* start block */
 	fremain=end; /* remaining bytes */
 	skipbyte=begin; /* bytes to skip */
+	/* skip whole blocks */
+	for (;skipbyte>=blksize;){
+		/* check fblk */
+		if (akai_check_fatblk(fblk,pp->bsize,pp->bsyssize)<0){
+			PRINTF_ERR("invalid block in file\n");
+			return -1;
+		}
+		/* next block */
+		fblk=(pp->fat[fblk][1]<<8)+pp->fat[fblk][0];
+		skipbyte-=blksize;
+		fremain-=blksize;
+	}
+	/* Note: now, skipbyte<=fremain */
+	fbuf=NULL; /* not allocated yet */
+	ret=-1; /* no success so far */
+#ifdef IO_MAP
+	iovcnt=0; /* no pending memory-mapped runs so far */
+#endif /* IO_MAP */
 	for (;fremain>0;){ /* byte counter */
-		if (fremain>=fp->volp->partp->blksize){
-			fchunk=fp->volp->partp->blksize;
+		/* get run of contiguous blocks */
+		if ((outbuf!=NULL)&&(skipbyte==0)&&(fremain>=blksize)){
+			/* whole blocks can go directly to buffer */
+			n=akai_get_fatrun(pp,fblk,fremain/blksize,&nblk);
 		}else{
-			fchunk=fremain;
+			/* via fbuf */
+			n=akai_get_fatrun(pp,fblk,(fremain+blksize-1)/blksize,&nblk);
+			if (outbuf!=NULL){
+				nmax=1; /* only first block via fbuf, whole blocks behind it directly to buffer */
+			}else{
+				nmax=(int)(AKAI_FILE_RUNSIZE/blksize);
+			}
+			if (n>nmax){
+				n=nmax;
+				nblk=fblk+(u_int)n; /* Note: still within run */
+			}
 		}
-		/* check fblk */
-		if (akai_check_fatblk(fblk,fp->volp->partp->bsize,fp->volp->partp->bsyssize)<0){
+		if (n<=0){
 			PRINTF_ERR("invalid block in file\n");
-			return -1;
+			goto akai_read_file_exit;
+		}
+		fchunk=((u_int)n)*blksize;
+		if (fchunk>fremain){
+			fchunk=fremain;
 		}
-		if (skipbyte<fchunk){
-			/* read block */
-			if (akai_io_blks(fp->volp->partp,(u_char *)fbuf,
+		if ((outbuf!=NULL)&&(skipbyte==0)&&(fchunk==((u_int)n)*blksize)){
+			/* read blocks directly to buffer */
+			if (akai_io_blks(pp,outbuf,
 							 fblk,
-							 1,
+							 (u_int)n,
 							 0,IO_BLKS_READ)<0){ /* 0: don't alloc cache */
-				return -1;
+				goto akai_read_file_exit;
 			}
-			if (outbuf!=NULL){
+			outbuf+=fchunk;
+		}else{
+			/* blocks in memory-mapped disk-file? */
+			bp=akai_io_blks_ptr(pp,fblk,(u_int)n);
+			copied=0;
+			if ((bp==NULL)&&(outbuf==NULL)){
+#ifdef IO_MAP
+				/* write pending memory-mapped runs first */
+				if (iovcnt>0){
+					if (io_writev(outfd,iov,iovcnt)<0){
+						goto akai_read_file_exit;
+					}
+					iovcnt=0;
+				}
+#endif /* IO_MAP */
+				/* copy blocks to file within kernel if possible */
+				err=akai_io_blks_copy(pp,fblk,(u_int)n,skipbyte,fchunk-skipbyte,outfd);
+				if (err<0){
+					goto akai_read_file_exit;
+				}
+				copied=(err==0);
+			}
+			if ((bp==NULL)&&(!copied)){
+				if (fbuf==NULL){
+					/* Note: allocated per call, only if needed, single block if outbuf (see nmax above) */
+					if ((fbuf=(u_char *)malloc((outbuf!=NULL)?blksize:AKAI_FILE_RUNSIZE))==NULL){
+						PRINTF_ERR("cannot allocate memory\n");
+						goto akai_read_file_exit;
+					}
+				}
+				/* read blocks */
+				if (akai_io_blks(pp,fbuf,
+								 fblk,
+								 (u_int)n,
+								 0,IO_BLKS_READ)<0){ /* 0: don't alloc cache */
+					goto akai_read_file_exit;
+				}
+				bp=fbuf;
+			}
+			if (copied){
+				/* done */
+			}else if (outbuf!=NULL){
 				/* to buffer */
-				bcopy(fbuf+skipbyte,outbuf,fchunk-skipbyte);
+				bcopy(bp+skipbyte,outbuf,fchunk-skipbyte);
 				outbuf+=fchunk-skipbyte;
-			}else{
+			}else
+#ifdef IO_MAP
+			if (bp!=fbuf){
+				/* memory-mapped run, write together with following runs via writev() */
+				if ((iovcnt>0)&&(((u_char *)iov[iovcnt-1].iov_base)+iov[iovcnt-1].iov_len==bp+skipbyte)){
+					/* contiguous with previous run */
+					iov[iovcnt-1].iov_len+=fchunk-skipbyte;
+				}else{
+					if (iovcnt>=AKAI_FILE_IOVMAX){
+						if (io_writev(outfd,iov,iovcnt)<0){
+							goto akai_read_file_exit;
+						}
+						iovcnt=0;
+					}
+					iov[iovcnt].iov_base=(void *)(bp+skipbyte);
+					iov[iovcnt].iov_len=fchunk-skipbyte;
+					iovcnt++;
+				}
+			}else
+#endif /* IO_MAP */
+			{
 				/* write to file */
-				err=WRITE(outfd,(void *)(fbuf+skipbyte),fchunk-skipbyte);
+				/* Note: no pending memory-mapped runs here (see above) */
+				err=WRITE(outfd,(void *)(bp+skipbyte),fchunk-skipbyte);
 				if (err<0){
 					PERROR("write");
-					return -1;
+					goto akai_read_file_exit;
 				}
 				if (err!=(int)(fchunk-skipbyte)){
 					PRINTF_ERR("write: incomplete\n");
-					return -1;
+					goto akai_read_file_exit;
 				}
 			}
 			skipbyte=0; /* done */
-		}else{
-			skipbyte-=fchunk;
 		}
-		/* next block */
-		fblk=(fatp[fblk][1]<<8)+fatp[fblk][0];
+		/* next run */
+		fblk=nblk;
 		/* chunk done */
 		fremain-=fchunk;
 	}
+#ifdef IO_MAP
+	/* write pending memory-mapped runs */
+	if (iovcnt>0){
+		if (io_writev(outfd,iov,iovcnt)<0){
+			goto akai_read_file_exit;
+		}
+	}
+#endif /* IO_MAP */
 
-	return 0;
+	ret=0; /* success */
+
+akai_read_file_exit:
+	if (fbuf!=NULL){
+		free(fbuf);
+	}
+	return ret;
 }
 
 
@@ -1088,10 +1308,13 @@ akai_read_file(int outfd,u_char *outbuf,struct file_s *fp,u_int begin,u_int end)
 int
 akai_write_file(int inpfd,u_char *inpbuf,struct file_s *fp,u_int begin,u_int end)
 {
-	u_char fbuf[AKAI_HD_BLOCKSIZE];
-	u_int fblk,fchunk,fremain,skipbyte;
-	u_char (*fatp)[2];
+	u_char *fbuf;
+	struct part_s *pp;
+	u_int fblk,nblk,fchunk,fremain,skipbyte;
+	u_int blksize;
+	int n,nmax;
 	int err;
+	int ret;
 
 	if ((inpfd<0)&&(inpbuf==NULL)){
 		return -1;
@@ -1103,14 +1326,15 @@ akai_write_file(int inpfd,u_char *inpbuf,struct file_s *fp,u_int begin,u_int end
 	if ((fp->volp==NULL)||(fp->volp->type==AKAI_VOL_TYPE_INACT)){
 		return -1;
 	}
-	if ((fp->volp->partp==NULL)||(!fp->volp->partp->valid)){
+	pp=fp->volp->partp;
+	if ((pp==NULL)||(!pp->valid)){
 		return -1;
 	}
-	fatp=fp->volp->partp->fat;
-	if (fatp==NULL){
+	if (pp->fat==NULL){
 		return -1;
 	}
-	if ((fp->volp->partp->blksize==0)||(fp->volp->partp->blksize>AKAI_HD_BLOCKSIZE)){
+	blksize=pp->blksize;
+	if ((blksize==0)||(blksize>AKAI_HD_BLOCKSIZE)){
 		return -1;
 	}
 
@@ -1126,25 +1350,69 @@ akai_write_file(int inpfd,u_char *inpbuf,struct file_s *fp,u_int begin,u_int end
 	fblk=fp->bstart; /* start block */
 	fremain=end; /* remaining bytes */
 	skipbyte=begin; /* bytes to skip */
+	/* skip whole blocks */
+	for (;skipbyte>=blksize;){
+		/* check fblk */
+		if (akai_check_fatblk(fblk,pp->bsize,pp->bsyssize)<0){
+			PRINTF_ERR("invalid block in file\n");
+			return -1;
+		}
+		/* next block */
+		fblk=(pp->fat[fblk][1]<<8)+pp->fat[fblk][0];
+		skipbyte-=blksize;
+		fremain-=blksize;
+	}
+	/* Note: now, skipbyte<=fremain */
+	fbuf=NULL; /* not allocated yet */
+	ret=-1; /* no success so far */
 	for (;fremain>0;){ /* byte counter */
-		if (fremain>=fp->volp->partp->blksize){
-			fchunk=fp->volp->partp->blksize;
+		if ((skipbyte==0)&&(fremain>=blksize)){
+			/* whole blocks: get run of contiguous blocks */
+			n=akai_get_fatrun(pp,fblk,fremain/blksize,&nblk);
+			if (inpbuf==NULL){
+				nmax=(int)(AKAI_FILE_RUNSIZE/blksize); /* via fbuf */
+				if (n>nmax){
+					n=nmax;
+					nblk=fblk+(u_int)n; /* Note: still within run */
+				}
+			}
 		}else{
-			fchunk=fremain;
+			/* partial block: single block */
+			n=akai_get_fatrun(pp,fblk,1,&nblk);
 		}
-		/* check fblk */
-		if (akai_check_fatblk(fblk,fp->volp->partp->bsize,fp->volp->partp->bsyssize)<0){
+		if (n<=0){
 			PRINTF_ERR("invalid block in file\n");
-			return -1;
+			goto akai_write_file_exit;
+		}
+		fchunk=((u_int)n)*blksize;
+		if (fchunk>fremain){
+			fchunk=fremain;
 		}
-		if (skipbyte<fchunk){
-			if ((skipbyte>0)||(fchunk<fp->volp->partp->blksize)){ /* need to read? */
+		if ((inpbuf!=NULL)&&(skipbyte==0)&&(fchunk==((u_int)n)*blksize)){
+			/* write blocks directly from buffer */
+			if (akai_io_blks(pp,inpbuf,
+							 fblk,
+							 (u_int)n,
+							 0,IO_BLKS_WRITE)<0){ /* 0: don't alloc cache */
+				goto akai_write_file_exit;
+			}
+			inpbuf+=fchunk;
+		}else{
+			if (fbuf==NULL){
+				/* Note: allocated per call, only if needed, single block if inpbuf (partial block) */
+				if ((fbuf=(u_char *)malloc((inpbuf!=NULL)?blksize:AKAI_FILE_RUNSIZE))==NULL){
+					PRINTF_ERR("cannot allocate memory\n");
+					goto akai_write_file_exit;
+				}
+			}
+			if ((skipbyte>0)||(fchunk<blksize)){ /* need to read? */
+				/* Note: partial block, n==1 */
 				/* read block */
-				if (akai_io_blks(fp->volp->partp,(u_char *)fbuf,
+				if (akai_io_blks(pp,fbuf,
 								 fblk,
 								 1,
 								 0,IO_BLKS_READ)<0){ /* 0: don't alloc cache */
-					return -1;
+					goto akai_write_file_exit;
 				}
 			}
 			if (inpbuf!=NULL){
@@ -1156,31 +1424,35 @@ akai_write_file(int inpfd,u_char *inpbuf,struct file_s *fp,u_int begin,u_int end
 				err=READ(inpfd,(void *)(fbuf+skipbyte),fchunk-skipbyte);
 				if (err<0){
 					PERROR("read");
-					return -1;
+					goto akai_write_file_exit;
 				}
 				if (err!=(int)(fchunk-skipbyte)){
 					PRINTF_ERR("read: incomplete\n");
-					return -1;
+					goto akai_write_file_exit;
 				}
 			}
-			/* write block */
-			if (akai_io_blks(fp->volp->partp,(u_char *)fbuf,
+			/* write blocks */
+			if (akai_io_blks(pp,fbuf,
 							 fblk,
-							 1,
+							 (u_int)n,
 							 0,IO_BLKS_WRITE)<0){ /* 0: don't alloc cache */
-				return -1;
+				goto akai_write_file_exit;
 			}
 			skipbyte=0; /* done */
-		}else{
-			skipbyte-=fchunk;
 		}
-		/* next block */
-		fblk=(fatp[fblk][1]<<8)+fatp[fblk][0];
+		/* next run */
+		fblk=nblk;
 		/* chunk done */
 		fremain-=fchunk;
 	}
 
-	return 0;
+	ret=0; /* success */
+
+akai_write_file_exit:
+	if (fbuf!=NULL){
+		free(fbuf);
+	}
+	return ret;
 }
 
 
@@ -1461,15 +1733,15 @@ akai_allocate_ddfatchain_done:
 
 
 
+/* Note: cursor must be released via akai_ddcursor_end() */
 int
-akai_export_ddfatchain(struct part_s *pp,u_int cstart,u_int bstart,u_int bsize,int outfd,u_char *outbuf)
+akai_ddcursor_init(struct akai_ddcursor_s *cp,struct part_s *pp,u_int cstart)
 {
-	static u_char buf[AKAI_DDPART_CBLKS*AKAI_HD_BLOCKSIZE];
-	u_int bufsiz;
-	u_int i,i0,i1;
-	u_int cl,nextcl;
-	u_int chunkoff,chunksiz;
-	int err;
+
+	if (cp==NULL){
+		return -1;
+	}
+	cp->buf=NULL; /* not allocated yet */
 
 	if ((pp==NULL)||(!pp->valid)||(pp->fat==NULL)){
 		return -1;
@@ -1480,67 +1752,151 @@ akai_export_ddfatchain(struct part_s *pp,u_int cstart,u_int bstart,u_int bsize,i
 	if (cstart>=pp->csize){
 		return -1;
 	}
-	if ((outfd<0)&&(outbuf==NULL)){
+
+	cp->pp=pp;
+	cp->cstart=cstart;
+	cp->bpos=0;
+	cp->ci=0;
+	cp->cl=cstart;
+
+	/* allocate buffer for 1 cluster */
+	if ((cp->buf=(u_char *)malloc(AKAI_DDPART_CBLKS*AKAI_HD_BLOCKSIZE))==NULL){
+		PERROR("malloc");
 		return -1;
 	}
 
-	if (bsize==0){
-		return 0;
+	return 0;
+}
+
+
+
+void
+akai_ddcursor_end(struct akai_ddcursor_s *cp)
+{
+
+	if (cp==NULL){
+		return;
 	}
 
-	bufsiz=AKAI_DDPART_CBLKS*AKAI_HD_BLOCKSIZE; /* 1 cluster in bytes */
+	if (cp->buf!=NULL){
+		free(cp->buf);
+		cp->buf=NULL;
+	}
+}
+
+
+
+/* Note: FAT chain is walked lazily by akai_ddcursor_getcl() */
+void
+akai_ddcursor_seek(struct akai_ddcursor_s *cp,u_int bpos)
+{
+
+	if (cp==NULL){
+		return;
+	}
+
+	cp->bpos=bpos;
+}
+
+
 
-	i0=bstart/bufsiz; /* first cluster for export */
-	i1=(bstart+bsize-1)/bufsiz; /* last cluster for export */
-	if (i1>=pp->csize){
+/* returns cluster at current byte position (or -1 if invalid) */
+/* Note: walks forward from last cluster, only restarts at cstart if position is behind it */
+int
+akai_ddcursor_getcl(struct akai_ddcursor_s *cp)
+{
+	u_int ci;
+	u_int cl;
+
+	if ((cp==NULL)||(cp->pp==NULL)){
 		return -1;
 	}
 
-	cl=cstart;
-	for (i=0;i<=i1;i++){
+	ci=cp->bpos/(AKAI_DDPART_CBLKS*AKAI_HD_BLOCKSIZE); /* target cluster index */
+	if (ci<cp->ci){ /* behind current cluster? */
+		/* restart at beginning of chain */
+		cp->ci=0;
+		cp->cl=cp->cstart;
+	}
+	cl=cp->cl;
+	for (;;){
 		/* check cl */
 		if ((cl==AKAI_DDFAT_CODE_FREE)
 			||(cl==AKAI_DDFAT_CODE_BAD)
 			||(cl==AKAI_DDFAT_CODE_SYS)
 			||(cl==AKAI_DDFAT_CODE_END)
-			||(cl>=pp->csize)){ /* invalid? */
+			||(cl>=cp->pp->csize)){ /* invalid? */
+			return -1;
+		}
+		cp->cl=cl;
+		if (cp->ci==ci){
+			break; /* found */
+		}
+		if (cp->ci>=cp->pp->csize){ /* XXX to avoid loop */
 			return -1;
 		}
 		/* next cluster */
-		nextcl=(pp->fat[cl][1]<<8)+pp->fat[cl][0];
+		cl=(cp->pp->fat[cl][1]<<8)+cp->pp->fat[cl][0];
+		cp->ci++;
+	}
 
-		if (i>=i0){ /* far enough? */
-			/* read cluster */
-			if (akai_io_blks(pp,buf,
-							 cl*AKAI_DDPART_CBLKS, /* block offset */
+	return (int)cl;
+}
+
+
+
+/* read bsize bytes at current position of cursor, advance cursor */
+/* Note: sample data, don't pollute block cache (metadata is kept in cache) */
+int
+akai_ddcursor_read(struct akai_ddcursor_s *cp,u_int bsize,int outfd,u_char *outbuf)
+{
+	u_int bufsiz;
+	u_int chunkoff,chunksiz;
+	int cl;
+	int err;
+
+	if ((cp==NULL)||(cp->pp==NULL)||(cp->buf==NULL)){
+		return -1;
+	}
+	if ((outfd<0)&&(outbuf==NULL)){
+		return -1;
+	}
+
+	bufsiz=AKAI_DDPART_CBLKS*AKAI_HD_BLOCKSIZE; /* 1 cluster in bytes */
+
+	while (bsize>0){
+		cl=akai_ddcursor_getcl(cp);
+		if (cl<0){
+			return -1;
+		}
+		chunkoff=cp->bpos%bufsiz;
+		chunksiz=bufsiz-chunkoff;
+		if (chunksiz>bsize){
+			chunksiz=bsize;
+		}
+
+		if ((outbuf!=NULL)&&(chunksiz==bufsiz)){
+			/* whole cluster directly to buffer */
+			if (akai_io_blks(cp->pp,outbuf,
+							 ((u_int)cl)*AKAI_DDPART_CBLKS, /* block offset */
 							 AKAI_DDPART_CBLKS, /* 1 cluster */
-							 1,IO_BLKS_READ)<0){  /* 1: alloc cache if possible */
+							 0,IO_BLKS_READ)<0){  /* 0: don't alloc cache */
 				return -1;
 			}
-
-			if (i==i0){ /* first cluster? */
-				chunkoff=bstart-i0*bufsiz;
-				chunksiz=bufsiz-chunkoff;
-				/* Note: chunkoff and chunksiz <= bufsiz by definition of i0 */
-				if (chunksiz>bsize){
-					chunksiz=bsize;
-				}
-			}else if (i==i1){ /* last cluster? */
-				chunkoff=0;
-				chunksiz=bstart+bsize-i1*bufsiz;
-				/* Note: chunksiz <= bufsiz by definition of i1 */
-			}else{
-				chunkoff=0;
-				chunksiz=bufsiz; /* 1 cluster */
+		}else{
+			/* read cluster */
+			if (akai_io_blks(cp->pp,cp->buf,
+							 ((u_int)cl)*AKAI_DDPART_CBLKS, /* block offset */
+							 AKAI_DDPART_CBLKS, /* 1 cluster */
+							 0,IO_BLKS_READ)<0){  /* 0: don't alloc cache */
+				return -1;
 			}
-
 			if (outbuf!=NULL){
 				/* to buffer */
-				bcopy(buf+chunkoff,outbuf,chunksiz);
-				outbuf+=chunksiz;
+				bcopy(cp->buf+chunkoff,outbuf,chunksiz);
 			}else{
 				/* write to file */
-				err=WRITE(outfd,buf+chunkoff,chunksiz);
+				err=WRITE(outfd,cp->buf+chunkoff,chunksiz);
 				if (err<0){
 					PERROR("write");
 					return -1;
@@ -1551,12 +1907,13 @@ akai_export_ddfatchain(struct part_s *pp,u_int cstart,u_int bstart,u_int bsize,i
 				}
 			}
 		}
+		if (outbuf!=NULL){
+			outbuf+=chunksiz;
+		}
 
 		/* advance */
-		if (nextcl==AKAI_DDFAT_CODE_END){
-			break; /* end of chain, done */
-		}
-		cl=nextcl;
+		cp->bpos+=chunksiz;
+		bsize-=chunksiz;
 	}
 
 	return 0;
@@ -1564,92 +1921,56 @@ akai_export_ddfatchain(struct part_s *pp,u_int cstart,u_int bstart,u_int bsize,i
 
 
 
+/* write bsize bytes at current position of cursor, advance cursor */
+/* Note: sample data, don't pollute block cache (metadata is kept in cache) */
 int
-akai_import_ddfatchain(struct part_s *pp,u_int cstart,u_int bstart,u_int bsize,int inpfd,u_char *inpbuf)
+akai_ddcursor_write(struct akai_ddcursor_s *cp,u_int bsize,int inpfd,u_char *inpbuf)
 {
-	static u_char buf[AKAI_DDPART_CBLKS*AKAI_HD_BLOCKSIZE];
 	u_int bufsiz;
-	u_int i,i0,i1;
-	u_int cl,nextcl;
 	u_int chunkoff,chunksiz;
-	int readflag;
+	u_char *bp;
+	int cl;
 	int err;
 
-	if ((pp==NULL)||(!pp->valid)||(pp->fat==NULL)){
-		return -1;
-	}
-	if (pp->type!=PART_TYPE_DD){
-		return -1;
-	}
-	if (cstart>=pp->csize){
+	if ((cp==NULL)||(cp->pp==NULL)||(cp->buf==NULL)){
 		return -1;
 	}
 	if ((inpfd<0)&&(inpbuf==NULL)){
 		return -1;
 	}
 
-	if (bsize==0){
-		return 0;
-	}
-
 	bufsiz=AKAI_DDPART_CBLKS*AKAI_HD_BLOCKSIZE; /* 1 cluster in bytes */
 
-	i0=bstart/bufsiz; /* first cluster for export */
-	i1=(bstart+bsize-1)/bufsiz; /* last cluster for export */
-	if (i1>=pp->csize){
-		return -1;
-	}
-
-	cl=cstart;
-	for (i=0;i<=i1;i++){
-		/* check cl */
-		if ((cl==AKAI_DDFAT_CODE_FREE)
-			||(cl==AKAI_DDFAT_CODE_BAD)
-			||(cl==AKAI_DDFAT_CODE_SYS)
-			||(cl==AKAI_DDFAT_CODE_END)
-			||(cl>=pp->csize)){ /* invalid? */
+	while (bsize>0){
+		cl=akai_ddcursor_getcl(cp);
+		if (cl<0){
 			return -1;
 		}
-		/* next cluster */
-		nextcl=(pp->fat[cl][1]<<8)+pp->fat[cl][0];
+		chunkoff=cp->bpos%bufsiz;
+		chunksiz=bufsiz-chunkoff;
+		if (chunksiz>bsize){
+			chunksiz=bsize;
+		}
 
-		if (i>=i0){ /* far enough? */
-			if (i==i0){ /* first cluster? */
-				chunkoff=bstart-i0*bufsiz;
-				chunksiz=bufsiz-chunkoff;
-				/* Note: chunkoff and chunksiz <= bufsiz by definition of i0 */
-				if (chunksiz>bsize){
-					chunksiz=bsize;
-				}
-				readflag=1;
-			}else if (i==i1){ /* last cluster? */
-				chunkoff=0;
-				chunksiz=bstart+bsize-i1*bufsiz;
-				/* Note: chunksiz <= bufsiz by definition of i1 */
-				readflag=1;
-			}else{
-				chunkoff=0;
-				chunksiz=bufsiz; /* 1 cluster */
-				readflag=0;
-			}
-
-			if (readflag){
+		if ((inpbuf!=NULL)&&(chunksiz==bufsiz)){
+			/* whole cluster directly from buffer */
+			bp=inpbuf;
+		}else{
+			if (chunksiz<bufsiz){ /* partial cluster? */
 				/* read cluster */
-				if (akai_io_blks(pp,buf,
-								 cl*AKAI_DDPART_CBLKS, /* block offset */
+				if (akai_io_blks(cp->pp,cp->buf,
+								 ((u_int)cl)*AKAI_DDPART_CBLKS, /* block offset */
 								 AKAI_DDPART_CBLKS, /* 1 cluster */
-								 1,IO_BLKS_READ)<0){  /* 1: alloc cache if possible */
+								 0,IO_BLKS_READ)<0){  /* 0: don't alloc cache */
 					return -1;
 				}
 			}
-
 			if (inpbuf!=NULL){
 				/* from buffer */
-				bcopy(inpbuf,buf+chunkoff,chunksiz);
-				inpbuf+=chunksiz;
+				bcopy(inpbuf,cp->buf+chunkoff,chunksiz);
 			}else{
 				/* read from file */
-				err=READ(inpfd,buf+chunkoff,chunksiz);
+				err=READ(inpfd,cp->buf+chunkoff,chunksiz);
 				if (err<0){
 					PERROR("read");
 					return -1;
@@ -1659,21 +1980,23 @@ akai_import_ddfatchain(struct part_s *pp,u_int cstart,u_int bstart,u_int bsize,i
 					return -1;
 				}
 			}
+			bp=cp->buf;
+		}
 
-			/* write cluster */
-			if (akai_io_blks(pp,buf,
-							 cl*AKAI_DDPART_CBLKS, /* block offset */
-							 AKAI_DDPART_CBLKS, /* 1 cluster */
-							 1,IO_BLKS_WRITE)<0){  /* 1: alloc cache if possible */
-				return -1;
-			}
+		/* write cluster */
+		if (akai_io_blks(cp->pp,bp,
+						 ((u_int)cl)*AKAI_DDPART_CBLKS, /* block offset */
+						 AKAI_DDPART_CBLKS, /* 1 cluster */
+						 0,IO_BLKS_WRITE)<0){  /* 0: don't alloc cache */
+			return -1;
+		}
+		if (inpbuf!=NULL){
+			inpbuf+=chunksiz;
 		}
 
 		/* advance */
-		if (nextcl==AKAI_DDFAT_CODE_END){
-			break; /* end of chain, done */
-		}
-		cl=nextcl;
+		cp->bpos+=chunksiz;
+		bsize-=chunksiz;
 	}
 
 	return 0;
@@ -1681,6 +2004,62 @@ akai_import_ddfatchain(struct part_s *pp,u_int cstart,u_int bstart,u_int bsize,i
 
 
 
+int
+akai_export_ddfatchain(struct part_s *pp,u_int cstart,u_int bstart,u_int bsize,int outfd,u_char *outbuf)
+{
+	struct akai_ddcursor_s c;
+	int ret;
+
+	if ((outfd<0)&&(outbuf==NULL)){
+		return -1;
+	}
+
+	if (akai_ddcursor_init(&c,pp,cstart)<0){
+		akai_ddcursor_end(&c);
+		return -1;
+	}
+
+	if (bsize==0){
+		ret=0;
+	}else{
+		akai_ddcursor_seek(&c,bstart);
+		ret=akai_ddcursor_read(&c,bsize,outfd,outbuf);
+	}
+
+	akai_ddcursor_end(&c);
+	return ret;
+}
+
+
+
+int
+akai_import_ddfatchain(struct part_s *pp,u_int cstart,u_int bstart,u_int bsize,int inpfd,u_char *inpbuf)
+{
+	struct akai_ddcursor_s c;
+	int ret;
+
+	if ((inpfd<0)&&(inpbuf==NULL)){
+		return -1;
+	}
+
+	if (akai_ddcursor_init(&c,pp,cstart)<0){
+		akai_ddcursor_end(&c);
+		return -1;
+	}
+
+	if (bsize==0){
+		ret=0;
+	}else{
+		akai_ddcursor_seek(&c,bstart);
+		ret=akai_ddcursor_write(&c,bsize,inpfd,inpbuf);
+	}
+
+	akai_ddcursor_end(&c);
+	return ret;
+}
+
+
+
 /* convert char for S1000/S3000 */
 char
 akai2ascii(u_char c)
@@ -2056,162 +2435,570 @@ ascii2akai_filename(char *name,u_char *aname,u_int *osverp,int s900flag)
 			ft=(u_char)u;
 			/* Note: might still be invalid */
 		}
-		if (s900flag){
-			*osverp=0; /* non-compressed */
+		if (s900flag){
+			*osverp=0; /* non-compressed */
+		}
+	}
+
+	/* name */
+	ascii2akai_name(namebuf,aname,s900flag);
+
+#if 1
+	if (ft==AKAI_VOLDIR3000FL_FTYPE){ /* S3000 floppy flag? */
+		ft=AKAI_FTYPE_FREE; /* invalid */
+	}
+#endif
+
+	/* Note: caller must check for AKAI_FTYPE_FREE as invalid code */
+	return ft;
+}
+
+
+
+void
+akai_vol_info(struct vol_s *vp,u_int ai,int verbose)
+{
+
+	if ((vp==NULL)||(vp->type==AKAI_VOL_TYPE_INACT)
+		||(vp->partp==NULL)||(!vp->partp->valid)){
+		return;
+	}
+
+	if (verbose){
+#if 1
+		if ((vp->partp->type==PART_TYPE_FLL)||(vp->partp->type==PART_TYPE_FLH)){ /* floppy? */
+			/* for floppy, print also some info about partition: */
+			/* Note: floppy has only one volume within one partition which covers the whole disk */
+			PRINTF_OUT("parttype:    ");
+			if (vp->partp->type==PART_TYPE_FLL){
+				PRINTF_OUT("low-density floppy");
+			}else{
+				PRINTF_OUT("high-density floppy");
+			}
+			PRINTF_OUT("\nblksize:     0x%04x bytes\n",vp->partp->blksize);
+			PRINTF_OUT("size:        0x%04x blocks (%6u KB)\n",
+				vp->partp->bsize,
+				(vp->partp->bsize*vp->partp->blksize)/1024); /* in KB */
+			PRINTF_OUT("free:        0x%04x blocks (%6u KB) = %5.1lf%%\n",
+				vp->partp->bfree,
+				(vp->partp->bfree*vp->partp->blksize)/1024, /* in KB */
+				(vp->partp->bsize>0)?(100.0*((double)vp->partp->bfree)/((double)vp->partp->bsize)):0.0);
+			PRINTF_OUT("bad:         0x%04x blocks (%6u KB) = %5.1lf%%\n",
+				vp->partp->bbad,
+				(vp->partp->bbad*vp->partp->blksize)/1024, /* in KB */
+				(vp->partp->bsize>0)?(100.0*((double)vp->partp->bbad)/((double)vp->partp->bsize)):0.0);
+		}
+#endif
+		PRINTF_OUT("vnr:         %u\n",vp->index+1);
+		PRINTF_OUT("vname:       \"%s\"\n",vp->name);
+		if (vp->partp->type==PART_TYPE_HD9){
+			if (ai>0){
+				PRINTF_OUT("alias:       V%u\n",ai);
+			}
+		}else if (vp->type!=AKAI_VOL_TYPE_S900){
+			PRINTF_OUT("load number: ");
+			akai_print_lnum(vp->lnum);
+			PRINTF_OUT("\n");
+		}
+		PRINTF_OUT("voltype:     ");
+	}else{
+		PRINTF_OUT("%3u   %-12s   ",vp->index+1,vp->name);
+		if (vp->partp->type==PART_TYPE_HD9){
+			PRINTF_OUT("V%-3u",ai);
+		}else{
+			akai_print_lnum(vp->lnum);
+		}
+		PRINTF_OUT("    0x%04x  ",vp->dirblk[0]);
+		if (vp->type!=AKAI_VOL_TYPE_S900){
+			PRINTF_OUT("%2u.%02u  ",0xff&(vp->osver>>8),0xff&vp->osver);
+		}else{
+			PRINTF_OUT(" -     ");
+		}
+	}
+	switch (vp->type){
+	case AKAI_VOL_TYPE_INACT:
+		PRINTF_OUT("INACT");
+		break;
+	case AKAI_VOL_TYPE_S1000:
+		PRINTF_OUT("S1000");
+		break;
+	case AKAI_VOL_TYPE_S3000:
+		PRINTF_OUT("S3000");
+		break;
+	case AKAI_VOL_TYPE_CD3000:
+		PRINTF_OUT("CD3000");
+		break;
+	case AKAI_VOL_TYPE_S900:
+		PRINTF_OUT("S900");
+		break;
+	default:
+		PRINTF_OUT("(%02x)",vp->type);
+		break;
+	}
+	PRINTF_OUT("\n");
+	if (verbose){
+		if (vp->type!=AKAI_VOL_TYPE_S900){
+			PRINTF_OUT("osver:       %u.%02u\n",0xff&(vp->osver>>8),0xff&vp->osver);
+		}
+		PRINTF_OUT("start:       block 0x%04x\n",vp->dirblk[0]);
+		PRINTF_OUT("max. files:  %u\n",vp->fimax);
+	}
+}
+
+void
+akai_list_vol(struct vol_s *vp,u_char *filtertagp)
+{
+	u_int fi;
+	struct file_s tmpfile; /* current file */
+	u_int totf,totb;
+
+	if ((vp==NULL)||(vp->type==AKAI_VOL_TYPE_INACT)
+		||(vp->partp==NULL)||(!vp->partp->valid)
+		||(vp->partp->diskp==NULL)){
+		return;
+	}
+
+	PRINTF_OUT("/disk%u/%c/%s\n",vp->partp->diskp->index,vp->partp->letter,vp->name);
+	if (vp->type==AKAI_VOL_TYPE_S900){
+		PRINTF_OUT("fnr  fname               size/B  startblk  uncompr\n");
+		PRINTF_OUT("--------------------------------------------------\n");
+	}else{
+		PRINTF_OUT("fnr  fname               size/B  startblk  osver  tags\n");
+		PRINTF_OUT("--------------------------------------------------------------\n");
+	}
+
+	/* files in volume directory */
+	totf=0;
+	totb=0;
+	for (fi=0;fi<vp->fimax;fi++){
+		/* get file */
+		if (akai_get_file(vp,&tmpfile,fi)<0){
+			continue; /* next file */
+		}
+		/* test if tag-filter matches */
+		if (akai_match_filetags(filtertagp,tmpfile.tag)<0){ /* no match? */
+			continue; /* next file */
+		}
+		totf++;
+		totb+=tmpfile.size;
+		/* print file info */
+		akai_file_info(&tmpfile,0);
+	}
+
+	if (vp->type==AKAI_VOL_TYPE_S900){
+		PRINTF_OUT("--------------------------------------------------\n");
+	}else{
+		PRINTF_OUT("--------------------------------------------------------------\n");
+	}
+	PRINTF_OUT("total: %3u file(s) (max. %3u), %9u bytes\n\n",totf,vp->fimax,totb);
+}
+
+
+
+/* resident volume directories */
+/* Note: avoid reading volume directory blocks again when changing between volumes */
+
+void
+akai_clear_volres(void)
+{
+	u_int i;
+
+	for (i=0;i<VOL_RES_NUM;i++){
+		vol_res[i].age=0;
+	}
+	vol_res_age=0;
+}
+
+/* volume vi has been created, removed or modified outside of volume directory entries */
+void
+akai_drop_volres(struct part_s *pp,u_int vi)
+{
+	u_int i;
+
+	for (i=0;i<VOL_RES_NUM;i++){
+		if ((vol_res[i].age!=0)&&(vol_res[i].vol.partp==pp)&&(vol_res[i].vol.index==vi)){
+			vol_res[i].age=0;
+		}
+	}
+}
+
+/* find resident volume directory of vp */
+/* returns NULL if not resident */
+static struct vol_res_s *
+akai_find_volres(struct vol_s *vp,u_int imax)
+{
+	u_int i;
+
+	if ((vp->partp<&part[0])||(vp->partp>=&part[part_num])){ /* not in part[]? */
+		return NULL; /* e.g. temporary partition, address might be reused */
+	}
+	for (i=0;i<VOL_RES_NUM;i++){
+		if ((vol_res[i].age!=0)
+			&&(vol_res[i].vol.partp==vp->partp)
+			&&(vol_res[i].vol.index==vp->index)
+			&&(vol_res[i].vol.type==vp->type)
+			&&(vol_res[i].vol.fimax==vp->fimax)
+			&&(memcmp(vol_res[i].vol.dirblk,vp->dirblk,imax*sizeof(u_int))==0)){
+			vol_res[i].age=++vol_res_age;
+			return &vol_res[i];
+		}
+	}
+	return NULL;
+}
+
+/* make volume directory of vp resident */
+static void
+akai_put_volres(struct vol_s *vp,u_int imax)
+{
+	struct vol_res_s *rp;
+	u_int i;
+
+	if (!blk_cache_enable){
+		return;
+	}
+	if ((vp->partp<&part[0])||(vp->partp>=&part[part_num])){ /* not in part[]? */
+		return;
+	}
+	if ((rp=akai_find_volres(vp,imax))==NULL){
+		/* replace oldest (or unused) entry */
+		rp=&vol_res[0];
+		for (i=1;i<VOL_RES_NUM;i++){
+			if (vol_res[i].age<rp->age){
+				rp=&vol_res[i];
+			}
+		}
+		rp->age=++vol_res_age;
+	}
+	akai_copy_structvol(vp,&rp->vol);
+}
+
+
+
+/* hashed name index */
+/* Note: built upon first lookup, kept in sync if names in directory are modified */
+/*       an entry found via index is always compared with the name in the directory */
+
+static u_int
+akai_nameidx_hash(char *name)
+{
+	u_int h;
+
+	/* FNV-1a, case-insensitive (see strcasecmp()) */
+	h=0x811c9dc5;
+	while (*name!='\0'){
+		h^=(u_int)tolower((u_char)*name);
+		h*=0x01000193;
+		name++;
+	}
+	return h;
+}
+
+static struct akai_nameidx_s *
+akai_nameidx_alloc(u_int num)
+{
+	struct akai_nameidx_s *ip;
+	u_int hsize;
+	u_int i;
+
+	if ((num==0)||(num>=AKAI_NAMEIDX_NONE)){
+		return NULL;
+	}
+	for (hsize=1;hsize<num;hsize<<=1);
+	/* Note: one allocation for all arrays, u_int first for alignment */
+	ip=(struct akai_nameidx_s *)malloc(sizeof(struct akai_nameidx_s)
+									   +num*sizeof(u_int)
+									   +(hsize+num)*sizeof(u_short));
+	if (ip==NULL){
+		return NULL;
+	}
+	ip->num=num;
+	ip->hsize=hsize;
+	ip->hash=(u_int *)(ip+1);
+	ip->head=(u_short *)(ip->hash+num);
+	ip->next=ip->head+hsize;
+	for (i=0;i<hsize;i++){
+		ip->head[i]=AKAI_NAMEIDX_END;
+	}
+	for (i=0;i<num;i++){
+		ip->next[i]=AKAI_NAMEIDX_NONE;
+	}
+	ip->type=0;
+	ip->fimax=0;
+	ip->dirblk0=0;
+	return ip;
+}
+
+static void
+akai_nameidx_add(struct akai_nameidx_s *ip,u_int i,char *name)
+{
+	u_short *linkp;
+
+	if ((i>=ip->num)||(ip->next[i]!=AKAI_NAMEIDX_NONE)){
+		return;
+	}
+	ip->hash[i]=akai_nameidx_hash(name);
+	/* insert sorted by index */
+	linkp=&ip->head[ip->hash[i]&(ip->hsize-1)];
+	while ((*linkp!=AKAI_NAMEIDX_END)&&(*linkp<i)){
+		linkp=&ip->next[*linkp];
+	}
+	ip->next[i]=*linkp;
+	*linkp=(u_short)i;
+}
+
+static void
+akai_nameidx_del(struct akai_nameidx_s *ip,u_int i)
+{
+	u_short *linkp;
+
+	if ((i>=ip->num)||(ip->next[i]==AKAI_NAMEIDX_NONE)){
+		return;
+	}
+	linkp=&ip->head[ip->hash[i]&(ip->hsize-1)];
+	while (*linkp!=AKAI_NAMEIDX_END){
+		if (*linkp==i){
+			*linkp=ip->next[i];
+			break;
+		}
+		linkp=&ip->next[*linkp];
+	}
+	ip->next[i]=AKAI_NAMEIDX_NONE;
+}
+
+static void
+akai_free_partnameidx(struct akai_partnameidx_s *xp)
+{
+	u_int vi;
+
+	if (xp->vol!=NULL){
+		free(xp->vol);
+		xp->vol=NULL;
+	}
+	if (xp->file!=NULL){
+		for (vi=0;vi<xp->volnum;vi++){
+			if (xp->file[vi]!=NULL){
+				free(xp->file[vi]);
+			}
+		}
+		free(xp->file);
+		xp->file=NULL;
+	}
+	xp->volnum=0;
+}
+
+void
+akai_free_nameidx(void)
+{
+	u_int pi;
+
+	for (pi=0;pi<PART_NUM_MAX;pi++){
+		akai_free_partnameidx(&akai_partnameidx[pi]);
+		akai_partnameidx[pi].diskp=NULL;
+	}
+}
+
+/* get name indices of partition */
+/* returns NULL if no index possible */
+static struct akai_partnameidx_s *
+akai_get_partnameidx(struct part_s *pp)
+{
+	struct akai_partnameidx_s *xp;
+
+	if ((pp==NULL)||(!pp->valid)||(pp->type==PART_TYPE_DD)){
+		return NULL;
+	}
+	if ((pp<&part[0])||(pp>=&part[part_num])){ /* not in part[]? */
+		return NULL; /* e.g. temporary partition */
+	}
+	xp=&akai_partnameidx[pp-&part[0]];
+	if ((xp->diskp!=pp->diskp)||(xp->index!=pp->index)||(xp->type!=pp->type)||(xp->bstart!=pp->bstart)){
+		/* other partition in part[] now, e.g. after restart */
+		akai_free_partnameidx(xp);
+		xp->diskp=pp->diskp;
+		xp->index=pp->index;
+		xp->type=pp->type;
+		xp->bstart=pp->bstart;
+	}
+	return xp;
+}
+
+/* get name of volume vi in root directory */
+/* returns 0 if OK, -1 if inactive volume */
+static int
+akai_get_volname(struct part_s *pp,u_int vi,char *vnamebuf)
+{
+	u_int osver;
+
+	if (pp->type==PART_TYPE_FLL){
+		/* OS version in floppy header */
+		osver=(pp->head.fll.label.osver[1]<<8)+pp->head.fll.label.osver[0];
+		/* volume name in floppy header */
+		akai2ascii_name(pp->head.fll.label.name,vnamebuf,osver==AKAI_OSVER_S900VOL);
+	}else if (pp->type==PART_TYPE_FLH){
+		/* OS version in floppy header */
+		osver=(pp->head.flh.label.osver[1]<<8)+pp->head.flh.label.osver[0];
+		/* volume name in floppy header */
+		akai2ascii_name(pp->head.flh.label.name,vnamebuf,osver==AKAI_OSVER_S900VOL);
+	}else if (pp->type==PART_TYPE_HD9){
+		/* S900 harddisk */
+		if (((pp->head.hd9.vol[vi].start[1]<<8)+pp->head.hd9.vol[vi].start[0])==AKAI_VOL_START_INACT){ /* inactive? */
+			return -1;
+		}
+		/* volume name in root directory entry */
+		akai2ascii_name(pp->head.hd9.vol[vi].name,vnamebuf,1); /* 1: S900 */
+	}else if (pp->type==PART_TYPE_HD){
+		/* S1000/S3000 harddisk sampler partition */
+		if (pp->head.hd.vol[vi].type==AKAI_VOL_TYPE_INACT){ /* inactive? */
+			return -1;
 		}
+		/* volume name in root directory */
+		akai2ascii_name(pp->head.hd.vol[vi].name,vnamebuf,0); /* 0: not S900 */
+	}else{
+		return -1;
 	}
 
-	/* name */
-	ascii2akai_name(namebuf,aname,s900flag);
-
-#if 1
-	if (ft==AKAI_VOLDIR3000FL_FTYPE){ /* S3000 floppy flag? */
-		ft=AKAI_FTYPE_FREE; /* invalid */
+	if (vnamebuf[0]=='\0'){ /* empty volume name? */
+		/* use default volume name as fake volume name */
+		sprintf(vnamebuf,"VOLUME %03u",vi+1);
 	}
-#endif
 
-	/* Note: caller must check for AKAI_FTYPE_FREE as invalid code */
-	return ft;
+	return 0;
 }
 
+/* get index of volume names in root directory of partition, build if necessary */
+/* returns NULL if no index */
+static struct akai_nameidx_s *
+akai_get_volnameidx(struct part_s *pp)
+{
+	struct akai_partnameidx_s *xp;
+	struct akai_nameidx_s *ip;
+	char vnamebuf[AKAI_NAME_LEN+1]; /* +1 for '\0' */
+	u_int vi;
+
+	if ((pp==NULL)||((pp->type!=PART_TYPE_HD9)&&(pp->type!=PART_TYPE_HD))){
+		return NULL; /* Note: floppy has one volume only */
+	}
+	if ((xp=akai_get_partnameidx(pp))==NULL){
+		return NULL;
+	}
+	if (xp->vol!=NULL){
+		return xp->vol;
+	}
 
+	/* build */
+	if ((ip=akai_nameidx_alloc(pp->volnummax))==NULL){
+		return NULL;
+	}
+	for (vi=0;vi<pp->volnummax;vi++){
+		if (akai_get_volname(pp,vi,vnamebuf)==0){
+			akai_nameidx_add(ip,vi,vnamebuf);
+		}
+	}
+	xp->vol=ip;
+	return ip;
+}
 
+/* root directory entry of volume vi has been modified */
 void
-akai_vol_info(struct vol_s *vp,u_int ai,int verbose)
+akai_update_volnameidx(struct part_s *pp,u_int vi)
 {
+	struct akai_partnameidx_s *xp;
+	char vnamebuf[AKAI_NAME_LEN+1]; /* +1 for '\0' */
 
-	if ((vp==NULL)||(vp->type==AKAI_VOL_TYPE_INACT)
-		||(vp->partp==NULL)||(!vp->partp->valid)){
+	if ((xp=akai_get_partnameidx(pp))==NULL){
 		return;
 	}
-
-	if (verbose){
-#if 1
-		if ((vp->partp->type==PART_TYPE_FLL)||(vp->partp->type==PART_TYPE_FLH)){ /* floppy? */
-			/* for floppy, print also some info about partition: */
-			/* Note: floppy has only one volume within one partition which covers the whole disk */
-			PRINTF_OUT("parttype:    ");
-			if (vp->partp->type==PART_TYPE_FLL){
-				PRINTF_OUT("low-density floppy");
-			}else{
-				PRINTF_OUT("high-density floppy");
-			}
-			PRINTF_OUT("\nblksize:     0x%04x bytes\n",vp->partp->blksize);
-			PRINTF_OUT("size:        0x%04x blocks (%6u KB)\n",
-				vp->partp->bsize,
-				(vp->partp->bsize*vp->partp->blksize)/1024); /* in KB */
-			PRINTF_OUT("free:        0x%04x blocks (%6u KB) = %5.1lf%%\n",
-				vp->partp->bfree,
-				(vp->partp->bfree*vp->partp->blksize)/1024, /* in KB */
-				(vp->partp->bsize>0)?(100.0*((double)vp->partp->bfree)/((double)vp->partp->bsize)):0.0);
-			PRINTF_OUT("bad:         0x%04x blocks (%6u KB) = %5.1lf%%\n",
-				vp->partp->bbad,
-				(vp->partp->bbad*vp->partp->blksize)/1024, /* in KB */
-				(vp->partp->bsize>0)?(100.0*((double)vp->partp->bbad)/((double)vp->partp->bsize)):0.0);
-		}
-#endif
-		PRINTF_OUT("vnr:         %u\n",vp->index+1);
-		PRINTF_OUT("vname:       \"%s\"\n",vp->name);
-		if (vp->partp->type==PART_TYPE_HD9){
-			if (ai>0){
-				PRINTF_OUT("alias:       V%u\n",ai);
-			}
-		}else if (vp->type!=AKAI_VOL_TYPE_S900){
-			PRINTF_OUT("load number: ");
-			akai_print_lnum(vp->lnum);
-			PRINTF_OUT("\n");
-		}
-		PRINTF_OUT("voltype:     ");
-	}else{
-		PRINTF_OUT("%3u   %-12s   ",vp->index+1,vp->name);
-		if (vp->partp->type==PART_TYPE_HD9){
-			PRINTF_OUT("V%-3u",ai);
-		}else{
-			akai_print_lnum(vp->lnum);
-		}
-		PRINTF_OUT("    0x%04x  ",vp->dirblk[0]);
-		if (vp->type!=AKAI_VOL_TYPE_S900){
-			PRINTF_OUT("%2u.%02u  ",0xff&(vp->osver>>8),0xff&vp->osver);
-		}else{
-			PRINTF_OUT(" -     ");
-		}
-	}
-	switch (vp->type){
-	case AKAI_VOL_TYPE_INACT:
-		PRINTF_OUT("INACT");
-		break;
-	case AKAI_VOL_TYPE_S1000:
-		PRINTF_OUT("S1000");
-		break;
-	case AKAI_VOL_TYPE_S3000:
-		PRINTF_OUT("S3000");
-		break;
-	case AKAI_VOL_TYPE_CD3000:
-		PRINTF_OUT("CD3000");
-		break;
-	case AKAI_VOL_TYPE_S900:
-		PRINTF_OUT("S900");
-		break;
-	default:
-		PRINTF_OUT("(%02x)",vp->type);
-		break;
+	if ((xp->vol==NULL)||(vi>=xp->vol->num)){
+		return; /* no index yet */
 	}
-	PRINTF_OUT("\n");
-	if (verbose){
-		if (vp->type!=AKAI_VOL_TYPE_S900){
-			PRINTF_OUT("osver:       %u.%02u\n",0xff&(vp->osver>>8),0xff&vp->osver);
-		}
-		PRINTF_OUT("start:       block 0x%04x\n",vp->dirblk[0]);
-		PRINTF_OUT("max. files:  %u\n",vp->fimax);
+	akai_nameidx_del(xp->vol,vi);
+	if (akai_get_volname(pp,vi,vnamebuf)==0){
+		akai_nameidx_add(xp->vol,vi,vnamebuf);
 	}
 }
 
+/* volume vi has been created or removed */
 void
-akai_list_vol(struct vol_s *vp,u_char *filtertagp)
+akai_drop_filenameidx(struct part_s *pp,u_int vi)
 {
-	u_int fi;
-	struct file_s tmpfile; /* current file */
-	u_int totf,totb;
+	struct akai_partnameidx_s *xp;
 
-	if ((vp==NULL)||(vp->type==AKAI_VOL_TYPE_INACT)
-		||(vp->partp==NULL)||(!vp->partp->valid)
-		||(vp->partp->diskp==NULL)){
+	if ((xp=akai_get_partnameidx(pp))==NULL){
 		return;
 	}
+	if ((xp->file!=NULL)&&(vi<xp->volnum)&&(xp->file[vi]!=NULL)){
+		free(xp->file[vi]);
+		xp->file[vi]=NULL;
+	}
+}
 
-	PRINTF_OUT("/disk%u/%c/%s\n",vp->partp->diskp->index,vp->partp->letter,vp->name);
-	if (vp->type==AKAI_VOL_TYPE_S900){
-		PRINTF_OUT("fnr  fname               size/B  startblk  uncompr\n");
-		PRINTF_OUT("--------------------------------------------------\n");
-	}else{
-		PRINTF_OUT("fnr  fname               size/B  startblk  osver  tags\n");
-		PRINTF_OUT("--------------------------------------------------------------\n");
+/* get index of file names in volume directory, build if necessary */
+/* returns NULL if no index */
+static struct akai_nameidx_s *
+akai_get_filenameidx(struct vol_s *vp,int buildflag)
+{
+	struct akai_partnameidx_s *xp;
+	struct akai_nameidx_s *ip;
+	struct file_s tmpfile;
+	u_int fi;
+
+	if ((xp=akai_get_partnameidx(vp->partp))==NULL){
+		return NULL;
+	}
+	if (vp->index>=vp->partp->volnummax){
+		return NULL;
+	}
+	if (xp->file==NULL){
+		if (!buildflag){
+			return NULL;
+		}
+		xp->file=(struct akai_nameidx_s **)calloc(vp->partp->volnummax,sizeof(struct akai_nameidx_s *));
+		if (xp->file==NULL){
+			return NULL;
+		}
+		xp->volnum=vp->partp->volnummax;
+	}
+	ip=xp->file[vp->index];
+	if ((ip!=NULL)
+		&&((ip->type!=vp->type)||(ip->fimax!=vp->fimax)||(ip->dirblk0!=vp->dirblk[0]))){
+		/* other volume now */
+		free(ip);
+		xp->file[vp->index]=ip=NULL;
+	}
+	if ((ip!=NULL)||(!buildflag)){
+		return ip;
 	}
 
-	/* files in volume directory */
-	totf=0;
-	totb=0;
+	/* build */
+	if ((ip=akai_nameidx_alloc(vp->fimax))==NULL){
+		return NULL;
+	}
+	ip->type=vp->type;
+	ip->fimax=vp->fimax;
+	ip->dirblk0=vp->dirblk[0];
 	for (fi=0;fi<vp->fimax;fi++){
-		/* get file */
-		if (akai_get_file(vp,&tmpfile,fi)<0){
-			continue; /* next file */
-		}
-		/* test if tag-filter matches */
-		if (akai_match_filetags(filtertagp,tmpfile.tag)<0){ /* no match? */
-			continue; /* next file */
+		if (akai_get_file(vp,&tmpfile,fi)==0){
+			akai_nameidx_add(ip,fi,tmpfile.name);
 		}
-		totf++;
-		totb+=tmpfile.size;
-		/* print file info */
-		akai_file_info(&tmpfile,0);
 	}
+	xp->file[vp->index]=ip;
+	return ip;
+}
 
-	if (vp->type==AKAI_VOL_TYPE_S900){
-		PRINTF_OUT("--------------------------------------------------\n");
-	}else{
-		PRINTF_OUT("--------------------------------------------------------------\n");
+/* volume directory entry fi has been modified */
+void
+akai_update_filenameidx(struct vol_s *vp,u_int fi)
+{
+	struct akai_nameidx_s *ip;
+	struct file_s tmpfile;
+
+	if ((ip=akai_get_filenameidx(vp,0))==NULL){ /* 0: don't build */
+		return; /* no index yet */
+	}
+	akai_nameidx_del(ip,fi);
+	if (akai_get_file(vp,&tmpfile,fi)==0){
+		akai_nameidx_add(ip,fi,tmpfile.name);
 	}
-	PRINTF_OUT("total: %3u file(s) (max. %3u), %9u bytes\n\n",totf,vp->fimax,totb);
 }
 
 
@@ -2219,6 +3006,7 @@ akai_list_vol(struct vol_s *vp,u_char *filtertagp)
 int
 akai_read_voldir(struct vol_s *vp)
 {
+	struct vol_res_s *rp;
 	u_int i,imax;
 	u_int blk;
 	u_char *addr;
@@ -2237,6 +3025,18 @@ akai_read_voldir(struct vol_s *vp)
 		return -1;
 	}
 
+	/* resident volume directory? */
+	if (blk_cache_enable&&((rp=akai_find_volres(vp,imax))!=NULL)){
+		bcopy((u_char *)rp->vol.file,(u_char *)vp->file,imax*vp->partp->blksize);
+		return 0;
+	}
+
+	/* volume directory in catalog? */
+	if (akai_cat_get_voldir(vp)==0){
+		akai_put_volres(vp,imax);
+		return 0;
+	}
+
 	/* Note: first file starts at byte 0 in first block */
 	addr=(u_char *)vp->file;
 	for (i=0;i<imax;i++){
@@ -2255,6 +3055,9 @@ akai_read_voldir(struct vol_s *vp)
 		addr+=vp->partp->blksize; /* next */
 	}
 
+	akai_cat_put_voldir(vp);
+	akai_put_volres(vp,imax);
+
 	return 0;
 }
 
@@ -2263,6 +3066,8 @@ akai_read_voldir(struct vol_s *vp)
 int
 akai_write_voldir(struct vol_s *vp,u_int fi)
 {
+	struct vol_res_s *rp;
+	u_int imax;
 	u_int blk0,blk1;
 	u_int blk;
 	u_char *addr;
@@ -2316,6 +3121,22 @@ akai_write_voldir(struct vol_s *vp,u_int fi)
 		}
 	}
 
+	/* update volume directory in catalog */
+	akai_cat_put_voldir(vp);
+
+	/* update resident volume directory */
+	/* Note: only written block(s), as on disk */
+	imax=vp->fimax*sizeof(struct akai_voldir_entry_s);
+	imax=(imax+vp->partp->blksize-1)/vp->partp->blksize; /* round up */
+	if ((imax<=VOL_DIRBLKS)&&((rp=akai_find_volres(vp,imax))!=NULL)){
+		bcopy(((u_char *)vp->file)+blk0*vp->partp->blksize,
+			  ((u_char *)rp->vol.file)+blk0*vp->partp->blksize,
+			  (blk1-blk0+1)*vp->partp->blksize);
+	}
+
+	/* update name index */
+	akai_update_filenameidx(vp,fi);
+
 	return 0;
 }
 
@@ -2684,12 +3505,13 @@ akai_get_vol(struct part_s *pp,struct vol_s *vp,u_int vi)
 int
 akai_find_vol(struct part_s *pp,struct vol_s *vp,char *name)
 {
-	u_int osver;
+	struct akai_nameidx_s *ip;
+	u_int h;
 	u_int vi;
 	u_int ai,aivifound;
 	char namebuf[AKAI_NAME_LEN+1]; /* +1 for '\0' */
 	char vnamebuf[AKAI_NAME_LEN+1]; /* +1 for '\0' */
-	u_int i,j,l;
+	u_int i,l;
 
 	if ((pp==NULL)||(!pp->valid)){
 		return -1;
@@ -2726,46 +3548,34 @@ akai_find_vol(struct part_s *pp,struct vol_s *vp,char *name)
 		}
 	}
 
+	/* volumes in name index */
+	if ((ip=akai_get_volnameidx(pp))!=NULL){
+		h=akai_nameidx_hash(namebuf);
+		for (vi=ip->head[h&(ip->hsize-1)];vi!=AKAI_NAMEIDX_END;vi=ip->next[vi]){
+			if (ip->hash[vi]!=h){
+				continue; /* next */
+			}
+			/* compare name (case-insensitive) */
+			if ((akai_get_volname(pp,vi,vnamebuf)==0)&&(strcasecmp(vnamebuf,namebuf)==0)){ /* match? */
+				/* get volume */
+				return akai_get_vol(pp,vp,vi);
+			}
+		}
+		if (pp->type!=PART_TYPE_HD9){
+			return -1; /* not found */
+		}
+		/* else: S900 harddisk, alias name below */
+	}
+
 	/* volumes in partition */
 	aivifound=pp->volnummax; /* invalid */
 	ai=0;
 	for (vi=0;vi<pp->volnummax;vi++){
-		if (pp->type==PART_TYPE_FLL){
-			/* OS version in floppy header */
-			osver=(pp->head.fll.label.osver[1]<<8)+pp->head.fll.label.osver[0];
-			/* volume name in floppy header */
-			akai2ascii_name(pp->head.fll.label.name,vnamebuf,osver==AKAI_OSVER_S900VOL);
-		}else if (pp->type==PART_TYPE_FLH){
-			/* OS version in floppy header */
-			osver=(pp->head.flh.label.osver[1]<<8)+pp->head.flh.label.osver[0];
-			/* volume name in floppy header */
-			akai2ascii_name(pp->head.flh.label.name,vnamebuf,osver==AKAI_OSVER_S900VOL);
-		}else if (pp->type==PART_TYPE_HD9){
-			/* S900 harddisk */
-			j=vp->dirblk[0]=(pp->head.hd9.vol[vi].start[1]<<8)
-				+pp->head.hd9.vol[vi].start[0];
-			if (j==AKAI_VOL_START_INACT){ /* inactive? */
-				continue; /* next */
-			}
-			/* volume name in root directory entry */
-			akai2ascii_name(pp->head.hd9.vol[vi].name,vnamebuf,1); /* 1: S900 */
-		}else if (pp->type==PART_TYPE_HD){
-			/* S1000/S3000 harddisk sampler partition */
-			if (pp->head.hd.vol[vi].type==AKAI_VOL_TYPE_INACT){ /* inactive? */
-				continue; /* next */
-			}
-			/* volume name in root directory */
-			akai2ascii_name(pp->head.hd.vol[vi].name,vnamebuf,0); /* 0: not S900 */
-		}else{
+		if (akai_get_volname(pp,vi,vnamebuf)<0){
 			continue; /* next */
 		}
 		ai++;
 
-		if (vnamebuf[0]=='\0'){ /* empty volume name? */
-			/* use default volume name as fake volume name */
-			sprintf(vnamebuf,"VOLUME %03u",vi+1);
-		}
-
 		/* compare name (case-insensitive) */
 		if (strcasecmp(vnamebuf,namebuf)==0){ /* match? */
 			break; /* found */
@@ -2811,6 +3621,9 @@ akai_rename_vol(struct vol_s *vp,char *name,u_int lnum,u_int osver,struct akai_v
 		return -1;
 	}
 
+	/* Note: volume parameters in volume directory might be modified below */
+	akai_drop_volres(vp->partp,vp->index);
+
 	if ((vp->partp->type==PART_TYPE_FLL)||(vp->partp->type==PART_TYPE_FLH)){
 		/* floppy */
 
@@ -2936,6 +3749,8 @@ akai_rename_vol(struct vol_s *vp,char *name,u_int lnum,u_int osver,struct akai_v
 							 1,IO_BLKS_WRITE)<0){ /* 1: allocate cache if possible */
 				return -1;
 			}
+			/* update name index */
+			akai_update_volnameidx(vp->partp,vp->index);
 		}
 		
 		/* Note: no volume parameters on S900 harddisk */
@@ -2992,6 +3807,8 @@ akai_rename_vol(struct vol_s *vp,char *name,u_int lnum,u_int osver,struct akai_v
 							 1,IO_BLKS_WRITE)<0){ /* 1: allocate cache if possible */
 				return -1;
 			}
+			/* update name index */
+			akai_update_volnameidx(vp->partp,vp->index);
 		}
 		
 		/* volume parameters */
@@ -3287,6 +4104,11 @@ akai_create_vol(struct part_s *pp,struct vol_s *vp,u_int type,u_int index,char *
 		}
 	}
 
+	/* update name index */
+	akai_update_volnameidx(vp->partp,vp->index);
+	akai_drop_filenameidx(vp->partp,vp->index);
+	akai_drop_volres(vp->partp,vp->index);
+
 	return 0;
 }
 
@@ -3364,6 +4186,11 @@ akai_wipe_vol(struct vol_s *vp,int delflag)
 				return -1;
 			}
 		}
+
+		/* update name index */
+		akai_update_volnameidx(vp->partp,vp->index);
+		akai_drop_filenameidx(vp->partp,vp->index);
+		akai_drop_volres(vp->partp,vp->index);
 	}
 
 	/* count free and bad blocks */
@@ -4524,6 +5351,8 @@ akai_get_file(struct vol_s *vp,struct file_s *fp,u_int fi)
 int
 akai_find_file(struct vol_s *vp,struct file_s *fp,char *name)
 {
+	struct akai_nameidx_s *ip;
+	u_int h;
 	u_int fi;
 	char namebuf[AKAI_NAME_LEN+4+1]; /* +4 for ".<type>", +1 for '\0' */
 	u_int i,j,k,l;
@@ -4576,6 +5405,25 @@ akai_find_file(struct vol_s *vp,struct file_s *fp,char *name)
 		namebuf[k+i]='\0';
 	}
 
+	/* files in name index */
+	if ((ip=akai_get_filenameidx(vp,1))!=NULL){ /* 1: build if necessary */
+		h=akai_nameidx_hash(namebuf);
+		for (fi=ip->head[h&(ip->hsize-1)];fi!=AKAI_NAMEIDX_END;fi=ip->next[fi]){
+			if (ip->hash[fi]!=h){
+				continue; /* next */
+			}
+			/* get file */
+			if (akai_get_file(vp,fp,fi)<0){
+				continue; /* next */
+			}
+			/* compare name (case-insensitive) */
+			if (strcasecmp(fp->name,namebuf)==0){ /* match? */
+				return 0; /* found */
+			}
+		}
+		return -1; /* not found */
+	}
+
 	/* files in volume directory */
 	for (fi=0;fi<vp->fimax;fi++){
 		/* get file */
@@ -5216,6 +6064,32 @@ akai_check_parttabmagic(struct akai_parttab_s *ptp)
 
 
 
+/* set start of FAT in header according to partition type */
+/* Note: e.g. for a partition restored from a copy, see comment for struct part_s */
+void
+akai_fix_partfat(struct part_s *pp)
+{
+
+	if (pp==NULL){
+		return;
+	}
+
+	if ((pp->type==PART_TYPE_FLL)||(pp->type==PART_TYPE_FLH)){
+		/* Note: FAT-start same for low- and high density floppy */
+		pp->fat=&pp->head.flh.fatblk[0];
+	}else if (pp->type==PART_TYPE_HD9){
+		pp->fat=&pp->head.hd9.fatblk[0];
+	}else if (pp->type==PART_TYPE_HD){
+		pp->fat=&pp->head.hd.fatblk[0];
+	}else if (pp->type==PART_TYPE_DD){
+		pp->fat=&pp->head.dd.fatcl[0];
+	}else{
+		pp->fat=NULL;
+	}
+}
+
+
+
 int
 akai_scan_floppy(struct disk_s *dp)
 {
@@ -5640,6 +6514,15 @@ akai_scan_disk(struct disk_s *dp,int floppyenable)
 		return -1;
 	}
 
+	/* scan result in catalog? */
+	if ((retval=akai_cat_scan_disk(dp))>=0){
+		if (retval==0){ /* no partitions? */
+			PRINTF_OUT("disk%u: invalid format\n",dp->index);
+			return -1;
+		}
+		return 0;
+	}
+
 	/* set disk type */
 	/* first guess: S1000/S3000 harddisk */
 	dp->type=DISK_TYPE_HD;
@@ -5894,6 +6777,10 @@ akai_wipe_part(struct part_s *pp,int wipeflag,struct part_s *plistp,u_int pimax,
 		return -1;
 	}
 
+	/* Note: name indices and resident volume directories are rebuilt if necessary */
+	akai_free_nameidx();
+	akai_clear_volres();
+
 	if (pp->type==PART_TYPE_DD){
 		/* S1100/S3000 harddisk DD partition */
 
@@ -6300,6 +7187,10 @@ akai_wipe_harddisk9(struct disk_s *dp,u_int totb)
 		return -1;
 	}
 
+	/* Note: name indices and resident volume directories are rebuilt if necessary */
+	akai_free_nameidx();
+	akai_clear_volres();
+
 	/* S900 harddisk */
 
 	/* Note: overwrite part[] */
@@ -6373,6 +7264,9 @@ akai_wipe_floppy(struct disk_s *dp,int lodensflag,int s3000flag,int s900flag)
 	/* floppy */
 
 	/* Note: overwrite part[] */
+	/* Note: name indices and resident volume directories are rebuilt if necessary */
+	akai_free_nameidx();
+	akai_clear_volres();
 	if (PART_NUM_MAX<1){
 		PRINTF_ERR("not enough partition space allocated\n");
 		return -1;
@@ -6971,9 +7865,11 @@ list_curfiltertags(void)
 int
 copy_file(struct file_s *srcfp,struct vol_s *dstvp,struct file_s *dstfp,u_int dstindex,char *dstname,int delflag)
 {
-	struct file_s tmpfile;
 	u_char *tmpbuf;
+	struct file_s tmpfile;
+	u_int begin,end;
 	int existsflag;
+	int ret;
 
 	if ((srcfp==NULL)||(dstvp==NULL)){
 		return -1;
@@ -6983,12 +7879,6 @@ copy_file(struct file_s *srcfp,struct vol_s *dstvp,struct file_s *dstfp,u_int ds
 		dstname=srcfp->name;
 	}
 
-	/* allocate buffer */
-	if ((tmpbuf=(u_char *)malloc(srcfp->size))==NULL){
-		PERROR("malloc");
-		return -1;
-	}
-
 	/* check if destination file already exists */
 	existsflag=0;
 	if (dstindex==AKAI_CREATE_FILE_NOINDEX){ /* no user-supplied index? */
@@ -7006,7 +7896,6 @@ copy_file(struct file_s *srcfp,struct vol_s *dstvp,struct file_s *dstfp,u_int ds
 		/* same file? Note: same partition and same block should be unique */
 		if ((srcfp->volp->partp==tmpfile.volp->partp)&&(srcfp->bstart==tmpfile.bstart)){
 			PRINTF_ERR("cannot copy to same file\n");
-			free(tmpbuf);
 			return -1;
 		}
 		/* exists */
@@ -7014,12 +7903,10 @@ copy_file(struct file_s *srcfp,struct vol_s *dstvp,struct file_s *dstfp,u_int ds
 			/* delete file */
 			if (akai_delete_file(&tmpfile)<0){
 				PRINTF_ERR("cannot overwrite existing file\n");
-				free(tmpbuf);
 				return -1;
 			}
 		}else{
 			PRINTF_OUT("file name already used\n");
-			free(tmpbuf);
 			return -1;
 		}
 	}
@@ -7030,7 +7917,6 @@ copy_file(struct file_s *srcfp,struct vol_s *dstvp,struct file_s *dstfp,u_int ds
 						 srcfp->osver, /* default: from source file */
 						 (srcfp->volp->type==AKAI_VOL_TYPE_S900)?NULL:srcfp->tag)<0){ /* no tags from S900 */
 		PRINTF_ERR("cannot create file\n");
-		free(tmpbuf);
 		return -1;
 	}
 
@@ -7039,22 +7925,42 @@ copy_file(struct file_s *srcfp,struct vol_s *dstvp,struct file_s *dstfp,u_int ds
 		*dstfp=tmpfile;
 	}
 
-	/* read file */
-	if (akai_read_file(0,tmpbuf,srcfp,0,srcfp->size)<0){
-		PRINTF_OUT("read error\n");
-		free(tmpbuf);
-		return -1;
+	if (tmpfile.size==0){
+		return 0; /* done */
 	}
 
-	/* write file */
-	if (akai_write_file(0,tmpbuf,&tmpfile,0,tmpfile.size)<0){
-		PRINTF_OUT("write error\n");
-		free(tmpbuf);
+	/* allocate chunk buffer */
+	if ((tmpbuf=(u_char *)malloc((tmpfile.size<AKAI_FILE_RUNSIZE)?tmpfile.size:AKAI_FILE_RUNSIZE))==NULL){
+		PRINTF_ERR("cannot allocate memory\n");
 		return -1;
 	}
 
+	ret=-1; /* no success so far */
+	/* copy file in chunks */
+	/* Note: chunk size is multiple of blocksize of both partitions */
+	for (begin=0;begin<tmpfile.size;begin=end){
+		end=begin+AKAI_FILE_RUNSIZE;
+		if (end>tmpfile.size){
+			end=tmpfile.size;
+		}
+
+		/* read chunk */
+		if (akai_read_file(0,tmpbuf,srcfp,begin,end)<0){
+			PRINTF_OUT("read error\n");
+			goto copy_file_exit;
+		}
+
+		/* write chunk */
+		if (akai_write_file(0,tmpbuf,&tmpfile,begin,end)<0){
+			PRINTF_OUT("write error\n");
+			goto copy_file_exit;
+		}
+	}
+	ret=0; /* success */
+
+copy_file_exit:
 	free(tmpbuf);
-	return 0;
+	return ret;
 }
 
 
@@ -50,6 +50,10 @@
 
 /* harddisk filesystem blocksize */
 #define AKAI_HD_BLOCKSIZE		0x2000 /* 8KB */
+/* Note: must be <= BLK_CACHE_BLKSIZE_MAX (max. blocksize of cached blocks, defined in akaiutil_io.h) */
+#if defined(BLK_CACHE_BLKSIZE_MAX)&&(AKAI_HD_BLOCKSIZE>BLK_CACHE_BLKSIZE_MAX)
+#error "AKAI_HD_BLOCKSIZE>BLK_CACHE_BLKSIZE_MAX"
+#endif
 
 /* S900 harddisk */
 #define AKAI_HD9_MAXSIZE		0x1fff /* max. harddisk size in harddisk blocks (approx. 64MB) */
@@ -499,6 +503,53 @@ struct file_s{
 /* Note: must be careful with volp if vol_s behind it has changed/disappeared !!! */
 /*       this could be a problem with non-unique curvolp/curvol_buf */
 
+/* cursor for streaming access to DD FAT chain */
+struct akai_ddcursor_s{
+	struct part_s *pp; /* pointer to DD partition */
+	u_int cstart; /* start cluster of chain */
+	u_int bpos; /* current byte position within chain */
+	u_int ci; /* index of cluster cl within chain */
+	u_int cl; /* cluster with index ci */
+	u_char *buf; /* buffer for 1 cluster (for partial clusters and file I/O) */
+};
+
+/* resident volume directory */
+#ifndef VOL_RES_NUM
+#define VOL_RES_NUM	32 /* XXX max. number of resident volume directories */
+#endif
+struct vol_res_s{
+	u_int age; /* for LRU, 0 if unused */
+	struct vol_s vol; /* self-contained copy, see akai_copy_structvol() */
+};
+/* Note: only used if block cache is enabled (no shared access) */
+
+/* hashed name index of root directory or volume directory */
+struct akai_nameidx_s{
+	u_int num; /* number of entries (volumes or files) */
+	u_int hsize; /* number of hash chains, power of 2 */
+	u_int *hash; /* hash of name, for each entry */
+#define AKAI_NAMEIDX_END	0xffff /* end of hash chain */
+#define AKAI_NAMEIDX_NONE	0xfffe /* entry not in index */
+	u_short *head; /* first entry in hash chain */
+	u_short *next; /* next entry in hash chain, for each entry */
+	/* if volume directory: */
+	u_int type; /* volume type */
+	u_int fimax; /* max. file entries */
+	u_int dirblk0; /* first directory block */
+};
+/* Note: entries of a hash chain are sorted by index => first match is first entry in directory */
+
+/* hashed name indices of partition */
+struct akai_partnameidx_s{
+	struct disk_s *diskp; /* disk of partition, for check if part[] has changed */
+	u_int index; /* index of partition on disk */
+	u_int type; /* partition type */
+	u_int bstart; /* start block on disk */
+	struct akai_nameidx_s *vol; /* index of volume names in root directory */
+	u_int volnum; /* number of entries in file[] */
+	struct akai_nameidx_s **file; /* index of file names, for each volume */
+};
+
 
 
 /* disks */
@@ -556,18 +607,27 @@ extern void close_alldisks(void);
 extern u_int akai_disksize(int fd,OFF64_T startoff,u_int disksizemax);
 
 extern int akai_io_blks(struct part_s *pp,u_char *buf,u_int bstart,u_int bsize,int cachealloc,int mode);
+extern u_char *akai_io_blks_ptr(struct part_s *pp,u_int bstart,u_int bsize);
+extern int akai_io_blks_copy(struct part_s *pp,u_int bstart,u_int bsize,u_int skip,u_int len,int outfd);
 
 extern int akai_openreadonly_extfile(char *name);
 extern int akai_check_extwavname(char *wavname);
 
 extern void akai_countfree_part(struct part_s *pp);
 extern int akai_check_fatblk(u_int blk,u_int bsize,u_int bsyssize);
+extern int akai_get_fatrun(struct part_s *pp,u_int blk,u_int bmax,u_int *nextblkp);
 extern int print_fatchain(struct part_s *pp,u_int blk);
 extern int akai_free_fatchain(struct part_s *pp,u_int bstart,int writeflag);
 extern int akai_allocate_fatchain(struct part_s *pp,u_int bsize,u_int *bstartp,u_int bcont0,u_int endcode);
 
 extern int akai_scanbad(struct part_s *pp,int markflag);
 
+#ifndef AKAI_FILE_RUNSIZE
+#define AKAI_FILE_RUNSIZE	(AKAI_DDPART_CBLKS*AKAI_HD_BLOCKSIZE) /* XXX max. bytes per I/O of contiguous file blocks via buffer */
+#endif
+#ifndef AKAI_FILE_IOVMAX
+#define AKAI_FILE_IOVMAX	64 /* max. number of memory-mapped runs per writev() */
+#endif
 extern int akai_read_file(int outfd,u_char *outbuf,struct file_s *fp,u_int begin,u_int end);
 extern int akai_write_file(int inpfd,u_char *inpbuf,struct file_s *fp,u_int begin,u_int end);
 
@@ -576,6 +636,12 @@ extern u_int akai_count_ddfatchain(struct part_s *pp,u_int cstart);
 extern int akai_free_ddfatchain(struct part_s *pp,u_int cstart,int writeflag);
 extern int akai_allocate_ddfatchain(struct part_s *pp,u_int csize,u_int *cstartp,u_int ccont0);
 
+extern int akai_ddcursor_init(struct akai_ddcursor_s *cp,struct part_s *pp,u_int cstart);
+extern void akai_ddcursor_end(struct akai_ddcursor_s *cp);
+extern void akai_ddcursor_seek(struct akai_ddcursor_s *cp,u_int bpos);
+extern int akai_ddcursor_getcl(struct akai_ddcursor_s *cp);
+extern int akai_ddcursor_read(struct akai_ddcursor_s *cp,u_int bsize,int outfd,u_char *outbuf);
+extern int akai_ddcursor_write(struct akai_ddcursor_s *cp,u_int bsize,int inpfd,u_char *inpbuf);
 extern int akai_export_ddfatchain(struct part_s *pp,u_int cstart,u_int bstart,u_int bsize,int outfd,u_char *outbuf);
 extern int akai_import_ddfatchain(struct part_s *pp,u_int cstart,u_int bstart,u_int bsize,int inpfd,u_char *inpbuf);
 
@@ -590,6 +656,14 @@ extern u_char ascii2akai_filename(char *name,u_char *aname,u_int *osverp,int s90
 
 extern void akai_vol_info(struct vol_s *vp,u_int ai,int verbose);
 extern void akai_list_vol(struct vol_s *vp,u_char *filtertagp);
+extern void akai_clear_volres(void);
+extern void akai_drop_volres(struct part_s *pp,u_int vi);
+
+extern void akai_free_nameidx(void);
+extern void akai_update_volnameidx(struct part_s *pp,u_int vi);
+extern void akai_drop_filenameidx(struct part_s *pp,u_int vi);
+extern void akai_update_filenameidx(struct vol_s *vp,u_int fi);
+
 extern int akai_read_voldir(struct vol_s *vp);
 extern int akai_write_voldir(struct vol_s *vp,u_int fi);
 extern void akai_copy_structvol(struct vol_s *srcvp,struct vol_s *dstvp);
@@ -641,6 +715,7 @@ extern void akai_fix_partheadmagic(struct part_s *pp);
 extern int akai_check_partheadmagic(struct part_s *pp);
 extern void akai_fix_parttabmagic(struct akai_parttab_s *ptp);
 extern int akai_check_parttabmagic(struct akai_parttab_s *ptp);
+extern void akai_fix_partfat(struct part_s *pp);
 
 extern int akai_scan_floppy(struct disk_s *dp);
 extern int akai_scan_harddisk9(struct disk_s *dp);
@@ -0,0 +1,1001 @@
+/*
+* Copyright (C) 2008-2022 Klaus Michael Indlekofer. All rights reserved.
+*
+* m.indlekofer@gmx.de
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*/
+
+
+
+#include "commoninclude.h"
+#include "akaiutil.h"
+#include "akaiutil_cat.h"
+
+
+
+int akai_cat_enable=0; /* use catalog files */
+
+static struct akai_cat_s akai_cat[DISK_NUM_MAX];
+static u_int akai_cat_num=0;
+
+
+
+/* FNV-1a checksum */
+#define AKAI_CAT_SUMINIT	0x811c9dc5
+static u_int
+akai_cat_sum(u_int sum,u_char *p,u_int n)
+{
+
+	while (n>0){
+		sum^=(u_int)*p++;
+		sum*=0x01000193;
+		n--;
+	}
+	return sum;
+}
+
+/* fields of catalog file records: n bytes in little-endian byte order */
+static void
+akai_cat_put(u_char *p,U_INT64 v,u_int n)
+{
+	u_int i;
+
+	for (i=0;i<n;i++){
+		p[i]=(u_char)(0xff&v);
+		v>>=8;
+	}
+}
+
+static U_INT64
+akai_cat_get(u_char *p,u_int n)
+{
+	U_INT64 v;
+
+	v=0;
+	while (n>0){
+		n--;
+		v=(v<<8)|p[n];
+	}
+	return v;
+}
+
+/* Note: f must be an array */
+#define AKAI_CAT_PUT(f,v)	akai_cat_put((f),(U_INT64)(v),sizeof(f))
+#define AKAI_CAT_GET(f)		akai_cat_get((f),sizeof(f))
+
+/* modification time in nanoseconds if available */
+#if defined(__linux__)
+#define AKAI_CAT_MTIME_NSEC(st)	((INT64)(st).st_mtim.tv_nsec)
+#elif defined(__APPLE__)
+#define AKAI_CAT_MTIME_NSEC(st)	((INT64)(st).st_mtimespec.tv_nsec)
+#endif
+
+/* key of disk-file: size and modification time */
+/* returns 0 if OK, 1 if not a regular file, -1 if error */
+static int
+akai_cat_key(int fd,OFF64_T *fsizep,INT64 *mtimep,int *keyvalidp)
+{
+	struct stat st;
+
+	if (fstat(fd,&st)<0){
+		PERROR("fstat");
+		return -1;
+	}
+	if ((st.st_mode&S_IFMT)!=S_IFREG){
+		return 1;
+	}
+	*fsizep=(OFF64_T)st.st_size;
+#ifdef AKAI_CAT_MTIME_NSEC
+	*mtimep=((INT64)st.st_mtime)*1000000000+AKAI_CAT_MTIME_NSEC(st);
+	*keyvalidp=1;
+#else
+	*mtimep=(INT64)st.st_mtime;
+	/* Note: modification within the same second could go unnoticed (time resolution of mtime) */
+	/*       => key of recently modified disk-file is not valid */
+	*keyvalidp=((INT64)st.st_mtime<((INT64)time(NULL)-1));
+#endif
+	return 0;
+}
+
+static void
+akai_cat_free(struct akai_cat_s *cp)
+{
+	u_int i;
+
+	if (cp->vol!=NULL){
+		for (i=0;i<cp->volnum;i++){
+			if (cp->vol[i].dir!=NULL){
+				free(cp->vol[i].dir);
+			}
+		}
+		free(cp->vol);
+	}
+	cp->vol=NULL;
+	cp->volnum=0;
+	cp->volmax=0;
+	if (cp->blk!=NULL){
+		free(cp->blk);
+	}
+	cp->blk=NULL;
+	cp->blknum=0;
+	cp->blkvalid=0;
+	if (cp->part!=NULL){
+		free(cp->part);
+	}
+	cp->part=NULL;
+	cp->partnum=0;
+	cp->disknum=0;
+}
+
+static void
+akai_cat_delvol(struct akai_cat_s *cp,u_int i)
+{
+
+	if (i>=cp->volnum){
+		return;
+	}
+	if (cp->vol[i].dir!=NULL){
+		free(cp->vol[i].dir);
+	}
+	cp->volnum--;
+	if (i<cp->volnum){
+		/* move last entry */
+		bcopy(&cp->vol[cp->volnum],&cp->vol[i],sizeof(struct akai_cat_vol_s));
+	}
+	cp->blkvalid=0;
+	cp->modified=1;
+}
+
+static void
+akai_cat_delvols(struct akai_cat_s *cp)
+{
+
+	while (cp->volnum>0){
+		akai_cat_delvol(cp,cp->volnum-1);
+	}
+}
+
+/* find catalog of disk */
+static struct akai_cat_s *
+akai_cat_find(struct disk_s *dp)
+{
+	u_int i;
+
+	if (dp==NULL){
+		return NULL;
+	}
+	for (i=0;i<akai_cat_num;i++){
+		if ((dp->fd==akai_cat[i].fd)
+			&&(dp->index>=akai_cat[i].dstart)&&(dp->index<(akai_cat[i].dstart+akai_cat[i].dnum))){
+			return &akai_cat[i];
+		}
+	}
+	return NULL;
+}
+
+/* find catalog entry of partition */
+static int
+akai_cat_findpart(struct akai_cat_s *cp,struct part_s *pp)
+{
+	u_int dk;
+	u_int i;
+
+	dk=pp->diskp->index-cp->dstart;
+	for (i=0;i<cp->partnum;i++){
+		if ((cp->part[i].dk==dk)
+			&&(cp->part[i].part.index==pp->index)
+			&&(cp->part[i].part.type==pp->type)
+			&&(cp->part[i].part.bstart==pp->bstart)){
+			return (int)i;
+		}
+	}
+	return -1;
+}
+
+/* number of volume directory blocks, see akai_read_voldir() */
+static u_int
+akai_cat_voldirblks(struct vol_s *vp)
+{
+	u_int imax;
+
+	imax=vp->fimax*sizeof(struct akai_voldir_entry_s);
+	imax=(imax+vp->partp->blksize-1)/vp->partp->blksize; /* round up */
+	return imax;
+}
+
+/* find catalog entry of volume directory */
+static int
+akai_cat_findvol(struct akai_cat_s *cp,u_int cpi,struct vol_s *vp,u_int imax)
+{
+	u_int i;
+
+	for (i=0;i<cp->volnum;i++){
+		if ((cp->vol[i].cpi==cpi)
+			&&(cp->vol[i].index==vp->index)
+			&&(cp->vol[i].type==vp->type)
+			&&(cp->vol[i].fimax==vp->fimax)
+			&&(cp->vol[i].dirsize==imax*vp->partp->blksize)
+			&&(memcmp(cp->vol[i].dirblk,vp->dirblk,imax*sizeof(u_int))==0)){
+			return (int)i;
+		}
+	}
+	return -1;
+}
+
+
+
+/* load catalog file */
+static int
+akai_cat_load(struct akai_cat_s *cp,OFF64_T fsize,INT64 mtime,int keyvalid)
+{
+	FILE *fp;
+	struct akai_cat_headrec_s head;
+	struct akai_cat_diskrec_s diskrec;
+	struct akai_cat_partrec_s partrec;
+	struct akai_cat_volrec_s volrec;
+	struct akai_cat_disk_s *cdp;
+	struct part_s *pp;
+	struct akai_cat_vol_s *cvp;
+	u_int disknum,partnum,volnum;
+	u_int sum;
+	u_int i,j;
+
+	if ((fp=fopen(cp->name,"rb"))==NULL){
+		return -1; /* no catalog file yet */
+	}
+
+	if ((fread(&head,sizeof(struct akai_cat_headrec_s),1,fp)!=1)
+		||(strncmp(head.magic,AKAI_CAT_MAGIC,sizeof(head.magic))!=0)
+		||(AKAI_CAT_GET(head.version)!=AKAI_CAT_VERSION)){
+		goto akai_cat_load_invalid;
+	}
+	disknum=(u_int)AKAI_CAT_GET(head.disknum);
+	partnum=(u_int)AKAI_CAT_GET(head.partnum);
+	volnum=(u_int)AKAI_CAT_GET(head.volnum);
+	if ((disknum>PSEUDODISK_NUM_MAX)||(partnum>PART_NUM_MAX)){
+		goto akai_cat_load_invalid;
+	}
+
+	sum=AKAI_CAT_SUMINIT;
+	for (i=0;i<disknum;i++){
+		if (fread(&diskrec,sizeof(struct akai_cat_diskrec_s),1,fp)!=1){
+			goto akai_cat_load_invalid;
+		}
+		sum=akai_cat_sum(sum,(u_char *)&diskrec,sizeof(struct akai_cat_diskrec_s));
+		cdp=&cp->disk[i];
+		cdp->startoff=(OFF64_T)AKAI_CAT_GET(diskrec.startoff);
+		cdp->totsize=(u_int)AKAI_CAT_GET(diskrec.totsize);
+		cdp->type=(u_int)AKAI_CAT_GET(diskrec.type);
+		cdp->blksize=(u_int)AKAI_CAT_GET(diskrec.blksize);
+		cdp->bsize=(u_int)AKAI_CAT_GET(diskrec.bsize);
+		cp->disknum=i+1;
+	}
+
+	if (partnum>0){
+		cp->part=(struct akai_cat_part_s *)malloc(partnum*sizeof(struct akai_cat_part_s));
+		if (cp->part==NULL){
+			goto akai_cat_load_invalid;
+		}
+		for (i=0;i<partnum;i++){
+			if (fread(&partrec,sizeof(struct akai_cat_partrec_s),1,fp)!=1){
+				goto akai_cat_load_invalid;
+			}
+			sum=akai_cat_sum(sum,(u_char *)&partrec,sizeof(struct akai_cat_partrec_s));
+			cp->part[i].dk=(u_int)AKAI_CAT_GET(partrec.dk);
+			cp->part[i].headsum=(u_int)AKAI_CAT_GET(partrec.headsum);
+			pp=&cp->part[i].part;
+			bzero(pp,sizeof(struct part_s));
+			pp->diskp=NULL; /* Note: must be fixed when copied into part[] */
+			pp->valid=(int)partrec.valid;
+			pp->type=(u_int)AKAI_CAT_GET(partrec.type);
+			pp->index=(u_int)AKAI_CAT_GET(partrec.index);
+			pp->blksize=(u_int)AKAI_CAT_GET(partrec.blksize);
+			pp->bstart=(u_int)AKAI_CAT_GET(partrec.bstart);
+			pp->bsize=(u_int)AKAI_CAT_GET(partrec.bsize);
+			pp->csize=(u_int)AKAI_CAT_GET(partrec.csize);
+			pp->bsyssize=(u_int)AKAI_CAT_GET(partrec.bsyssize);
+			pp->bfree=(u_int)AKAI_CAT_GET(partrec.bfree);
+			pp->bbad=(u_int)AKAI_CAT_GET(partrec.bbad);
+			pp->volnummax=(u_int)AKAI_CAT_GET(partrec.volnummax);
+			pp->letter=(char)partrec.letter;
+			bcopy(&partrec.head,&pp->head,sizeof(union akai_head_u));
+			akai_fix_partfat(pp);
+			cp->partnum=i+1;
+		}
+	}
+
+	if (volnum>0){
+		cp->vol=(struct akai_cat_vol_s *)malloc(volnum*sizeof(struct akai_cat_vol_s));
+		if (cp->vol==NULL){
+			goto akai_cat_load_invalid;
+		}
+		cp->volmax=volnum;
+		for (i=0;i<volnum;i++){
+			if (fread(&volrec,sizeof(struct akai_cat_volrec_s),1,fp)!=1){
+				goto akai_cat_load_invalid;
+			}
+			sum=akai_cat_sum(sum,(u_char *)&volrec,sizeof(struct akai_cat_volrec_s));
+			cvp=&cp->vol[i];
+			cvp->cpi=(u_int)AKAI_CAT_GET(volrec.cpi);
+			cvp->index=(u_int)AKAI_CAT_GET(volrec.index);
+			cvp->type=(u_int)AKAI_CAT_GET(volrec.type);
+			cvp->fimax=(u_int)AKAI_CAT_GET(volrec.fimax);
+			cvp->dirsize=(u_int)AKAI_CAT_GET(volrec.dirsize);
+			for (j=0;j<VOL_DIRBLKS;j++){
+				cvp->dirblk[j]=(u_int)AKAI_CAT_GET(volrec.dirblk[j]);
+			}
+			cvp->dir=NULL;
+			cp->volnum=i+1;
+			if ((cvp->cpi>=cp->partnum)
+				||(cvp->dirsize==0)||(cvp->dirsize>sizeof(union akai_voldir_u))){
+				goto akai_cat_load_invalid;
+			}
+			if ((cvp->dir=(u_char *)malloc(cvp->dirsize))==NULL){
+				goto akai_cat_load_invalid;
+			}
+			if (fread(cvp->dir,1,cvp->dirsize,fp)!=cvp->dirsize){
+				goto akai_cat_load_invalid;
+			}
+			sum=akai_cat_sum(sum,cvp->dir,cvp->dirsize);
+		}
+	}
+
+	if (sum!=(u_int)AKAI_CAT_GET(head.sum)){
+		goto akai_cat_load_invalid;
+	}
+	fclose(fp);
+
+	/* check key */
+	cp->loaded=keyvalid&&(AKAI_CAT_GET(head.keyvalid)!=0)
+		&&((OFF64_T)AKAI_CAT_GET(head.fsize)==fsize)&&((INT64)AKAI_CAT_GET(head.mtime)==mtime)
+		&&(disknum==cp->dnum);
+	return 0;
+
+akai_cat_load_invalid:
+	fclose(fp);
+	PRINTF_ERR("catalog \"%s\" is invalid, ignored\n",cp->name);
+	akai_cat_free(cp);
+	return -1;
+}
+
+/* open catalog for disks dstart...dstart+dnum-1 of disk-file */
+/* returns 0 if OK, 1 if no catalog possible, -1 if error */
+int
+akai_cat_open(char *name,int fd,u_int dstart,u_int dnum)
+{
+#ifndef _VISUALCPP
+	static char pathbuf[PATH_MAX+1]; /* +1 for '\0' */
+#endif /* !_VISUALCPP */
+	struct akai_cat_s *cp;
+	OFF64_T fsize;
+	INT64 mtime;
+	int keyvalid;
+	int ret;
+
+	if ((name==NULL)||(fd<0)||(dnum==0)||(dnum>PSEUDODISK_NUM_MAX)){
+		return -1;
+	}
+	if (akai_cat_num>=DISK_NUM_MAX){
+		return -1;
+	}
+	if ((ret=akai_cat_key(fd,&fsize,&mtime,&keyvalid))!=0){
+		return ret; /* e.g. device */
+	}
+
+	cp=&akai_cat[akai_cat_num];
+	bzero(cp,sizeof(struct akai_cat_s));
+	/* Note: absolute path, since local directory may change (see "lcd") */
+#ifdef _VISUALCPP
+	if (_fullpath(cp->name,name,AKAI_CAT_NAMELEN+1)==NULL){
+		PRINTF_ERR("catalog name too long\n");
+		return -1;
+	}
+#else /* !_VISUALCPP */
+	if (realpath(name,pathbuf)==NULL){
+		PERROR("realpath");
+		return -1;
+	}
+	if (strlen(pathbuf)>AKAI_CAT_NAMELEN){
+		PRINTF_ERR("catalog name too long\n");
+		return -1;
+	}
+	strcpy(cp->name,pathbuf);
+#endif /* !_VISUALCPP */
+	if (strlen(cp->name)+strlen(AKAI_CAT_FNAMEEND)>AKAI_CAT_NAMELEN){
+		PRINTF_ERR("catalog name too long\n");
+		return -1;
+	}
+	strcat(cp->name,AKAI_CAT_FNAMEEND);
+	cp->fd=fd;
+	cp->dstart=dstart;
+	cp->dnum=dnum;
+
+	akai_cat_load(cp,fsize,mtime,keyvalid); /* Note: ignore error, new catalog */
+
+	akai_cat_num++;
+	return 0;
+}
+
+/* save and free all catalogs */
+void
+akai_cat_closeall(void)
+{
+	u_int i;
+
+	struct akai_cat_s *cp;
+	OFF64_T fsize;
+	INT64 mtime;
+	int keyvalid;
+
+	/* Note: disk-files must have been written back already */
+	akai_cat_update();
+	for (i=0;i<akai_cat_num;i++){
+		cp=&akai_cat[i];
+		if (!cp->synced){
+			akai_cat_free(cp);
+			continue;
+		}
+		if (cp->untracked){
+			/* partitions might be changed, rescan next time */
+			akai_cat_delvols(cp);
+			keyvalid=0;
+		}else if (akai_cat_key(cp->fd,&fsize,&mtime,&keyvalid)!=0){
+			keyvalid=0;
+		}
+		if (!keyvalid){
+			if (cp->keyvalid){
+				cp->keyvalid=0;
+				cp->modified=1;
+			}
+		}else if ((!cp->keyvalid)||(fsize!=cp->fsize)||(mtime!=cp->mtime)){
+			/* modifications in this session are in catalog */
+			cp->keyvalid=1;
+			cp->fsize=fsize;
+			cp->mtime=mtime;
+			cp->modified=1;
+		}
+		if (cp->modified){
+			akai_cat_save(cp); /* Note: ignore error */
+		}
+		akai_cat_free(cp);
+	}
+	akai_cat_num=0;
+}
+
+/* write catalog file */
+int
+akai_cat_save(struct akai_cat_s *cp)
+{
+	static char tmpname[AKAI_CAT_NAMELEN+4+1]; /* +4 for ".tmp", +1 for '\0' */
+	FILE *fp;
+	struct akai_cat_headrec_s head;
+	struct akai_cat_diskrec_s diskrec;
+	struct akai_cat_partrec_s partrec;
+	struct akai_cat_volrec_s volrec;
+	struct akai_cat_disk_s *cdp;
+	struct part_s *pp;
+	struct akai_cat_vol_s *cvp;
+	u_int sum;
+	u_int i,j;
+
+	if ((cp==NULL)||(!cp->synced)){
+		return -1;
+	}
+
+	bzero(&head,sizeof(struct akai_cat_headrec_s));
+	strncpy(head.magic,AKAI_CAT_MAGIC,sizeof(head.magic));
+	AKAI_CAT_PUT(head.version,AKAI_CAT_VERSION);
+	AKAI_CAT_PUT(head.disknum,cp->disknum);
+	AKAI_CAT_PUT(head.partnum,cp->partnum);
+	AKAI_CAT_PUT(head.volnum,cp->volnum);
+	AKAI_CAT_PUT(head.keyvalid,cp->keyvalid);
+	AKAI_CAT_PUT(head.fsize,cp->fsize);
+	AKAI_CAT_PUT(head.mtime,cp->mtime);
+	/* Note: checksum is set after records have been written */
+
+	/* write to temporary file first, then replace catalog file */
+	strcpy(tmpname,cp->name);
+	strcat(tmpname,".tmp");
+	if ((fp=fopen(tmpname,"wb"))==NULL){
+		goto akai_cat_save_error;
+	}
+	if (fwrite(&head,sizeof(struct akai_cat_headrec_s),1,fp)!=1){
+		goto akai_cat_save_close;
+	}
+
+	sum=AKAI_CAT_SUMINIT;
+	for (i=0;i<cp->disknum;i++){
+		cdp=&cp->disk[i];
+		bzero(&diskrec,sizeof(struct akai_cat_diskrec_s));
+		AKAI_CAT_PUT(diskrec.startoff,cdp->startoff);
+		AKAI_CAT_PUT(diskrec.totsize,cdp->totsize);
+		AKAI_CAT_PUT(diskrec.type,cdp->type);
+		AKAI_CAT_PUT(diskrec.blksize,cdp->blksize);
+		AKAI_CAT_PUT(diskrec.bsize,cdp->bsize);
+		if (fwrite(&diskrec,sizeof(struct akai_cat_diskrec_s),1,fp)!=1){
+			goto akai_cat_save_close;
+		}
+		sum=akai_cat_sum(sum,(u_char *)&diskrec,sizeof(struct akai_cat_diskrec_s));
+	}
+
+	for (i=0;i<cp->partnum;i++){
+		pp=&cp->part[i].part;
+		bzero(&partrec,sizeof(struct akai_cat_partrec_s));
+		AKAI_CAT_PUT(partrec.dk,cp->part[i].dk);
+		AKAI_CAT_PUT(partrec.headsum,cp->part[i].headsum);
+		AKAI_CAT_PUT(partrec.type,pp->type);
+		AKAI_CAT_PUT(partrec.index,pp->index);
+		AKAI_CAT_PUT(partrec.blksize,pp->blksize);
+		AKAI_CAT_PUT(partrec.bstart,pp->bstart);
+		AKAI_CAT_PUT(partrec.bsize,pp->bsize);
+		AKAI_CAT_PUT(partrec.csize,pp->csize);
+		AKAI_CAT_PUT(partrec.bsyssize,pp->bsyssize);
+		AKAI_CAT_PUT(partrec.bfree,pp->bfree);
+		AKAI_CAT_PUT(partrec.bbad,pp->bbad);
+		AKAI_CAT_PUT(partrec.volnummax,pp->volnummax);
+		partrec.valid=(pp->valid)?1:0;
+		partrec.letter=(u_char)pp->letter;
+		bcopy(&pp->head,&partrec.head,sizeof(union akai_head_u));
+		if (fwrite(&partrec,sizeof(struct akai_cat_partrec_s),1,fp)!=1){
+			goto akai_cat_save_close;
+		}
+		sum=akai_cat_sum(sum,(u_char *)&partrec,sizeof(struct akai_cat_partrec_s));
+	}
+
+	for (i=0;i<cp->volnum;i++){
+		cvp=&cp->vol[i];
+		bzero(&volrec,sizeof(struct akai_cat_volrec_s));
+		AKAI_CAT_PUT(volrec.cpi,cvp->cpi);
+		AKAI_CAT_PUT(volrec.index,cvp->index);
+		AKAI_CAT_PUT(volrec.type,cvp->type);
+		AKAI_CAT_PUT(volrec.fimax,cvp->fimax);
+		AKAI_CAT_PUT(volrec.dirsize,cvp->dirsize);
+		for (j=0;j<VOL_DIRBLKS;j++){
+			AKAI_CAT_PUT(volrec.dirblk[j],cvp->dirblk[j]);
+		}
+		if ((fwrite(&volrec,sizeof(struct akai_cat_volrec_s),1,fp)!=1)
+			||(fwrite(cvp->dir,1,cvp->dirsize,fp)!=cvp->dirsize)){
+			goto akai_cat_save_close;
+		}
+		sum=akai_cat_sum(sum,(u_char *)&volrec,sizeof(struct akai_cat_volrec_s));
+		sum=akai_cat_sum(sum,cvp->dir,cvp->dirsize);
+	}
+
+	/* header with checksum */
+	AKAI_CAT_PUT(head.sum,sum);
+	if ((fseek(fp,0,SEEK_SET)!=0)
+		||(fwrite(&head,sizeof(struct akai_cat_headrec_s),1,fp)!=1)){
+		goto akai_cat_save_close;
+	}
+	if (fclose(fp)!=0){
+		goto akai_cat_save_error;
+	}
+#ifdef _VISUALCPP
+	remove(cp->name); /* Note: rename() does not replace existing file */
+#endif /* _VISUALCPP */
+	if (rename(tmpname,cp->name)<0){
+		goto akai_cat_save_error;
+	}
+	cp->modified=0;
+	return 0;
+
+akai_cat_save_close:
+	fclose(fp);
+akai_cat_save_error:
+	PRINTF_ERR("cannot write catalog \"%s\"\n",cp->name);
+	remove(tmpname);
+	return -1;
+}
+
+void
+akai_cat_list(void)
+{
+	u_int i;
+
+	if (akai_cat_num==0){
+		PRINTF_OUT("no catalogs\n");
+		return;
+	}
+	PRINTF_OUT("disks      parts  vols  state     catalog\n");
+	PRINTF_OUT("------------------------------------------------------------\n");
+	for (i=0;i<akai_cat_num;i++){
+		PRINTF_OUT("%3u-%-3u    %5u %5u  %-8s  %s\n",
+			akai_cat[i].dstart,akai_cat[i].dstart+akai_cat[i].dnum-1,
+			akai_cat[i].partnum,
+			akai_cat[i].volnum,
+			akai_cat[i].modified?"modified":"saved",
+			akai_cat[i].name);
+	}
+	PRINTF_OUT("------------------------------------------------------------\n");
+}
+
+
+
+/* take scan result of disk from catalog */
+/* returns number of partitions, or -1 if disk must be scanned */
+int
+akai_cat_scan_disk(struct disk_s *dp)
+{
+	struct akai_cat_s *cp;
+	struct akai_cat_disk_s *cdp;
+	u_int dk;
+	u_int i,n;
+
+	if ((cp=akai_cat_find(dp))==NULL){
+		return -1;
+	}
+	if (!cp->loaded){
+		return -1;
+	}
+	dk=dp->index-cp->dstart;
+	if (dk>=cp->disknum){
+		return -1;
+	}
+	cdp=&cp->disk[dk];
+	if ((cdp->startoff!=dp->startoff)||(cdp->totsize!=dp->totsize)){
+		return -1;
+	}
+
+	dp->type=cdp->type;
+	dp->blksize=cdp->blksize;
+	dp->bsize=cdp->bsize;
+	n=0;
+	for (i=0;(i<cp->partnum)&&(part_num<PART_NUM_MAX);i++){
+		if (cp->part[i].dk!=dk){
+			continue;
+		}
+		bcopy(&cp->part[i].part,&part[part_num],sizeof(struct part_s));
+		part[part_num].diskp=dp;
+		akai_fix_partfat(&part[part_num]);
+		part_num++;
+		n++;
+	}
+	return (int)n;
+}
+
+/* take partitions and header checksums from part[] */
+/* Note: before rescan of disks, and before save */
+void
+akai_cat_update(void)
+{
+	struct akai_cat_s *cp;
+	u_int k;
+	int cpi;
+	u_int sum;
+
+	for (k=0;k<part_num;k++){
+		if ((cp=akai_cat_find(part[k].diskp))==NULL){
+			continue;
+		}
+		if (!cp->synced){
+			continue;
+		}
+		if ((cpi=akai_cat_findpart(cp,&part[k]))<0){
+			continue;
+		}
+		sum=akai_cat_sum(AKAI_CAT_SUMINIT,(u_char *)&part[k].head,sizeof(union akai_head_u));
+		if (sum!=cp->part[cpi].headsum){
+			cp->part[cpi].headsum=sum;
+			cp->modified=1;
+		}
+		if (memcmp(&part[k],&cp->part[cpi].part,sizeof(struct part_s))!=0){
+			bcopy(&part[k],&cp->part[cpi].part,sizeof(struct part_s));
+			cp->modified=1;
+		}
+	}
+}
+
+/* take partitions from part[] after scan of disks */
+/* Note: volume directories are kept for partitions with unchanged header checksum */
+/*       if all writes since last scan have been tracked by catalog */
+/* Note: renaming a file etc. does not change partition header */
+/*       => if disk-file has been modified outside, all volume directories are dropped */
+void
+akai_cat_sync(void)
+{
+	struct akai_cat_s *cp;
+	struct akai_cat_part_s *newpart;
+	u_int newpartnum;
+	u_int i,j,k;
+	int cpi;
+
+	for (i=0;i<akai_cat_num;i++){
+		cp=&akai_cat[i];
+
+		/* count partitions */
+		newpartnum=0;
+		for (k=0;k<part_num;k++){
+			if (akai_cat_find(part[k].diskp)==cp){
+				newpartnum++;
+			}
+		}
+		newpart=NULL;
+		if (newpartnum>0){
+			newpart=(struct akai_cat_part_s *)malloc(newpartnum*sizeof(struct akai_cat_part_s));
+			if (newpart==NULL){
+				PRINTF_ERR("cannot allocate memory for catalog\n");
+				akai_cat_free(cp);
+				cp->synced=0; /* XXX catalog is lost for this session */
+				cp->loaded=0;
+				continue;
+			}
+		}
+		for (k=0,j=0;k<part_num;k++){
+			if (akai_cat_find(part[k].diskp)!=cp){
+				continue;
+			}
+			newpart[j].dk=part[k].diskp->index-cp->dstart;
+			newpart[j].headsum=akai_cat_sum(AKAI_CAT_SUMINIT,(u_char *)&part[k].head,sizeof(union akai_head_u));
+			bcopy(&part[k],&newpart[j].part,sizeof(struct part_s));
+			j++;
+		}
+
+		if (cp->untracked||((!cp->synced)&&(!cp->loaded))){
+			akai_cat_delvols(cp);
+		}
+		/* keep volume directories of unchanged partitions */
+		for (k=0;k<cp->volnum;){
+			cpi=-1;
+			for (j=0;j<newpartnum;j++){
+				if ((newpart[j].dk==cp->part[cp->vol[k].cpi].dk)
+					&&(newpart[j].part.index==cp->part[cp->vol[k].cpi].part.index)
+					&&(newpart[j].part.type==cp->part[cp->vol[k].cpi].part.type)
+					&&(newpart[j].part.bstart==cp->part[cp->vol[k].cpi].part.bstart)){
+					if (newpart[j].headsum==cp->part[cp->vol[k].cpi].headsum){
+						cpi=(int)j;
+					}
+					break;
+				}
+			}
+			if (cpi<0){
+				akai_cat_delvol(cp,k);
+			}else{
+				cp->vol[k].cpi=(u_int)cpi;
+				k++;
+			}
+		}
+		if (cp->part!=NULL){
+			free(cp->part);
+		}
+		cp->part=newpart;
+		cp->partnum=newpartnum;
+		cp->blkvalid=0; /* Note: cpi of volumes might have changed */
+
+		/* disks */
+		cp->disknum=cp->dnum;
+		for (k=0;k<cp->disknum;k++){
+			cp->disk[k].startoff=disk[cp->dstart+k].startoff;
+			cp->disk[k].totsize=disk[cp->dstart+k].totsize;
+			cp->disk[k].type=disk[cp->dstart+k].type;
+			cp->disk[k].blksize=disk[cp->dstart+k].blksize;
+			cp->disk[k].bsize=disk[cp->dstart+k].bsize;
+		}
+
+		/* key */
+		if (akai_cat_key(cp->fd,&cp->fsize,&cp->mtime,&cp->keyvalid)!=0){
+			cp->keyvalid=0;
+		}
+
+		if (!cp->loaded){ /* disks have been scanned? */
+			cp->modified=1;
+		}
+		cp->loaded=0; /* Note: further scans must read disks */
+		cp->synced=1;
+		cp->untracked=0;
+	}
+}
+
+
+
+/* read volume directory from catalog */
+/* returns 0 if OK, -1 if not in catalog */
+int
+akai_cat_get_voldir(struct vol_s *vp)
+{
+	struct akai_cat_s *cp;
+	u_int imax;
+	int cpi,vi;
+
+	if ((cp=akai_cat_find(vp->partp->diskp))==NULL){
+		return -1;
+	}
+	if ((cpi=akai_cat_findpart(cp,vp->partp))<0){
+		return -1;
+	}
+	imax=akai_cat_voldirblks(vp);
+	if ((vi=akai_cat_findvol(cp,(u_int)cpi,vp,imax))<0){
+		return -1;
+	}
+	bcopy(cp->vol[vi].dir,(u_char *)vp->file,cp->vol[vi].dirsize);
+	return 0;
+}
+
+/* store volume directory in catalog */
+void
+akai_cat_put_voldir(struct vol_s *vp)
+{
+	struct akai_cat_s *cp;
+	struct akai_cat_vol_s *cvp;
+	u_int imax;
+	u_int dirsize;
+	int cpi,vi;
+
+	if ((cp=akai_cat_find(vp->partp->diskp))==NULL){
+		return;
+	}
+	if ((cpi=akai_cat_findpart(cp,vp->partp))<0){
+		return;
+	}
+	imax=akai_cat_voldirblks(vp);
+	if ((imax==0)||(imax>VOL_DIRBLKS)){
+		return;
+	}
+	dirsize=imax*vp->partp->blksize;
+
+	if ((vi=akai_cat_findvol(cp,(u_int)cpi,vp,imax))<0){
+		/* new entry */
+		if (cp->volnum>=cp->volmax){
+			cvp=(struct akai_cat_vol_s *)realloc(cp->vol,(cp->volmax+64)*sizeof(struct akai_cat_vol_s));
+			if (cvp==NULL){
+				return; /* XXX not in catalog */
+			}
+			cp->vol=cvp;
+			cp->volmax+=64;
+		}
+		cvp=&cp->vol[cp->volnum];
+		if ((cvp->dir=(u_char *)malloc(dirsize))==NULL){
+			return; /* XXX not in catalog */
+		}
+		cvp->cpi=(u_int)cpi;
+		cvp->index=vp->index;
+		cvp->type=vp->type;
+		cvp->fimax=vp->fimax;
+		bzero(cvp->dirblk,sizeof(cvp->dirblk));
+		bcopy(vp->dirblk,cvp->dirblk,imax*sizeof(u_int));
+		cvp->dirsize=dirsize;
+		cp->volnum++;
+		cp->blkvalid=0;
+	}else{
+		cvp=&cp->vol[vi];
+	}
+	bcopy((u_char *)vp->file,cvp->dir,dirsize);
+	cp->modified=1;
+}
+
+static int
+akai_cat_blkcmp(const void *a,const void *b)
+{
+	const struct akai_cat_blk_s *ap,*bp;
+
+	ap=(const struct akai_cat_blk_s *)a;
+	bp=(const struct akai_cat_blk_s *)b;
+	if (ap->cpi!=bp->cpi){
+		return (ap->cpi<bp->cpi)?-1:1;
+	}
+	if (ap->blk!=bp->blk){
+		return (ap->blk<bp->blk)?-1:1;
+	}
+	return 0;
+}
+
+/* build index of volume directory blocks if necessary */
+/* returns 0 if OK, -1 if no index */
+static int
+akai_cat_blkindex(struct akai_cat_s *cp)
+{
+	struct akai_cat_blk_s *bp;
+	u_int n;
+	u_int i,j,imax;
+
+	if (cp->blkvalid){
+		return 0;
+	}
+	if (cp->blk!=NULL){
+		free(cp->blk);
+	}
+	cp->blk=NULL;
+	cp->blknum=0;
+	n=0;
+	for (i=0;i<cp->volnum;i++){
+		n+=cp->vol[i].dirsize/cp->part[cp->vol[i].cpi].part.blksize;
+	}
+	if (n>0){
+		if ((bp=(struct akai_cat_blk_s *)malloc(n*sizeof(struct akai_cat_blk_s)))==NULL){
+			return -1;
+		}
+		cp->blk=bp;
+		for (i=0;i<cp->volnum;i++){
+			imax=cp->vol[i].dirsize/cp->part[cp->vol[i].cpi].part.blksize;
+			for (j=0;j<imax;j++){
+				bp->cpi=cp->vol[i].cpi;
+				bp->blk=cp->vol[i].dirblk[j];
+				bp++;
+			}
+		}
+		qsort(cp->blk,n,sizeof(struct akai_cat_blk_s),akai_cat_blkcmp);
+		cp->blknum=n;
+	}
+	cp->blkvalid=1;
+	return 0;
+}
+
+/* blocks of partition have been written: drop affected volume directories from catalog */
+/* Note: called for every write, index of volume directory blocks avoids search through all volumes */
+void
+akai_cat_write_blks(struct part_s *pp,u_int bstart,u_int bsize)
+{
+	struct akai_cat_s *cp;
+	u_int i,j,imax;
+	u_int lo,hi,mid;
+	int cpi;
+
+	if ((cp=akai_cat_find(pp->diskp))==NULL){
+		return;
+	}
+	if ((cpi=akai_cat_findpart(cp,pp))<0){
+		cp->untracked=1; /* e.g. wipe of disk */
+		return;
+	}
+	if (cp->volnum==0){
+		return;
+	}
+	if (akai_cat_blkindex(cp)==0){
+		/* find first index entry >= (cpi,bstart) */
+		lo=0;
+		hi=cp->blknum;
+		while (lo<hi){
+			mid=(lo+hi)/2;
+			if ((cp->blk[mid].cpi<(u_int)cpi)
+				||((cp->blk[mid].cpi==(u_int)cpi)&&(cp->blk[mid].blk<bstart))){
+				lo=mid+1;
+			}else{
+				hi=mid;
+			}
+		}
+		if ((lo>=cp->blknum)||(cp->blk[lo].cpi!=(u_int)cpi)||(cp->blk[lo].blk>=(bstart+bsize))){
+			return; /* no volume directory affected */
+		}
+	} /* Note: else: no index, check all volumes */
+	for (i=0;i<cp->volnum;){
+		if (cp->vol[i].cpi==(u_int)cpi){
+			imax=cp->vol[i].dirsize/pp->blksize;
+			for (j=0;j<imax;j++){
+				if ((cp->vol[i].dirblk[j]>=bstart)&&(cp->vol[i].dirblk[j]<(bstart+bsize))){
+					break;
+				}
+			}
+			if (j<imax){
+				akai_cat_delvol(cp,i);
+				continue;
+			}
+		}
+		i++;
+	}
+}
+/* disk has been written without partition */
+void
+akai_cat_write_disk(struct disk_s *dp)
+{
+	struct akai_cat_s *cp;
+
+	if ((cp=akai_cat_find(dp))!=NULL){
+		cp->untracked=1;
+	}
+}
+
+
+
+/* EOF */
@@ -0,0 +1,182 @@
+#ifndef __AKAIUTIL_CAT_H
+#define __AKAIUTIL_CAT_H
+/*
+* Copyright (C) 2008-2022 Klaus Michael Indlekofer. All rights reserved.
+*
+* m.indlekofer@gmx.de
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*/
+
+
+
+#include "commoninclude.h"
+#include "akaiutil.h"
+
+
+
+/* catalog files for disk-files */
+
+/* Note: a catalog file is stored next to its disk-file, it contains the scanned partitions */
+/*       (incl. partition headers) and volume directories of all pseudo-disks of the disk-file */
+/* Note: catalog file consists of records with explicit fields in little-endian byte order */
+/*       (see struct akai_cat_*rec_s), catalog of other version is ignored */
+/* Note: catalog is only valid if size and modification time of disk-file are unchanged, */
+/*       otherwise volume directories are read from disk-file again */
+
+
+
+/* file name ending for catalog file */
+#define AKAI_CAT_FNAMEEND		".akaicat"
+#define AKAI_CAT_NAMELEN		256 /* XXX */
+
+#define AKAI_CAT_MAGIC			"AKAICAT"
+#define AKAI_CAT_VERSION		1
+
+/* catalog file header record */
+struct akai_cat_headrec_s{
+	char magic[8]; /* AKAI_CAT_MAGIC */
+	u_char version[4]; /* AKAI_CAT_VERSION */
+	u_char disknum[4]; /* number of disks */
+	u_char partnum[4]; /* number of partitions */
+	u_char volnum[4]; /* number of volume directories */
+	u_char keyvalid[4]; /* key valid flag */
+	u_char fsize[8]; /* key: size of disk-file in bytes */
+	u_char mtime[8]; /* key: modification time of disk-file */
+	u_char sum[4]; /* checksum of records after header */
+};
+
+/* catalog file disk record */
+struct akai_cat_diskrec_s{
+	u_char startoff[8];
+	u_char totsize[4];
+	u_char type[4];
+	u_char blksize[4];
+	u_char bsize[4];
+};
+
+/* catalog file partition record */
+/* Note: pointers of struct part_s are not stored, FAT is derived from type */
+struct akai_cat_partrec_s{
+	u_char dk[4];
+	u_char headsum[4];
+	u_char type[4];
+	u_char index[4];
+	u_char blksize[4];
+	u_char bstart[4];
+	u_char bsize[4];
+	u_char csize[4];
+	u_char bsyssize[4];
+	u_char bfree[4];
+	u_char bbad[4];
+	u_char volnummax[4];
+	u_char valid;
+	u_char letter;
+	u_char dummy[2];
+	union akai_head_u head; /* as on disk */
+};
+
+/* catalog file volume directory record, followed by volume directory */
+struct akai_cat_volrec_s{
+	u_char cpi[4];
+	u_char index[4];
+	u_char type[4];
+	u_char fimax[4];
+	u_char dirsize[4];
+	u_char dirblk[VOL_DIRBLKS][4];
+};
+
+/* catalog entry for disk */
+struct akai_cat_disk_s{
+	OFF64_T startoff; /* start offset in bytes */
+	u_int totsize; /* size in bytes */
+	u_int type; /* disk type */
+	u_int blksize; /* blocksize in bytes */
+	u_int bsize; /* size in blocks */
+};
+
+/* catalog entry for partition */
+struct akai_cat_part_s{
+	u_int dk; /* index of disk in catalog */
+	u_int headsum; /* checksum of partition header, volume directories are valid for this header */
+	struct part_s part; /* partition as scanned */
+};
+/* Note: pointers in part are invalid, must be fixed when copied into part[] */
+
+/* catalog entry for volume directory */
+struct akai_cat_vol_s{
+	u_int cpi; /* index of partition in catalog */
+	u_int index; /* index in root directory */
+	u_int type; /* volume type */
+	u_int fimax; /* max. file entries */
+	u_int dirblk[VOL_DIRBLKS]; /* directory blocks */
+	u_int dirsize; /* size of volume directory in bytes */
+	u_char *dir; /* volume directory */
+};
+
+/* volume directory block, for index of blocks */
+struct akai_cat_blk_s{
+	u_int cpi; /* index of partition in catalog */
+	u_int blk; /* block in partition */
+};
+
+/* catalog of disk-file */
+struct akai_cat_s{
+	char name[AKAI_CAT_NAMELEN+1]; /* name of catalog file, +1 for '\0' */
+	int fd; /* file descriptor of disk-file */
+	u_int dstart; /* index of first disk in disk[] */
+	u_int dnum; /* number of disks */
+	int loaded; /* loaded catalog matches disk-file, may replace scan of disks */
+	int synced; /* partitions have been taken from part[] */
+	int modified; /* must be saved */
+	int untracked; /* disk-file has been written without partition, volume directories not reliable */
+	int keyvalid; /* key valid flag */
+	OFF64_T fsize; /* key: size of disk-file in bytes */
+	INT64 mtime; /* key: modification time of disk-file */
+	u_int disknum; /* number of disks in catalog */
+	struct akai_cat_disk_s disk[PSEUDODISK_NUM_MAX];
+	u_int partnum; /* number of partitions in catalog */
+	struct akai_cat_part_s *part;
+	u_int volnum; /* number of volume directories in catalog */
+	u_int volmax; /* allocated entries */
+	struct akai_cat_vol_s *vol;
+	int blkvalid; /* index of volume directory blocks is valid */
+	u_int blknum; /* number of entries in index */
+	struct akai_cat_blk_s *blk; /* volume directory blocks of all volumes, sorted by partition and block */
+};
+
+
+
+/* Declarations */
+
+extern int akai_cat_enable;
+
+extern int akai_cat_open(char *name,int fd,u_int dstart,u_int dnum);
+extern void akai_cat_closeall(void);
+extern int akai_cat_save(struct akai_cat_s *cp);
+extern void akai_cat_list(void);
+
+extern int akai_cat_scan_disk(struct disk_s *dp);
+extern void akai_cat_update(void);
+extern void akai_cat_sync(void);
+
+extern int akai_cat_get_voldir(struct vol_s *vp);
+extern void akai_cat_put_voldir(struct vol_s *vp);
+extern void akai_cat_write_blks(struct part_s *pp,u_int bstart,u_int bsize);
+extern void akai_cat_write_disk(struct disk_s *dp);
+
+
+
+#endif /* !__AKAIUTIL_CAT_H */
@@ -1212,9 +1212,58 @@ akai_sample900_getsamplesize(struct file_s *fp)
 
 
 
+#ifdef HOST_LITTLE_ENDIAN
+/* vectorizable kernels for S900 non-compressed sample format */
+/* Note: 16bit little-endian words, loop count is a multiple of AKAI_S900NC_VBLK, */
+/*       buffers must not overlap (RESTRICT), so that the compiler can vectorize the loops at -O2 */
+/* Note: memcpy() for unaligned 16bit words, inlined by the compiler */
+#define AKAI_S900NC_VBLK	16 /* samples per block */
+
+static void
+akai_sample900noncompr_sample2wav_blks(const u_char *RESTRICT sbuf1,const u_char *RESTRICT sbuf2,
+									   u_char *RESTRICT wavbuf1,u_char *RESTRICT wavbuf2,u_int blkcount)
+{
+	size_t i,n;
+	u_short w,v;
+
+	n=((size_t)blkcount)*AKAI_S900NC_VBLK;
+	for (i=0;i<n;i++){
+		memcpy(&w,sbuf1+i*2,2); /* upper 8bit and nibble byte */
+		/* first part */
+		v=(u_short)(w&0xfff0);
+		memcpy(wavbuf1+i*2,&v,2);
+		/* second part */
+		v=(u_short)((sbuf2[i]<<8)|((w<<4)&0x00f0));
+		memcpy(wavbuf2+i*2,&v,2);
+	}
+}
+
+static void
+akai_sample900noncompr_wav2sample_blks(u_char *RESTRICT sbuf1,u_char *RESTRICT sbuf2,
+									   const u_char *RESTRICT wavbuf1,const u_char *RESTRICT wavbuf2,u_int blkcount)
+{
+	size_t i,n;
+	u_short w1,w2,v;
+
+	n=((size_t)blkcount)*AKAI_S900NC_VBLK;
+	for (i=0;i<n;i++){
+		memcpy(&w1,wavbuf1+i*2,2);
+		memcpy(&w2,wavbuf2+i*2,2);
+		/* upper 8bit of first part and nibble byte of both parts */
+		v=(u_short)((w1&0xfff0)|((w2>>4)&0x000f));
+		memcpy(sbuf1+i*2,&v,2);
+		/* upper 8bit of second part */
+		sbuf2[i]=(u_char)(w2>>8);
+	}
+}
+#endif /* HOST_LITTLE_ENDIAN */
+
 void
 akai_sample900noncompr_sample2wav(u_char *sbuf,u_char *wavbuf,u_int samplecountpart)
 {
+	u_char *sbuf2;
+	u_char *wavbuf2;
+	u_char b;
 	u_int i;
 
 	if ((sbuf==NULL)||(wavbuf==NULL)){
@@ -1224,20 +1273,61 @@ akai_sample900noncompr_sample2wav(u_char *sbuf,u_char *wavbuf,u_int samplecountp
 		return;
 	}
 
+	/* second parts */
+	sbuf2=sbuf+samplecountpart*2;
+	wavbuf2=wavbuf+samplecountpart*2;
+
 	/* convert 12bit S900 non-compressed sample format into 16bit WAV sample format */
-	for (i=0;i<samplecountpart;i++){ /* first part */
+	/* Note: both parts in one loop, shared nibble byte is read only once */
+	i=0;
+#ifdef HOST_LITTLE_ENDIAN
+	akai_sample900noncompr_sample2wav_blks(sbuf,sbuf2,wavbuf,wavbuf2,samplecountpart/AKAI_S900NC_VBLK);
+	i=(samplecountpart/AKAI_S900NC_VBLK)*AKAI_S900NC_VBLK;
+	/* rest below */
+#endif
+	for (;i<samplecountpart;i++){
+		b=sbuf[i*2+0];
+		/* first part */
 		wavbuf[i*2+1]=sbuf[i*2+1];
-		wavbuf[i*2+0]=0xf0&sbuf[i*2+0];
+		wavbuf[i*2+0]=0xf0&b;
+		/* second part */
+		wavbuf2[i*2+1]=sbuf2[i];
+		wavbuf2[i*2+0]=0xf0&(b<<4);
+	}
+}
+
+/* convert piece of one part of 12bit S900 non-compressed sample into 16bit WAV sample format */
+/* sbuf1: piece of first part (2 bytes per sample word), always required for nibbles */
+/* sbuf2: piece of second part (1 byte per sample word), NULL for first part */
+void
+akai_sample900noncompr_sample2wavpart(u_char *sbuf1,u_char *sbuf2,u_char *wavbuf,u_int samplecount)
+{
+	u_int i;
+
+	if ((sbuf1==NULL)||(wavbuf==NULL)){
+		return;
 	}
-	for (i=0;i<samplecountpart;i++){ /* second part */
-		wavbuf[samplecountpart*2+i*2+1]=sbuf[samplecountpart*2+i];
-		wavbuf[samplecountpart*2+i*2+0]=0xf0&(sbuf[i*2+0]<<4);
+
+	if (sbuf2==NULL){
+		/* first part */
+		for (i=0;i<samplecount;i++){
+			wavbuf[i*2+1]=sbuf1[i*2+1];
+			wavbuf[i*2+0]=0xf0&sbuf1[i*2+0];
+		}
+	}else{
+		/* second part */
+		for (i=0;i<samplecount;i++){
+			wavbuf[i*2+1]=sbuf2[i];
+			wavbuf[i*2+0]=0xf0&(sbuf1[i*2+0]<<4);
+		}
 	}
 }
 
 void
 akai_sample900noncompr_wav2sample(u_char *sbuf,u_char *wavbuf,u_int samplecountpart)
 {
+	u_char *sbuf2;
+	u_char *wavbuf2;
 	u_int i;
 
 	if ((sbuf==NULL)||(wavbuf==NULL)){
@@ -1247,14 +1337,22 @@ akai_sample900noncompr_wav2sample(u_char *sbuf,u_char *wavbuf,u_int samplecountp
 		return;
 	}
 
+	/* second parts */
+	sbuf2=sbuf+samplecountpart*2;
+	wavbuf2=wavbuf+samplecountpart*2;
+
 	/* convert 16bit WAV sample format into 12bit S900 non-compressed sample format */
-	for (i=0;i<samplecountpart;i++){ /* first part */
-		sbuf[i*2+1]=wavbuf[i*2+1];
-		sbuf[i*2+0]=0xf0&wavbuf[i*2+0];
-	}
-	for (i=0;i<samplecountpart;i++){ /* second part */
-		sbuf[samplecountpart*2+i]=wavbuf[samplecountpart*2+i*2+1];
-		sbuf[i*2+0]|=0x0f&(wavbuf[samplecountpart*2+i*2+0]>>4);
+	/* Note: both parts in one loop, shared nibble byte is written only once */
+	i=0;
+#ifdef HOST_LITTLE_ENDIAN
+	akai_sample900noncompr_wav2sample_blks(sbuf,sbuf2,wavbuf,wavbuf2,samplecountpart/AKAI_S900NC_VBLK);
+	i=(samplecountpart/AKAI_S900NC_VBLK)*AKAI_S900NC_VBLK;
+	/* rest below */
+#endif
+	for (;i<samplecountpart;i++){
+		sbuf[i*2+1]=wavbuf[i*2+1]; /* first part */
+		sbuf[i*2+0]=(0xf0&wavbuf[i*2+0])|(0x0f&(wavbuf2[i*2+0]>>4)); /* both parts */
+		sbuf2[i]=wavbuf2[i*2+1]; /* second part */
 	}
 }
 
@@ -1287,101 +1385,431 @@ akai_sample900compr_getbits(u_char *buf,u_int bitpos,u_int bitnum)
 	return val;
 }
 
+void
+akai_sample900compr_bitrd_init(struct akai_sample900compr_bitrd_s *rp,u_char *buf,u_int bufsiz)
+{
+
+	if (rp==NULL){
+		return;
+	}
+
+	rp->buf=buf;
+	rp->bufsiz=(buf!=NULL)?bufsiz:0;
+	rp->bytepos=0;
+	rp->acc=0;
+	rp->accbits=0;
+	rp->fp=NULL;
+	rp->fbegin=0;
+	rp->fpos=0;
+	rp->fend=0;
+	rp->bufmax=rp->bufsiz;
+	rp->err=0;
+	akai_sample900compr_bitrd_fill(rp);
+}
+
+/* bit reader for bytes begin...end-1 of file */
+/* Note: buf (bufmax bytes) is used as window, refilled via akai_read_file() */
+void
+akai_sample900compr_bitrd_initfile(struct akai_sample900compr_bitrd_s *rp,struct file_s *fp,u_int begin,u_int end,u_char *buf,u_int bufmax)
+{
+
+	if (rp==NULL){
+		return;
+	}
+
+	rp->buf=buf;
+	rp->bufsiz=0; /* empty so far */
+	rp->bytepos=0;
+	rp->acc=0;
+	rp->accbits=0;
+	rp->fp=fp;
+	rp->fbegin=begin;
+	rp->fpos=begin;
+	rp->fend=(end>begin)?end:begin;
+	rp->bufmax=(buf!=NULL)?bufmax:0;
+	rp->err=0;
+	akai_sample900compr_bitrd_fill(rp);
+}
+
+/* load whole bytes into accumulator (at least 57 valid bits afterwards) */
+/* Note: behind end of buffer (or file), zero bits are supplied */
+void
+akai_sample900compr_bitrd_fill(struct akai_sample900compr_bitrd_s *rp)
+{
+	u_int b;
+	u_int n;
+
+	if ((rp->accbits<=32)&&(rp->bytepos+4<=rp->bufsiz)){
+		/* 4 bytes at once */
+		b=(((u_int)rp->buf[rp->bytepos+0])<<24)
+			|(((u_int)rp->buf[rp->bytepos+1])<<16)
+			|(((u_int)rp->buf[rp->bytepos+2])<<8)
+			|((u_int)rp->buf[rp->bytepos+3]);
+		rp->bytepos+=4;
+		rp->acc|=((U_INT64)b)<<(32-rp->accbits);
+		rp->accbits+=32;
+	}
+	while (rp->accbits<=56){
+		if ((rp->bytepos>=rp->bufsiz)&&(rp->fp!=NULL)&&(rp->fpos<rp->fend)&&(rp->bufmax>0)){
+			/* refill buffer from file */
+			n=rp->fend-rp->fpos;
+			if (n>rp->bufmax){
+				n=rp->bufmax;
+			}
+			if (akai_read_file(0,rp->buf,rp->fp,rp->fpos,rp->fpos+n)<0){
+				rp->err=1;
+				rp->fpos=rp->fend; /* no more */
+			}else{
+				rp->fpos+=n;
+				rp->bufsiz=n;
+				rp->bytepos=0;
+			}
+		}
+		if (rp->bytepos<rp->bufsiz){
+			b=(u_int)rp->buf[rp->bytepos++];
+		}else{
+			b=0;
+		}
+		rp->acc|=((U_INT64)b)<<(56-rp->accbits);
+		rp->accbits+=8;
+	}
+}
+
+/* get next bitnum bits (upper bit first) */
+/* Note: same result as akai_sample900compr_getbits() at current bit position */
 u_int
-akai_sample900compr_sample2wav(u_char *sbuf,u_char *wavbuf,u_int sbufsiz,u_int wavbufsiz)
+akai_sample900compr_bitrd_get(struct akai_sample900compr_bitrd_s *rp,u_int bitnum)
+{
+	u_int val;
+
+	if (bitnum==0){
+		return 0;
+	}
+	/* XXX no check if bitnum too large for u_int */
+
+	if (rp->accbits<bitnum){
+		akai_sample900compr_bitrd_fill(rp);
+	}
+	val=(u_int)(rp->acc>>(64-bitnum));
+	rp->acc<<=bitnum;
+	rp->accbits-=bitnum;
+
+	return val;
+}
+
+/* set bit position relative to start of buffer (or begin in file) */
+void
+akai_sample900compr_bitrd_seek(struct akai_sample900compr_bitrd_s *rp,u_int bitpos)
+{
+	u_int bpos;
+
+	if (rp==NULL){
+		return;
+	}
+
+	if (rp->fp!=NULL){
+		/* Note: buffer contains bytes fpos-bufsiz...fpos-1 of file */
+		bpos=rp->fbegin+(bitpos>>3); /* /8: 8 bits per byte */
+		if ((bpos+rp->bufsiz>=rp->fpos)&&(bpos<rp->fpos)){
+			/* within buffer */
+			rp->bytepos=bpos+rp->bufsiz-rp->fpos;
+		}else{
+			/* refill buffer (see below) */
+			rp->fpos=(bpos<rp->fend)?bpos:rp->fend;
+			rp->bufsiz=0;
+			rp->bytepos=0;
+		}
+	}else{
+		bpos=bitpos>>3; /* /8: 8 bits per byte */
+		rp->bytepos=(bpos<rp->bufsiz)?bpos:rp->bufsiz;
+	}
+	rp->acc=0;
+	rp->accbits=0;
+	akai_sample900compr_bitrd_fill(rp);
+	/* skip remaining bits within byte */
+	akai_sample900compr_bitrd_get(rp,7&bitpos);
+}
+
+/* Note: dp->rd must be initialized separately */
+/* sbufsiz: size of compressed sample in bytes */
+void
+akai_sample900compr_dec_init(struct akai_sample900compr_dec_s *dp,u_int sbufsiz)
+{
+
+	if (dp==NULL){
+		return;
+	}
+
+	dp->bitremain=sbufsiz*8; /* 8 bits per byte */
+	dp->curval=0;
+	dp->curinc=0;
+	dp->upbitnum=0;
+	dp->upsigns=0;
+	dp->gi=SAMPLE900COMPR_GROUP_SAMPNUM; /* no current group */
+}
+
+/* convert S900 compressed sample format into 16bit WAV sample format */
+/* returns number of bytes in wavbuf, less than wavbufsiz (rounded down to even) only at end */
+/* Note: can be called repeatedly to continue at current position */
+u_int
+akai_sample900compr_dec_run(struct akai_sample900compr_dec_s *dp,u_char *wavbuf,u_int wavbufsiz)
 {
-	u_char upbitnum;
-	u_char upsign;
 	u_short upabsval;
-	short curval;
-	short curinc;
-	u_int bitremain;
-	u_int bitpos;
 	u_int wavpos;
 	u_char code;
-	u_int i,j;
+	u_int j;
 
-	if ((sbuf==NULL)||(wavbuf==NULL)){
-		return 0;
-	}
-	if ((sbufsiz==0)||(wavbufsiz==0)){
+	if ((dp==NULL)||(wavbuf==NULL)){
 		return 0;
 	}
 
-	/* convert S900 compressed sample format into 16bit WAV sample format */
-	curval=0;
-	curinc=0;
-	bitremain=sbufsiz*8; /* 8 bits per byte */
-	bitpos=0;
 	wavpos=0;
-	for (;(bitremain>0)&&(wavpos+1<wavbufsiz);){
-		/* get code nibble */
-		if (bitremain<4){
-			break; /* end */
-		}
-		code=(u_char)akai_sample900compr_getbits(sbuf,bitpos,4);
+	while (wavpos+1<wavbufsiz){
+		if (dp->gi>=SAMPLE900COMPR_GROUP_SAMPNUM){ /* need next group? */
+			/* get code nibble */
+			if (dp->bitremain<4){
+				dp->bitremain=0;
+				break; /* end */
+			}
 #ifdef SAMPLE900COMPR_DEBUG
-		PRINTF_OUT("%08x: code=%x\n",bitpos,code);
+			PRINTF_OUT("%08x: ",(dp->rd.fpos-dp->rd.bufsiz+dp->rd.bytepos)*8-dp->rd.accbits);
 #endif
-		bitpos+=4;
-		bitremain-=4;
-		/* parse code */
-		if (code==0x0){
-			/* Note: no further bits for this group */
-			/* generate signal */
-			for (i=0;(i<SAMPLE900COMPR_GROUP_SAMPNUM)&&(wavpos+1<wavbufsiz);i++){
-				/* update curval */
-				curval+=curinc;
-				/* convert 12bit sample into 16bit WAV sample */
-				wavbuf[wavpos++]=0xf0&(u_char)(curval<<4);
-				wavbuf[wavpos++]=0xff&(u_char)(curval>>4);
-			}
-		}else{
-			/* number of bits for upabsval */
-			upbitnum=SAMPLE900COMPR_UPBITNUM_NEGCODE_OFF-code;
-			/* Note: upbitnum>SAMPLE900COMPR_UPBITNUM_MAX is supported here, but should not occur normally */
+			code=(u_char)akai_sample900compr_bitrd_get(&dp->rd,4);
 #ifdef SAMPLE900COMPR_DEBUG
-			if (upbitnum>SAMPLE900COMPR_UPBITNUM_MAX){
-				PRINTF_OUT("          upbitnum>SAMPLE900COMPR_UPBITNUM_MAX\n");
-			}
+			PRINTF_OUT("code=%x\n",code);
 #endif
-			/* number of required remaining bits for instruction code */
-			j=SAMPLE900COMPR_GROUP_SAMPNUM*(1+((u_int)upbitnum)); /* Note: per word: 1 sign flag bit and n bits */
-			if (bitremain<j){
-				break; /* end */
-			}
-			/* generate signal */
-			for (i=0;(i<SAMPLE900COMPR_GROUP_SAMPNUM)&&(wavpos+1<wavbufsiz);i++){
-				/* get sign flag bit */
-				upsign=(u_char)akai_sample900compr_getbits(sbuf,bitpos+0+i,1);
-				/* get value word */
-				upabsval=(u_short)akai_sample900compr_getbits(sbuf,bitpos+SAMPLE900COMPR_GROUP_SAMPNUM+i*((u_int)upbitnum),(u_int)upbitnum);
+			dp->bitremain-=4;
+			/* parse code */
+			if (code==0x0){
+				/* Note: no further bits for this group */
+				dp->upbitnum=0;
+			}else{
+				/* number of bits for upabsval */
+				dp->upbitnum=SAMPLE900COMPR_UPBITNUM_NEGCODE_OFF-code;
+				/* Note: upbitnum>SAMPLE900COMPR_UPBITNUM_MAX is supported here, but should not occur normally */
 #ifdef SAMPLE900COMPR_DEBUG
-				PRINTF_OUT("          %c%u\n",(upsign==0)?'+':'-',(u_int)upabsval);
+				if (dp->upbitnum>SAMPLE900COMPR_UPBITNUM_MAX){
+					PRINTF_OUT("          upbitnum>SAMPLE900COMPR_UPBITNUM_MAX\n");
+				}
 #endif
-				/* update curinc */
-				if (upsign==0){
-					/* plus */
-					curinc+=(short)upabsval;
-				}else{
-					/* minus */
-					curinc-=(short)upabsval;
+				/* number of required remaining bits for instruction code */
+				j=SAMPLE900COMPR_GROUP_SAMPNUM*(1+((u_int)dp->upbitnum)); /* Note: per word: 1 sign flag bit and n bits */
+				if (dp->bitremain<j){
+					dp->bitremain=0;
+					break; /* end */
 				}
-				/* update curval */
-				curval+=curinc;
-				/* Note: SAMPLE900COMPR_BITMASK&curval contains sample value */
-				/* convert 12bit sample into 16bit WAV sample */
-				wavbuf[wavpos++]=0xf0&(u_char)(curval<<4);
-				wavbuf[wavpos++]=0xff&(u_char)(curval>>4);
+				/* get all sign flag bits of group at once */
+				/* Note: sign flag bit of first word is upper bit */
+				dp->upsigns=akai_sample900compr_bitrd_get(&dp->rd,SAMPLE900COMPR_GROUP_SAMPNUM);
+				dp->bitremain-=j;
+			}
+			dp->gi=0; /* first word in group */
+		}
+		/* generate signal */
+		if (dp->upbitnum!=0){
+			/* get value word */
+			/* Note: value words follow sign flag bits in sequence */
+			upabsval=(u_short)akai_sample900compr_bitrd_get(&dp->rd,(u_int)dp->upbitnum);
+#ifdef SAMPLE900COMPR_DEBUG
+			PRINTF_OUT("          %c%u\n",((dp->upsigns&(1<<(SAMPLE900COMPR_GROUP_SAMPNUM-1-dp->gi)))==0)?'+':'-',(u_int)upabsval);
+#endif
+			/* update curinc */
+			if ((dp->upsigns&(1<<(SAMPLE900COMPR_GROUP_SAMPNUM-1-dp->gi)))==0){
+				/* plus */
+				dp->curinc+=(short)upabsval;
+			}else{
+				/* minus */
+				dp->curinc-=(short)upabsval;
 			}
-			bitpos+=j;
-			bitremain-=j;
 		}
+		/* update curval */
+		dp->curval+=dp->curinc;
+		/* Note: SAMPLE900COMPR_BITMASK&curval contains sample value */
+		/* convert 12bit sample into 16bit WAV sample */
+		wavbuf[wavpos++]=0xf0&(u_char)(dp->curval<<4);
+		wavbuf[wavpos++]=0xff&(u_char)(dp->curval>>4);
+		dp->gi++;
 	}
 
 	return wavpos;
 }
 
+/* skip next group without generating signal, update curval and curinc */
+/* Note: must be at start of group */
+/* returns 0 if success, -1 if end of compressed sample */
+int
+akai_sample900compr_dec_skipgroup(struct akai_sample900compr_dec_s *dp)
+{
+	u_short upabsval;
+	u_int upbitnum;
+	u_int upsigns;
+	u_char code;
+	u_int j;
+
+	if (dp==NULL){
+		return -1;
+	}
+
+	/* get code nibble */
+	if (dp->bitremain<4){
+		dp->bitremain=0;
+		return -1; /* end */
+	}
+	code=(u_char)akai_sample900compr_bitrd_get(&dp->rd,4);
+	dp->bitremain-=4;
+	if (code==0x0){
+		/* Note: no further bits for this group, curinc constant */
+		dp->curval+=SAMPLE900COMPR_GROUP_SAMPNUM*dp->curinc;
+		return 0;
+	}
+	/* number of bits for upabsval */
+	upbitnum=SAMPLE900COMPR_UPBITNUM_NEGCODE_OFF-code;
+	/* number of required remaining bits for instruction code */
+	j=SAMPLE900COMPR_GROUP_SAMPNUM*(1+upbitnum); /* Note: per word: 1 sign flag bit and n bits */
+	if (dp->bitremain<j){
+		dp->bitremain=0;
+		return -1; /* end */
+	}
+	upsigns=akai_sample900compr_bitrd_get(&dp->rd,SAMPLE900COMPR_GROUP_SAMPNUM);
+	dp->bitremain-=j;
+	for (j=0;j<SAMPLE900COMPR_GROUP_SAMPNUM;j++){
+		upabsval=(u_short)akai_sample900compr_bitrd_get(&dp->rd,upbitnum);
+		if ((upsigns&(1<<(SAMPLE900COMPR_GROUP_SAMPNUM-1-j)))==0){
+			/* plus */
+			dp->curinc+=(short)upabsval;
+		}else{
+			/* minus */
+			dp->curinc-=(short)upabsval;
+		}
+		dp->curval+=dp->curinc;
+	}
+
+	return 0;
+}
+
+/* build checkpoint index every groupstep groups */
+/* Note: dp must be initialized at start of compressed sample, is at end afterwards */
+int
+akai_sample900compr_index_build(struct akai_sample900compr_index_s *ip,struct akai_sample900compr_dec_s *dp,u_int groupstep)
+{
+	u_int ckptmax;
+	u_int groupnum;
+
+	if ((ip==NULL)||(dp==NULL)||(groupstep==0)){
+		return -1;
+	}
+
+	ip->bitnum=dp->bitremain;
+	ip->groupstep=groupstep;
+	/* max. number of groups (at least 4 bits per group) */
+	groupnum=(dp->bitremain+3)/4;
+	ckptmax=groupnum/groupstep+1;
+	ip->ckpt=(struct akai_sample900compr_ckpt_s *)malloc(ckptmax*sizeof(struct akai_sample900compr_ckpt_s));
+	if (ip->ckpt==NULL){
+		PRINTF_ERR("cannot allocate memory\n");
+		ip->ckptnum=0;
+		return -1;
+	}
+	ip->ckptnum=0;
+
+	/* pre-scan */
+	for (groupnum=0;;groupnum++){
+		if ((groupnum%groupstep)==0){
+			/* checkpoint */
+			ip->ckpt[ip->ckptnum].bitpos=ip->bitnum-dp->bitremain;
+			ip->ckpt[ip->ckptnum].curval=dp->curval;
+			ip->ckpt[ip->ckptnum].curinc=dp->curinc;
+			ip->ckptnum++;
+		}
+		if (akai_sample900compr_dec_skipgroup(dp)<0){
+			break; /* end */
+		}
+	}
+	ip->samplecount=groupnum*SAMPLE900COMPR_GROUP_SAMPNUM;
+
+	return 0;
+}
+
+void
+akai_sample900compr_index_free(struct akai_sample900compr_index_s *ip)
+{
+
+	if (ip==NULL){
+		return;
+	}
+
+	if (ip->ckpt!=NULL){
+		free(ip->ckpt);
+		ip->ckpt=NULL;
+	}
+	ip->ckptnum=0;
+}
+
+/* set decompressor to sample word samplepos via checkpoint index */
+/* returns 0 if success, -1 if samplepos not within compressed sample */
+int
+akai_sample900compr_dec_seek(struct akai_sample900compr_dec_s *dp,struct akai_sample900compr_index_s *ip,u_int samplepos)
+{
+	u_char tmpbuf[2*SAMPLE900COMPR_GROUP_SAMPNUM]; /* *2 for 16bit per WAV sample word */
+	u_int g,ci;
+	u_int i;
+
+	if ((dp==NULL)||(ip==NULL)||(ip->ckptnum==0)){
+		return -1;
+	}
+	if (samplepos>ip->samplecount){
+		return -1;
+	}
+
+	/* group and nearest checkpoint before */
+	g=samplepos/SAMPLE900COMPR_GROUP_SAMPNUM;
+	ci=g/ip->groupstep;
+	if (ci>=ip->ckptnum){
+		ci=ip->ckptnum-1;
+	}
+
+	/* restore state at checkpoint */
+	akai_sample900compr_bitrd_seek(&dp->rd,ip->ckpt[ci].bitpos);
+	dp->bitremain=ip->bitnum-ip->ckpt[ci].bitpos;
+	dp->curval=ip->ckpt[ci].curval;
+	dp->curinc=ip->ckpt[ci].curinc;
+	dp->upbitnum=0;
+	dp->upsigns=0;
+	dp->gi=SAMPLE900COMPR_GROUP_SAMPNUM; /* no current group */
+
+	/* skip groups up to group g */
+	for (i=ci*ip->groupstep;i<g;i++){
+		if (akai_sample900compr_dec_skipgroup(dp)<0){
+			return -1;
+		}
+	}
+	/* skip sample words within group g */
+	i=2*(samplepos-g*SAMPLE900COMPR_GROUP_SAMPNUM); /* *2 for 16bit per WAV sample word */
+	if ((i>0)&&(akai_sample900compr_dec_run(dp,tmpbuf,i)<i)){
+		return -1;
+	}
+
+	return 0;
+}
+
+u_int
+akai_sample900compr_sample2wav(u_char *sbuf,u_char *wavbuf,u_int sbufsiz,u_int wavbufsiz)
+{
+	struct akai_sample900compr_dec_s dec;
+
+	if ((sbuf==NULL)||(wavbuf==NULL)){
+		return 0;
+	}
+	if ((sbufsiz==0)||(wavbufsiz==0)){
+		return 0;
+	}
+
+	/* convert S900 compressed sample format into 16bit WAV sample format */
+	akai_sample900compr_bitrd_init(&dec.rd,sbuf,sbufsiz);
+	akai_sample900compr_dec_init(&dec,sbufsiz);
+	return akai_sample900compr_dec_run(&dec,wavbuf,wavbufsiz);
+}
+
 void
 akai_sample900compr_setbits(u_char *buf,u_int bitpos,u_int bitnum,u_int val)
 {
@@ -1408,15 +1836,86 @@ akai_sample900compr_setbits(u_char *buf,u_int bitpos,u_int bitnum,u_int val)
 	}
 }
 
-int
-akai_sample900compr_wav2sample(u_char *sbuf,u_char *wavbuf,u_int samplecountpart)
+void
+akai_sample900compr_bitwr_init(struct akai_sample900compr_bitwr_s *wp,u_char *buf)
 {
-	/* must be static for multiple calls, must be initialized */
-	static u_char *upbitnumbuf=NULL;
-	static u_int *upsignbuf=NULL;
-	static u_short *upabsvalbuf=NULL;
-	static u_int groupcount=0;
 
+	if (wp==NULL){
+		return;
+	}
+
+	wp->buf=buf;
+	wp->bytepos=0;
+	wp->acc=0;
+	wp->accbits=0;
+}
+
+/* append bitnum bits of val (upper bit first) */
+/* Note: same result as akai_sample900compr_setbits() at current bit position */
+void
+akai_sample900compr_bitwr_put(struct akai_sample900compr_bitwr_s *wp,u_int bitnum,u_int val)
+{
+
+	if ((bitnum==0)||(bitnum>32)){
+		return;
+	}
+	/* XXX no check if bytepos too large for buf */
+
+	if (wp->accbits+bitnum>64){
+		/* store 4 bytes at once */
+		wp->buf[wp->bytepos+0]=(u_char)(wp->acc>>56);
+		wp->buf[wp->bytepos+1]=(u_char)(wp->acc>>48);
+		wp->buf[wp->bytepos+2]=(u_char)(wp->acc>>40);
+		wp->buf[wp->bytepos+3]=(u_char)(wp->acc>>32);
+		wp->bytepos+=4;
+		wp->acc<<=32;
+		wp->accbits-=32;
+	}
+	val&=(u_int)((((U_INT64)1)<<bitnum)-1); /* lower bitnum bits */
+	wp->acc|=((U_INT64)val)<<(64-wp->accbits-bitnum);
+	wp->accbits+=bitnum;
+}
+
+/* store remaining bits with zero padding to full byte */
+/* returns number of used bytes in buffer */
+u_int
+akai_sample900compr_bitwr_flush(struct akai_sample900compr_bitwr_s *wp)
+{
+
+	while (wp->accbits>0){
+		wp->buf[wp->bytepos++]=(u_char)(wp->acc>>56);
+		wp->acc<<=8;
+		if (wp->accbits<8){
+			wp->accbits=0;
+		}else{
+			wp->accbits-=8;
+		}
+	}
+
+	return wp->bytepos;
+}
+
+void
+akai_sample900compr_enc_init(struct akai_sample900compr_enc_s *ep)
+{
+
+	if (ep==NULL){
+		return;
+	}
+
+	ep->upbitnumbuf=NULL;
+	ep->upsignbuf=NULL;
+	ep->upabsvalbuf=NULL;
+	ep->groupcount=0;
+	ep->groupcountmax=0;
+}
+
+/* Note: ep must have been initialized via akai_sample900compr_enc_init() */
+/* Note: buffers in ep are kept for reuse after second pass, sbuf==NULL&&wavbuf==NULL frees them */
+int
+akai_sample900compr_wav2sample(struct akai_sample900compr_enc_s *ep,u_char *sbuf,u_char *wavbuf,u_int samplecountpart)
+{
+	struct akai_sample900compr_bitwr_s wr;
 	short sval;
 	short curval;
 	short curinc;
@@ -1426,9 +1925,14 @@ akai_sample900compr_wav2sample(u_char *sbuf,u_char *wavbuf,u_int samplecountpart
 	u_int upsign;
 	u_int bitpos;
 	u_char code;
-	u_int g,s,i,j;
+	u_int g,s,i;
+	u_int m;
 	int ret;
 
+	if (ep==NULL){
+		return -1;
+	}
+
 	if ((sbuf==NULL)&&(wavbuf==NULL)){
 		ret=0; /* no error */
 		/* free buffers if still allocated */
@@ -1442,46 +1946,51 @@ akai_sample900compr_wav2sample(u_char *sbuf,u_char *wavbuf,u_int samplecountpart
 	if (sbuf==NULL){
 		/* first pass */
 
-		/* free buffers if still allocated */
-		if (upbitnumbuf!=NULL){
-			free(upbitnumbuf);
-			upbitnumbuf=NULL;
-		}
-		if (upsignbuf!=NULL){
-			free(upsignbuf);
-			upsignbuf=NULL;
-		}
-		if (upabsvalbuf!=NULL){
-			free(upabsvalbuf);
-			upabsvalbuf=NULL;
-		}
-
 		/* number of groups */
 		/* Note: 2*samplecountpart+1 to encode at least one additional zero sample behind end */
-		groupcount=(2*samplecountpart+1+SAMPLE900COMPR_GROUP_SAMPNUM-1)/SAMPLE900COMPR_GROUP_SAMPNUM; /* round up */
+		ep->groupcount=(2*samplecountpart+1+SAMPLE900COMPR_GROUP_SAMPNUM-1)/SAMPLE900COMPR_GROUP_SAMPNUM; /* round up */
 
-		/* allocate buffers */
-		upbitnumbuf=(u_char *)malloc(groupcount*sizeof(u_char));
-		if (upbitnumbuf==NULL){
-			PERROR("cannot allocate upbitnumbuf");
-			goto akai_sample900compr_wav2sample_freebufexit;
-		}
-		upsignbuf=(u_int *)malloc(groupcount*sizeof(u_int));
-		if (upsignbuf==NULL){
-			PERROR("cannot allocate upsignbuf");
-			goto akai_sample900compr_wav2sample_freebufexit;
-		}
-		upabsvalbuf=(u_short *)malloc(groupcount*SAMPLE900COMPR_GROUP_SAMPNUM*sizeof(u_short));
-		if (upabsvalbuf==NULL){
-			PERROR("cannot allocate upabsvalbuf");
-			goto akai_sample900compr_wav2sample_freebufexit;
+		if (ep->groupcount>ep->groupcountmax){ /* buffers too small? */
+			/* free buffers if still allocated */
+			if (ep->upbitnumbuf!=NULL){
+				free(ep->upbitnumbuf);
+				ep->upbitnumbuf=NULL;
+			}
+			if (ep->upsignbuf!=NULL){
+				free(ep->upsignbuf);
+				ep->upsignbuf=NULL;
+			}
+			if (ep->upabsvalbuf!=NULL){
+				free(ep->upabsvalbuf);
+				ep->upabsvalbuf=NULL;
+			}
+			ep->groupcountmax=0;
+
+			/* allocate buffers */
+			ep->upbitnumbuf=(u_char *)malloc(ep->groupcount*sizeof(u_char));
+			if (ep->upbitnumbuf==NULL){
+				PERROR("cannot allocate upbitnumbuf");
+				goto akai_sample900compr_wav2sample_freebufexit;
+			}
+			ep->upsignbuf=(u_int *)malloc(ep->groupcount*sizeof(u_int));
+			if (ep->upsignbuf==NULL){
+				PERROR("cannot allocate upsignbuf");
+				goto akai_sample900compr_wav2sample_freebufexit;
+			}
+			ep->upabsvalbuf=(u_short *)malloc(ep->groupcount*SAMPLE900COMPR_GROUP_SAMPNUM*sizeof(u_short));
+			if (ep->upabsvalbuf==NULL){
+				PERROR("cannot allocate upabsvalbuf");
+				goto akai_sample900compr_wav2sample_freebufexit;
+			}
+			ep->groupcountmax=ep->groupcount;
 		}
 
 		/* gather groups */
 		curval=0;
 		curinc=0;
 		sval=0;
-		for (g=0,s=0;g<groupcount;g++){
+		bitpos=0;
+		for (g=0,s=0;g<ep->groupcount;g++){
 			upbitnum=0;
 			upsign=0;
 			/* samples within group */
@@ -1498,11 +2007,15 @@ akai_sample900compr_wav2sample(u_char *sbuf,u_char *wavbuf,u_int samplecountpart
 				upsign<<=1;
 				upval=sval-(curval+curinc);
 				/* choose optimum interval position for min. abs. value */
-				while (upval>SAMPLE900COMPR_INTERVALSIZ2){
-					upval-=SAMPLE900COMPR_INTERVALSIZ;
-				}
-				while (upval<-SAMPLE900COMPR_INTERVALSIZ2){
-					upval+=SAMPLE900COMPR_INTERVALSIZ;
+				/* Note: -SAMPLE900COMPR_INTERVALSIZ2<=upval<=+SAMPLE900COMPR_INTERVALSIZ2 afterwards, */
+				/*       boundary value is reached from the side of the original upval */
+				if ((upval>SAMPLE900COMPR_INTERVALSIZ2)||(upval<-SAMPLE900COMPR_INTERVALSIZ2)){
+					m=SAMPLE900COMPR_BITMASK&(u_int)(int)upval; /* upval modulo interval size */
+					if ((m>SAMPLE900COMPR_INTERVALSIZ2)||((m==SAMPLE900COMPR_INTERVALSIZ2)&&(upval<0))){
+						upval=(short)m-SAMPLE900COMPR_INTERVALSIZ;
+					}else{
+						upval=(short)m;
+					}
 				}
 				/* Note: max./min. possible value for resulting upval is +/-SAMPLE900COMPR_INTERVALSIZ2 */
 				/*       which requires SAMPLE900COMPR_UPBITNUM_MAX bits for upabsval */
@@ -1519,14 +2032,12 @@ akai_sample900compr_wav2sample(u_char *sbuf,u_char *wavbuf,u_int samplecountpart
 					/* update curinc */
 					curinc-=(short)upabsval;
 				}
-				upabsvalbuf[s]=upabsval;
+				ep->upabsvalbuf[s]=upabsval;
 
 				/* determine max. number of required bits for upabsval in group */
 				/* start with previous upbitnum */
-				for (j=(u_int)upbitnum;j<SAMPLE900COMPR_UPBITNUM_MAX;j++){
-					if (((1<<j)&upabsval)!=0){ /* bit j set? */
-						upbitnum=(u_char)(j+1);
-					}
+				while ((upbitnum<SAMPLE900COMPR_UPBITNUM_MAX)&&((upabsval>>upbitnum)!=0)){
+					upbitnum++;
 				}
 
 				/* update curval */
@@ -1541,17 +2052,14 @@ akai_sample900compr_wav2sample(u_char *sbuf,u_char *wavbuf,u_int samplecountpart
 #ifdef SAMPLE900COMPR_DEBUG
 			PRINTF_OUT("%06x: upbitnum=%2u upsign=%04x\n",g,(u_int)upbitnum,upsign);
 #endif
-			upbitnumbuf[g]=upbitnum;
-			upsignbuf[g]=upsign;
-		}
+			ep->upbitnumbuf[g]=upbitnum;
+			ep->upsignbuf[g]=upsign;
 
-		/* determine number of bits required in sbuf for second pass */
-		bitpos=0;
-		for (g=0;g<groupcount;g++){
+			/* number of bits required in sbuf for second pass */
 			/* see "encode groups" below */
 			bitpos+=4;
-			if (upbitnumbuf[g]!=0){
-				bitpos+=SAMPLE900COMPR_GROUP_SAMPNUM*(1+((u_int)upbitnumbuf[g]));
+			if (upbitnum!=0){
+				bitpos+=SAMPLE900COMPR_GROUP_SAMPNUM*(1+((u_int)upbitnum));
 			}
 		}
 		bitpos+=(7&(8-(7&bitpos))); /* number of bits missing to full byte */
@@ -1567,7 +2075,7 @@ akai_sample900compr_wav2sample(u_char *sbuf,u_char *wavbuf,u_int samplecountpart
 		}
 
 		/* check allocation of buffers */
-		if ((upbitnumbuf==NULL)||(upsignbuf==NULL)||(upabsvalbuf==NULL)){
+		if ((ep->upbitnumbuf==NULL)||(ep->upsignbuf==NULL)||(ep->upabsvalbuf==NULL)){
 			PRINTF_ERR("error: buffers not allocated in second pass\n");
 			goto akai_sample900compr_wav2sample_freebufexit;
 		}
@@ -1575,36 +2083,33 @@ akai_sample900compr_wav2sample(u_char *sbuf,u_char *wavbuf,u_int samplecountpart
 		/* XXX ignore samplecountpart in second pass */
 
 		/* encode groups */
-		bitpos=0;
-		for (g=0,s=0;g<groupcount;g++){
+		akai_sample900compr_bitwr_init(&wr,sbuf);
+		for (g=0,s=0;g<ep->groupcount;g++){
 			/* determine code nibble */
-			upbitnum=upbitnumbuf[g];
+			upbitnum=ep->upbitnumbuf[g];
 			if (upbitnum==0){
 				code=0x0;
 			}else{
 				code=SAMPLE900COMPR_UPBITNUM_NEGCODE_OFF-upbitnum;
 			}
 #ifdef SAMPLE900COMPR_DEBUG
-			PRINTF_OUT("%08x: code=%x\n",bitpos,code);
+			PRINTF_OUT("%08x: code=%x\n",wr.bytepos*8+wr.accbits,code);
 #endif
 			/* save code nibble */
-			akai_sample900compr_setbits(sbuf,bitpos,4,(u_int)code);
-			bitpos+=4;
+			akai_sample900compr_bitwr_put(&wr,4,(u_int)code);
 
 			if (upbitnum==0){
 				s+=SAMPLE900COMPR_GROUP_SAMPNUM; /* advance in upabsvalbuf[] */
 				/* no further bits to save for this group */
 			}else{
 				/* save upsign */
-				upsign=upsignbuf[g];
-				akai_sample900compr_setbits(sbuf,bitpos,SAMPLE900COMPR_GROUP_SAMPNUM,upsign);
-				bitpos+=SAMPLE900COMPR_GROUP_SAMPNUM;
+				upsign=ep->upsignbuf[g];
+				akai_sample900compr_bitwr_put(&wr,SAMPLE900COMPR_GROUP_SAMPNUM,upsign);
 				/* samples within group */
 				for (i=0;i<SAMPLE900COMPR_GROUP_SAMPNUM;i++,s++){
 					/* save upabsval */
-					upabsval=upabsvalbuf[s];
-					akai_sample900compr_setbits(sbuf,bitpos,(u_int)upbitnum,(u_int)upabsval);
-					bitpos+=(u_int)upbitnum;
+					upabsval=ep->upabsvalbuf[s];
+					akai_sample900compr_bitwr_put(&wr,(u_int)upbitnum,(u_int)upabsval);
 #ifdef SAMPLE900COMPR_DEBUG
 					PRINTF_OUT("          %c%u\n",
 						(((1<<(SAMPLE900COMPR_GROUP_SAMPNUM-1-i))&upsign)==0)?'+':'-',(u_int)upabsval); /* Note: upper bit first */
@@ -1612,31 +2117,26 @@ akai_sample900compr_wav2sample(u_char *sbuf,u_char *wavbuf,u_int samplecountpart
 				}
 			}
 		}
-		j=(7&(8-(7&bitpos))); /* number of bits missing to full byte */
-		if (j!=0){
-			/* zero padding to full byte */
-			akai_sample900compr_setbits(sbuf,bitpos,j,0);
-			bitpos+=j;
-		}
-
-		ret=(int)(bitpos>>3); /* success, return number of used bytes in sbuf */
-		/* free buffers */
-		goto akai_sample900compr_wav2sample_freebufexit;
+		/* zero padding to full byte */
+		ret=(int)akai_sample900compr_bitwr_flush(&wr); /* success, return number of used bytes in sbuf */
+		/* keep buffers for reuse */
+		goto akai_sample900compr_wav2sample_keepbufexit;
 	}
 
 akai_sample900compr_wav2sample_freebufexit:
-	if (upbitnumbuf!=NULL){
-		free(upbitnumbuf);
-		upbitnumbuf=NULL;
+	if (ep->upbitnumbuf!=NULL){
+		free(ep->upbitnumbuf);
+		ep->upbitnumbuf=NULL;
 	}
-	if (upsignbuf!=NULL){
-		free(upsignbuf);
-		upsignbuf=NULL;
+	if (ep->upsignbuf!=NULL){
+		free(ep->upsignbuf);
+		ep->upsignbuf=NULL;
 	}
-	if (upabsvalbuf!=NULL){
-		free(upabsvalbuf);
-		upabsvalbuf=NULL;
+	if (ep->upabsvalbuf!=NULL){
+		free(ep->upabsvalbuf);
+		ep->upabsvalbuf=NULL;
 	}
+	ep->groupcountmax=0;
 
 akai_sample900compr_wav2sample_keepbufexit:
 	return ret;
@@ -1836,6 +2336,7 @@ akai_sample900_noncompr2compr(struct file_s *fp,struct vol_s *volp)
 {
 	struct file_s tmpfile;
 	struct akai_sample900_s s900hdr;
+	struct akai_sample900compr_enc_s enc;
 	u_int samplecount;
 	u_int samplecountpart;
 	u_int samplesizecompr;
@@ -1880,6 +2381,7 @@ akai_sample900_noncompr2compr(struct file_s *fp,struct vol_s *volp)
 	sbufcompr=NULL; /* no sample so far */
 	sbufnoncompr=NULL; /* no sample so far */
 	wavbuf=NULL; /* no sample so far */
+	akai_sample900compr_enc_init(&enc); /* no buffers so far */
 	ret=-1; /* no success so far */
 
 	/* read header to memory */
@@ -1926,7 +2428,7 @@ akai_sample900_noncompr2compr(struct file_s *fp,struct vol_s *volp)
 
 	/* first pass to convert 16bit WAV sample format into S900 compressed sample format */
 	/* Note: first pass of akai_sample900compr_wav2sample() requires WAV sample to be loaded to wavbuf */
-	r=akai_sample900compr_wav2sample(NULL,wavbuf,samplecountpart); /* NULL: first pass */
+	r=akai_sample900compr_wav2sample(&enc,NULL,wavbuf,samplecountpart); /* NULL: first pass */
 	if (r<0){
 		goto akai_sample900_noncompr2compr_exit;
 	}
@@ -1970,7 +2472,7 @@ akai_sample900_noncompr2compr(struct file_s *fp,struct vol_s *volp)
 	}
 
 	/* second pass to convert 16bit WAV sample format into S900 compressed sample format */
-	if (akai_sample900compr_wav2sample(sbufcompr,wavbuf,samplecountpart)<0){ /* sbufcompr!=NULL: second pass */
+	if (akai_sample900compr_wav2sample(&enc,sbufcompr,wavbuf,samplecountpart)<0){ /* sbufcompr!=NULL: second pass */
 		goto akai_sample900_noncompr2compr_exit;
 	}
 
@@ -2027,280 +2529,509 @@ akai_sample900_noncompr2compr_exit:
 	if (wavbuf!=NULL){
 		free(wavbuf);
 	}
-	akai_sample900compr_wav2sample(NULL,NULL,0); /* NULL,NULL: free buffers if still allocated */
+	akai_sample900compr_wav2sample(&enc,NULL,NULL,0); /* NULL,NULL: free buffers if still allocated */
 	return ret;
 }
 
 
 
+/* Note: fp is copied into context */
 int
-akai_sample2wav(struct file_s *fp,int wavfd,u_int *sizep,char **wavnamep,int what)
+akai_sample2wav_open(struct akai_sample2wav_s *cp,struct file_s *fp)
 {
-	/* Note: static for multiple calls with different what */
-	static struct akai_sample3000_s s3000hdr;
-	static struct akai_sample900_s *s900hdrp;
-	static u_int hdrsize;
-	static u_int samplecount;
-	static u_int samplecountpart;
-	static u_int samplesize;
-	static u_int samplerate;
-	static u_char *sbuf;
-	static u_int wavsamplesize;
-	static u_char *wavbuf;
-	static int ret;
-	static char wavname[AKAI_NAME_LEN+4+1]; /* name (ASCII), +4 for ".<type>", +1 for '\0' */
-	static u_int nlen;
-	static u_int i;
+
+	if (cp==NULL){
+		return -1;
+	}
+
+	cp->probed=0;
+	cp->sbuf=NULL; /* no sample so far */
+	cp->wavbuf=NULL; /* no sample so far */
+	cp->s9cidx.ckpt=NULL; /* no index so far */
+	cp->s9cidx.ckptnum=0;
 
 	if (fp==NULL){
 		return -1;
 	}
+	bcopy(fp,&cp->file,sizeof(struct file_s));
 
-	sbuf=NULL; /* no sample so far */
-	wavbuf=NULL; /* no sample so far */
-	ret=-1; /* no success so far */
+	return 0;
+}
 
-	if (what&SAMPLE2WAV_CHECK){
 
-		/* file type */
-		if (fp->type==(u_char)AKAI_SAMPLE900_FTYPE){
-			/* S900 sample */
-			hdrsize=sizeof(struct akai_sample900_s);
-		}else if (fp->type==(u_char)AKAI_SAMPLE1000_FTYPE){
-			/* S1000 sample */
-			hdrsize=sizeof(struct akai_sample1000_s);
-		}else if (fp->type==(u_char)AKAI_SAMPLE3000_FTYPE){
-			/* S3000 sample */
-			hdrsize=sizeof(struct akai_sample3000_s);
-		}else{
-			/* unknown or unsupported */
-			return 1; /* no error */
-		}
 
-		/* read header to memory */
-		/* Note: use S3000 header as buffer for S900 header */
-		if (akai_read_file(0,(u_char *)&s3000hdr,fp,0,hdrsize)<0){
-			PRINTF_ERR("cannot read sample\n");
-			goto akai_sample2wav_exit;
-		}
+/* read and check sample header, determine WAV file size and WAV name */
+/* returns 0 if valid sample, 1 if not a sample file, -1 if error */
+/* Note: *wavnamep points to buffer within context */
+int
+akai_sample2wav_probe(struct akai_sample2wav_s *cp,u_int *sizep,char **wavnamep)
+{
+	struct file_s *fp;
+	struct akai_sample900_s *s900hdrp;
+	u_int nlen;
 
-		/* parse header */
-		if (fp->type==(u_char)AKAI_SAMPLE900_FTYPE){
-			/* S900 sample */
-			s900hdrp=(struct akai_sample900_s *)&s3000hdr;
-			/* number of samples */
-			/* XXX should be an even number */
-			samplecount=(s900hdrp->slen[3]<<24)
-				+(s900hdrp->slen[2]<<16)
-				+(s900hdrp->slen[1]<<8)
-				+s900hdrp->slen[0];
-			/* number of samples per part  */
-			samplecountpart=(samplecount+1)/2; /* round up */
-			samplecount=2*samplecountpart; /* XXX correct samplecount */
-			if (fp->osver==0){
-				/* S900 non-compressed sample format */
-				/* size in bytes */
-				samplesize=3*samplecountpart;
-			}else{
-				/* S900 compressed sample format */
-				/* size in bytes */
-				if (fp->size<hdrsize){
-					PRINTF_ERR("invalid sample size\n");
-					goto akai_sample2wav_exit;
-				}
-				samplesize=fp->size-hdrsize;
-			}
-			samplerate=(s900hdrp->srate[1]<<8)
-				+s900hdrp->srate[0];
+	if (cp==NULL){
+		return -1;
+	}
+	fp=&cp->file;
+	cp->probed=0;
+
+	/* file type */
+	if (fp->type==(u_char)AKAI_SAMPLE900_FTYPE){
+		/* S900 sample */
+		cp->hdrsize=sizeof(struct akai_sample900_s);
+	}else if (fp->type==(u_char)AKAI_SAMPLE1000_FTYPE){
+		/* S1000 sample */
+		cp->hdrsize=sizeof(struct akai_sample1000_s);
+	}else if (fp->type==(u_char)AKAI_SAMPLE3000_FTYPE){
+		/* S3000 sample */
+		cp->hdrsize=sizeof(struct akai_sample3000_s);
+	}else{
+		/* unknown or unsupported */
+		return 1; /* no error */
+	}
+
+	/* read header to memory */
+	/* Note: use S3000 header as buffer for S900 header */
+	if (akai_read_file(0,(u_char *)&cp->s3000hdr,fp,0,cp->hdrsize)<0){
+		PRINTF_ERR("cannot read sample\n");
+		return -1;
+	}
+
+	/* parse header */
+	if (fp->type==(u_char)AKAI_SAMPLE900_FTYPE){
+		/* S900 sample */
+		s900hdrp=(struct akai_sample900_s *)&cp->s3000hdr;
+		/* number of samples */
+		/* XXX should be an even number */
+		cp->samplecount=(s900hdrp->slen[3]<<24)
+			+(s900hdrp->slen[2]<<16)
+			+(s900hdrp->slen[1]<<8)
+			+s900hdrp->slen[0];
+		/* number of samples per part  */
+		cp->samplecountpart=(cp->samplecount+1)/2; /* round up */
+		cp->samplecount=2*cp->samplecountpart; /* XXX correct samplecount */
+		if (fp->osver==0){
+			/* S900 non-compressed sample format */
+			/* size in bytes */
+			cp->samplesize=3*cp->samplecountpart;
 		}else{
-			/* S1000/S3000 sample */
-			/* Note: S1000 header is contained within S3000 header */
-			/* number of samples */
-			samplecount=(s3000hdr.s1000.slen[3]<<24)
-				+(s3000hdr.s1000.slen[2]<<16)
-				+(s3000hdr.s1000.slen[1]<<8)
-				+s3000hdr.s1000.slen[0];
+			/* S900 compressed sample format */
 			/* size in bytes */
-			samplesize=samplecount*2; /* *2 for 16bit per sample word */
-			samplecountpart=0;
-			samplerate=(s3000hdr.s1000.srate[1]<<8)
-				+s3000hdr.s1000.srate[0];
+			if (fp->size<cp->hdrsize){
+				PRINTF_ERR("invalid sample size\n");
+				return -1;
+			}
+			cp->samplesize=fp->size-cp->hdrsize;
 		}
+		cp->samplerate=(s900hdrp->srate[1]<<8)
+			+s900hdrp->srate[0];
+	}else{
+		/* S1000/S3000 sample */
+		/* Note: S1000 header is contained within S3000 header */
+		/* number of samples */
+		cp->samplecount=(cp->s3000hdr.s1000.slen[3]<<24)
+			+(cp->s3000hdr.s1000.slen[2]<<16)
+			+(cp->s3000hdr.s1000.slen[1]<<8)
+			+cp->s3000hdr.s1000.slen[0];
 		/* size in bytes */
-		wavsamplesize=samplecount*2; /* *2 for 16bit per WAV sample word */
-		/* Note: wavsamplesize==0 is allowed here */
+		cp->samplesize=cp->samplecount*2; /* *2 for 16bit per sample word */
+		cp->samplecountpart=0;
+		cp->samplerate=(cp->s3000hdr.s1000.srate[1]<<8)
+			+cp->s3000hdr.s1000.srate[0];
+	}
+	/* size in bytes */
+	cp->wavsamplesize=cp->samplecount*2; /* *2 for 16bit per WAV sample word */
+	/* Note: wavsamplesize==0 is allowed here */
+	/* whole sample */
+	cp->wavbegin=0;
+	cp->wavend=cp->samplecount;
+
+#ifdef DEBUG
+	PRINTF_OUT("type:        %15i\n",fp->type);
+	PRINTF_OUT("samplecount: %15u\n",cp->samplecount);
+	PRINTF_OUT("samplesize:  %15u bytes\n",cp->samplesize);
+	PRINTF_OUT("samplerate:  %15u Hz\n",cp->samplerate);
+#endif
+
+	/* check size */
+	if (cp->hdrsize+cp->samplesize>fp->size){
+		PRINTF_ERR("invalid sample size\n");
+		return -1;
+	}
+
+	cp->probed=1;
+
+	if (sizep!=NULL){
+		/* WAV file size */
+		*sizep=WAV_HEAD_SIZE+cp->wavsamplesize;
+#ifndef WAV_AKAIHEAD_DISABLE
+		*sizep+=sizeof(struct wav_chunkhead_s)+cp->hdrsize; /* sample header chunk (see below) */
+#endif
+	}
+
+	/* create WAV name */
+	if ((fp->volp!=NULL)&&(fp->index<fp->volp->fimax)){
+		akai2ascii_name(fp->volp->file[fp->index].name,cp->wavname,fp->volp->type==AKAI_VOL_TYPE_S900);
+		nlen=(u_int)strlen(cp->wavname);
+	}else{
+		nlen=0;
+	}
+	bcopy(".wav",cp->wavname+nlen,5);
+
+	if (wavnamep!=NULL){
+		/* pointer to name (wavname is kept in context) */
+		*wavnamep=cp->wavname;
+	}
 
-#ifdef DEBUG
-		PRINTF_OUT("type:        %15i\n",fp->type);
-		PRINTF_OUT("samplecount: %15u\n",samplecount);
-		PRINTF_OUT("samplesize:  %15u bytes\n",samplesize);
-		PRINTF_OUT("samplerate:  %15u Hz\n",samplerate);
-#endif
+	return 0;
+}
 
-		/* check size */
-		if (hdrsize+samplesize>fp->size){
-			PRINTF_ERR("invalid sample size\n");
-			goto akai_sample2wav_exit;
-		}
 
-		if (sizep!=NULL){
-			/* WAV file size */
-			*sizep=WAV_HEAD_SIZE+wavsamplesize;
+
+/* export only sample words begin...end-1 (end is limited to number of sample words) */
+/* Note: akai_sample2wav_probe() must have been successful before */
+/* Note: no sample header chunk in WAV file unless whole sample */
+int
+akai_sample2wav_setrange(struct akai_sample2wav_s *cp,u_int begin,u_int end,u_int *sizep)
+{
+
+	if ((cp==NULL)||(!cp->probed)){
+		return -1;
+	}
+
+	if (end>cp->samplecount){
+		end=cp->samplecount;
+	}
+	if (begin>end){
+		return -1;
+	}
+	cp->wavbegin=begin;
+	cp->wavend=end;
+
+	if (sizep!=NULL){
+		/* WAV file size */
+		*sizep=WAV_HEAD_SIZE+(end-begin)*2; /* *2 for 16bit per WAV sample word */
 #ifndef WAV_AKAIHEAD_DISABLE
-			*sizep+=sizeof(struct wav_chunkhead_s)+hdrsize; /* sample header chunk (see below) */
-#endif
+		if ((begin==0)&&(end==cp->samplecount)){
+			*sizep+=sizeof(struct wav_chunkhead_s)+cp->hdrsize; /* sample header chunk */
 		}
+#endif
+	}
 
-		/* create WAV name */
-		if ((fp->volp!=NULL)&&(fp->index<fp->volp->fimax)){
-			akai2ascii_name(fp->volp->file[fp->index].name,wavname,fp->volp->type==AKAI_VOL_TYPE_S900);
-			nlen=(u_int)strlen(wavname);
-		}else{
-			nlen=0;
-		}
-		bcopy(".wav",wavname+nlen,5);
+	return 0;
+}
 
-		if (wavnamep!=NULL){
-			/* pointer to name (wavname must be static!) */
-			*wavnamep=wavname;
-		}
+
+
+/* write WAV file (header, sample and sample header chunk) to wavfd */
+/* Note: akai_sample2wav_probe() must have been successful before */
+int
+akai_sample2wav_convert(struct akai_sample2wav_s *cp,int wavfd)
+{
+	struct file_s *fp;
+	u_int wavsize;
+	u_int wpos,wchunk;
+	u_int part;
+	u_int pbegin,pend;
+	int incomplete;
+	int headflag;
+	u_int i;
+
+	if ((cp==NULL)||(!cp->probed)){
+		return -1;
 	}
+	fp=&cp->file;
 
-	if (what&SAMPLE2WAV_EXPORT){
+	/* size in bytes */
+	wavsize=(cp->wavend-cp->wavbegin)*2; /* *2 for 16bit per WAV sample word */
+#ifndef WAV_AKAIHEAD_DISABLE
+	/* sample header chunk only for whole sample */
+	headflag=(cp->wavbegin==0)&&(cp->wavend==cp->samplecount);
+#else
+	headflag=0;
+#endif
 
-		if (wavsamplesize>0){
+	if ((wavsize>0)&&(fp->type==(u_char)AKAI_SAMPLE900_FTYPE)){ /* S900 sample? */
+		/* Note: constant buffer size, sample is converted and written in chunks (see below) */
+		/* Note: buffers are kept in context until akai_sample2wav_close() */
+		if (cp->wavbuf==NULL){
 			/* allocate WAV sample buffer */
-			wavbuf=(u_char *)malloc(wavsamplesize);
-			if (wavbuf==NULL){
+			cp->wavbuf=(u_char *)malloc(SAMPLE2WAV_CHUNKSIZE);
+			if (cp->wavbuf==NULL){
 				PRINTF_ERR("cannot allocate WAV buffer\n");
-				goto akai_sample2wav_exit;
+				return -1;
+			}
+		}
+		if (cp->sbuf==NULL){
+			/* allocate sample buffer */
+			/* Note: chunk of first and second part for S900 non-compressed sample format (3 bytes per 2 WAV bytes) */
+			cp->sbuf=(u_char *)malloc(SAMPLE2WAV_CHUNKSIZE+SAMPLE2WAV_CHUNKSIZE/2);
+			if (cp->sbuf==NULL){
+				PRINTF_ERR("cannot allocate sample buffer\n");
+				return -1;
 			}
+		}
+	}
 
-			if (fp->type==(u_char)AKAI_SAMPLE900_FTYPE){ /* S900 sample? */
-				/* allocate sample buffer */
-				sbuf=(u_char *)malloc(samplesize);
-				if (sbuf==NULL){
-					PRINTF_ERR("cannot allocate sample buffer\n");
-					goto akai_sample2wav_exit;
+	/* write WAV header */
+	if (wav_write_head(wavfd,
+					   wavsize,1,cp->samplerate,16, /* 1: mono, 16: 16bit */
+					   headflag?(sizeof(struct wav_chunkhead_s)+cp->hdrsize):0 /* sample header chunk (see below) */
+					   )<0){
+		PRINTF_ERR("cannot write WAV header\n");
+		return -1;
+	}
+
+	if (wavsize>0){
+		if (fp->type!=(u_char)AKAI_SAMPLE900_FTYPE){ /* S1000/S3000 sample? */
+			/* Note: no sample format conversion necessary for S1000/S3000 */
+			/* copy sample from file to WAV file */
+			if (akai_read_file(wavfd,NULL,fp,cp->hdrsize+cp->wavbegin*2,cp->hdrsize+cp->wavend*2)<0){
+				PRINTF_ERR("cannot write WAV samples\n");
+				return -1;
+			}
+		}else if (fp->osver==0){
+			/* S900 non-compressed sample format */
+			/* Note: first part in WAV is followed by second part in WAV */
+			/*       second part needs nibbles from first part in sample again */
+			for (part=0;part<2;part++){
+				/* sample words of part within range */
+				pbegin=part*cp->samplecountpart;
+				pend=pbegin+cp->samplecountpart;
+				if (pbegin<cp->wavbegin){
+					pbegin=cp->wavbegin;
+				}
+				if (pend>cp->wavend){
+					pend=cp->wavend;
+				}
+				if (pbegin>=pend){
+					continue; /* next part */
+				}
+				pbegin-=part*cp->samplecountpart;
+				pend-=part*cp->samplecountpart;
+				for (wpos=pbegin;wpos<pend;wpos+=wchunk){
+					/* number of sample words in chunk */
+					wchunk=pend-wpos;
+					if (wchunk>SAMPLE2WAV_CHUNKSIZE/2){ /* /2 for 16bit per WAV sample word */
+						wchunk=SAMPLE2WAV_CHUNKSIZE/2;
+					}
+					/* read piece of first part */
+					if (akai_read_file(0,cp->sbuf,fp,cp->hdrsize+wpos*2,cp->hdrsize+(wpos+wchunk)*2)<0){
+						PRINTF_ERR("cannot read sample\n");
+						return -1;
+					}
+					if (part==0){
+						/* convert S900 non-compressed sample format into 16bit WAV sample format */
+						akai_sample900noncompr_sample2wavpart(cp->sbuf,NULL,cp->wavbuf,wchunk);
+					}else{
+						/* read piece of second part */
+						if (akai_read_file(0,cp->sbuf+SAMPLE2WAV_CHUNKSIZE,fp,
+										   cp->hdrsize+cp->samplecountpart*2+wpos,
+										   cp->hdrsize+cp->samplecountpart*2+wpos+wchunk)<0){
+							PRINTF_ERR("cannot read sample\n");
+							return -1;
+						}
+						/* convert S900 non-compressed sample format into 16bit WAV sample format */
+						akai_sample900noncompr_sample2wavpart(cp->sbuf,cp->sbuf+SAMPLE2WAV_CHUNKSIZE,cp->wavbuf,wchunk);
+					}
+					/* write WAV sample to WAV file */
+					if (WRITE(wavfd,cp->wavbuf,wchunk*2)!=(int)(wchunk*2)){
+						PRINTF_ERR("cannot write WAV samples\n");
+						return -1;
+					}
 				}
-			}else{
-				/* Note: no sample format conversion necessary for S1000/S3000 */
-				sbuf=wavbuf;
 			}
-
-			/* read sample to memory */
-			if (akai_read_file(0,sbuf,fp,hdrsize,hdrsize+samplesize)<0){
-				PRINTF_ERR("cannot read sample\n");
-				goto akai_sample2wav_exit;
+		}else{
+			/* S900 compressed sample format */
+			/* Note: compressed sample is read via sbuf as window */
+			akai_sample900compr_bitrd_initfile(&cp->dec.rd,fp,cp->hdrsize,cp->hdrsize+cp->samplesize,cp->sbuf,SAMPLE2WAV_CHUNKSIZE);
+			akai_sample900compr_dec_init(&cp->dec,cp->samplesize);
+			if (cp->wavbegin>0){
+				/* Note: checkpoint index is kept in context until akai_sample2wav_close() */
+				if (cp->s9cidx.ckpt==NULL){
+					if (akai_sample900compr_index_build(&cp->s9cidx,&cp->dec,SAMPLE900COMPR_INDEX_GROUPSTEP)<0){
+						return -1;
+					}
+				}
+				if (akai_sample900compr_dec_seek(&cp->dec,&cp->s9cidx,cp->wavbegin)<0){
+					cp->dec.bitremain=0; /* behind end of compressed sample, zero padding (see below) */
+				}
 			}
-
-			if (fp->type==(u_char)AKAI_SAMPLE900_FTYPE){ /* S900 sample? */
-				if (fp->osver==0){
-					/* S900 non-compressed sample format */
-					/* convert S900 non-compressed sample format into 16bit WAV sample format */
-					akai_sample900noncompr_sample2wav(sbuf,wavbuf,samplecountpart);
-				}else{
-					/* S900 compressed sample format */
-					/* convert S900 compressed sample format into 16bit WAV sample format */
-					i=akai_sample900compr_sample2wav(sbuf,wavbuf,samplesize,wavsamplesize);
-					if (i<wavsamplesize){
+			incomplete=0;
+			for (wpos=0;wpos<wavsize;wpos+=wchunk){
+				/* number of bytes in chunk */
+				wchunk=wavsize-wpos;
+				if (wchunk>SAMPLE2WAV_CHUNKSIZE){
+					wchunk=SAMPLE2WAV_CHUNKSIZE;
+				}
+				/* convert S900 compressed sample format into 16bit WAV sample format */
+				i=akai_sample900compr_dec_run(&cp->dec,cp->wavbuf,wchunk);
+				if (cp->dec.rd.err){
+					PRINTF_ERR("cannot read sample\n");
+					return -1;
+				}
+				if (i<wchunk){
+					if (!incomplete){
 						PRINTF_ERR("warning: incomplete sample data\n");
-						/* zero padding */
-						bzero(wavbuf+i,wavsamplesize-i);
+						incomplete=1;
 					}
+					/* zero padding */
+					bzero(cp->wavbuf+i,wchunk-i);
+				}
+				/* write WAV sample to WAV file */
+				if (WRITE(wavfd,cp->wavbuf,wchunk)!=(int)wchunk){
+					PRINTF_ERR("cannot write WAV samples\n");
+					return -1;
 				}
-			}
-			/* Note: no sample format conversion necessary for S1000/S3000 */
-		}
-
-		if (what&SAMPLE2WAV_CREATE){
-			/* create WAV file */
-			if ((wavfd=OPEN(wavname,O_RDWR|O_CREAT|O_TRUNC|O_BINARY,0666))<0){
-				PERROR("create WAV");
-				goto akai_sample2wav_exit;
 			}
 		}
+	}
 
-		/* write WAV header */
-		if (wav_write_head(wavfd,
-						   wavsamplesize,1,samplerate,16, /* 1: mono, 16: 16bit */
 #ifndef WAV_AKAIHEAD_DISABLE
-						   sizeof(struct wav_chunkhead_s)+hdrsize /* sample header chunk (see below) */
-#else
-						   0
-#endif
-						   )<0){
-			PRINTF_ERR("cannot write WAV header\n");
-			goto akai_sample2wav_exit;
-		}
+	if (headflag){
+		struct wav_chunkhead_s wavchunkhead;
 
-		if (wavsamplesize>0){
-			/* write WAV sample to WAV file */
-			if (WRITE(wavfd,wavbuf,wavsamplesize)!=(int)wavsamplesize){
-				PRINTF_ERR("cannot write WAV samples\n");
-				goto akai_sample2wav_exit;
-			}
+		/* create sample header chunk */
+		if (fp->type==(u_char)AKAI_SAMPLE900_FTYPE){
+			/* S900 sample */
+			bcopy(WAV_CHUNKHEAD_AKAIS900SAMPLEHEADSTR,wavchunkhead.typestr,4);
+		}else if (fp->type==(u_char)AKAI_SAMPLE1000_FTYPE){
+			/* S1000 sample */
+			bcopy(WAV_CHUNKHEAD_AKAIS1000SAMPLEHEADSTR,wavchunkhead.typestr,4);
+		}else{
+			/* S3000 sample */
+			bcopy(WAV_CHUNKHEAD_AKAIS3000SAMPLEHEADSTR,wavchunkhead.typestr,4);
+		}
+		wavchunkhead.csize[0]=0xff&cp->hdrsize;
+		wavchunkhead.csize[1]=0xff&(cp->hdrsize>>8);
+		wavchunkhead.csize[2]=0xff&(cp->hdrsize>>16);
+		wavchunkhead.csize[3]=0xff&(cp->hdrsize>>24);
+		/* write WAV chunk header */
+		if (WRITE(wavfd,(u_char *)&wavchunkhead,sizeof(struct wav_chunkhead_s))!=(int)sizeof(struct wav_chunkhead_s)){
+			PRINTF_ERR("cannot write WAV chunk\n");
+			return -1;
 		}
-
-#ifndef WAV_AKAIHEAD_DISABLE
-		{
-			struct wav_chunkhead_s wavchunkhead;
-
-			/* create sample header chunk */
-			if (fp->type==(u_char)AKAI_SAMPLE900_FTYPE){
-				/* S900 sample */
-				bcopy(WAV_CHUNKHEAD_AKAIS900SAMPLEHEADSTR,wavchunkhead.typestr,4);
-			}else if (fp->type==(u_char)AKAI_SAMPLE1000_FTYPE){
-				/* S1000 sample */
-				bcopy(WAV_CHUNKHEAD_AKAIS1000SAMPLEHEADSTR,wavchunkhead.typestr,4);
-			}else{
-				/* S3000 sample */
-				bcopy(WAV_CHUNKHEAD_AKAIS3000SAMPLEHEADSTR,wavchunkhead.typestr,4);
-			}
-			wavchunkhead.csize[0]=0xff&hdrsize;
-			wavchunkhead.csize[1]=0xff&(hdrsize>>8);
-			wavchunkhead.csize[2]=0xff&(hdrsize>>16);
-			wavchunkhead.csize[3]=0xff&(hdrsize>>24);
-			/* write WAV chunk header */
-			if (WRITE(wavfd,(u_char *)&wavchunkhead,sizeof(struct wav_chunkhead_s))!=(int)sizeof(struct wav_chunkhead_s)){
-				PRINTF_ERR("cannot write WAV chunk\n");
-				goto akai_sample2wav_exit;
-			}
-			/* write sample header */
-			/* Note: use S3000 header as buffer for S900 header */
-			/* Note: S1000 header is contained within S3000 header */
-			if (WRITE(wavfd,(u_char *)&s3000hdr,hdrsize)!=(int)hdrsize){
-				PRINTF_ERR("cannot write WAV chunk\n");
-				goto akai_sample2wav_exit;
-			}
+		/* write sample header */
+		/* Note: use S3000 header as buffer for S900 header */
+		/* Note: S1000 header is contained within S3000 header */
+		if (WRITE(wavfd,(u_char *)&cp->s3000hdr,cp->hdrsize)!=(int)cp->hdrsize){
+			PRINTF_ERR("cannot write WAV chunk\n");
+			return -1;
 		}
+	}
 #endif
 #if 1
-		PRINTF_OUT("sample exported to WAV\n");
+	PRINTF_OUT("sample exported to WAV\n");
 #endif
+
+	return 0;
+}
+
+
+
+void
+akai_sample2wav_close(struct akai_sample2wav_s *cp)
+{
+
+	if (cp==NULL){
+		return;
 	}
 
-	ret=0; /* success */
+	if (cp->wavbuf!=NULL){
+		free(cp->wavbuf);
+		cp->wavbuf=NULL;
+	}
+	if (cp->sbuf!=NULL){
+		free(cp->sbuf);
+		cp->sbuf=NULL;
+	}
+	akai_sample900compr_index_free(&cp->s9cidx);
+	cp->probed=0;
+}
 
-akai_sample2wav_exit:
-	if (wavbuf!=NULL){
-		free(wavbuf);
+
+
+int
+akai_sample2wav(struct file_s *fp,int wavfd,u_int *sizep,char **wavnamep,int what)
+{
+	/* Note: static for multiple calls with different what */
+	static struct akai_sample2wav_s s2w;
+	int ret;
+
+	if (fp==NULL){
+		return -1;
 	}
-	if (fp->type==(u_char)AKAI_SAMPLE900_FTYPE){ /* S900 sample? */
-		if (sbuf!=NULL){
-			free(sbuf);
+
+	if (what&SAMPLE2WAV_CHECK){
+		akai_sample2wav_open(&s2w,fp);
+		ret=akai_sample2wav_probe(&s2w,sizep,wavnamep);
+		if (ret!=0){
+			akai_sample2wav_close(&s2w);
+			return ret;
 		}
 	}
-	if (what&SAMPLE2WAV_CREATE){
-		if (wavfd>=0){
+
+	ret=0; /* success so far */
+
+	if (what&SAMPLE2WAV_EXPORT){
+		if (what&SAMPLE2WAV_CREATE){
+			/* create WAV file */
+			if ((wavfd=OPEN(s2w.wavname,O_RDWR|O_CREAT|O_TRUNC|O_BINARY,0666))<0){
+				PERROR("create WAV");
+				akai_sample2wav_close(&s2w);
+				return -1;
+			}
+		}
+
+		ret=akai_sample2wav_convert(&s2w,wavfd);
+
+		if (what&SAMPLE2WAV_CREATE){
 			CLOSE(wavfd);
 		}
+		akai_sample2wav_close(&s2w);
 	}
+
 	return ret;
 }
 
 
 
+/* de-interleave WAV channel wavch and convert sample format into 16bit WAV sample format */
+static void
+akai_wav2sample_wav16(u_char *wavbuf16,u_char *wavbuf,u_int count,u_int wavchnr,u_int wavch,u_int wavbitnr)
+{
+	u_int i;
+
+	if (wavbitnr==8){
+		/* convert 8bit WAV sample format into 16bit WAV sample format */
+		for (i=0;i<count;i++){
+			wavbuf16[i*2+1]=0x80^wavbuf[wavchnr*i+wavch]; /* toggle sign bit */
+			wavbuf16[i*2+0]=0x00;
+		}
+	}else if (wavbitnr==16){
+		/* keep 16bit WAV sample format */
+		for (i=0;i<count;i++){
+			wavbuf16[i*2+0]=wavbuf[(wavchnr*i+wavch)*2+0];
+			wavbuf16[i*2+1]=wavbuf[(wavchnr*i+wavch)*2+1];
+		}
+	}else if (wavbitnr==24){
+		/* convert 24bit WAV sample format into 16bit WAV sample format */
+		for (i=0;i<count;i++){
+			/* Note: copy upper 16 bits, discard lower 8 bits */
+			wavbuf16[i*2+0]=wavbuf[(wavchnr*i+wavch)*3+1];
+			wavbuf16[i*2+1]=wavbuf[(wavchnr*i+wavch)*3+2];
+		}
+	}else if (wavbitnr==32){
+		/* convert 32bit WAV sample format into 16bit WAV sample format */
+		for (i=0;i<count;i++){
+			/* Note: copy upper 16 bits, discard lower 16 bits */
+			wavbuf16[i*2+0]=wavbuf[(wavchnr*i+wavch)*4+2];
+			wavbuf16[i*2+1]=wavbuf[(wavchnr*i+wavch)*4+3];
+		}
+	}
+}
+
 int
 akai_wav2sample(int wavfd,char *wavname,struct vol_s *volp,u_int findex,
 				u_int type,int s9cflag,u_int osver,u_char *tagp,
@@ -2308,6 +3039,7 @@ akai_wav2sample(int wavfd,char *wavname,struct vol_s *volp,u_int findex,
 {
 	/* Note: static for multiple calls with different what */
 	struct file_s tmpfile;
+	struct file_s sfile[2]; /* S1000/S3000 sample file per WAV channel */
 	struct akai_sample900_s s900hdr;
 	struct akai_sample3000_s s3000hdr;
 	static u_int hdrsize;
@@ -2316,12 +3048,19 @@ akai_wav2sample(int wavfd,char *wavname,struct vol_s *volp,u_int findex,
 	static u_int samplecountpart;
 	static u_int samplesize;
 	static u_char *sbuf;
+	static struct akai_sample900compr_enc_s s9cenc;
 	static u_int wavchnr;
 	static u_int wavbitnr;
+	static u_int wavftag;
+	static struct wav_conv_s wavconv;
 	static int wavmono16flag;
 	static u_int wavsamplesize;
+	static u_int wavbufsize;
 	static u_int wavsamplecount;
 	static u_int wavch;
+	static u_int wavdatabcount; /* bcount at start of WAV sample */
+	static u_int wavrdcount; /* bytes of WAV sample read while streaming */
+	static u_int wavpos,wavn;
 	static u_char *wavbuf16;
 	static u_int wavbuf16size;
 	static u_char *wavbuf;
@@ -2416,6 +3155,8 @@ akai_wav2sample(int wavfd,char *wavname,struct vol_s *volp,u_int findex,
 	wavbuf16=NULL; /* not allocated yet */
 	wavbuf=NULL; /* not allocated yet */
 	sbuf=NULL; /* not allocated yet */
+	akai_sample900compr_enc_init(&s9cenc); /* not allocated yet */
+	wav_conv_free(&wavconv); /* not allocated yet */
 	ret=-1; /* no success so far */
 	bcount=0; /* no bytes read yet */
 
@@ -2430,6 +3171,7 @@ akai_wav2sample(int wavfd,char *wavname,struct vol_s *volp,u_int findex,
 	/* read and parse WAV header */
 	if (wav_read_head(wavfd,&bcount,
 							&wavsamplesize,&wavchnr,&samplerate,&wavbitnr,
+							&wavftag,
 #ifndef WAV_AKAIHEAD_DISABLE
 							&extrasize,
 #else
@@ -2450,22 +3192,39 @@ akai_wav2sample(int wavfd,char *wavname,struct vol_s *volp,u_int findex,
 		ret=1; /* no error */
 		goto akai_wav2sample_exit;
 	}
-	if ((wavbitnr!=8)&&(wavbitnr!=16)&&(wavbitnr!=24)&&(wavbitnr!=32)){
-		PRINTF_ERR("invalid WAV format, must be 8bit or 16bit or 24bit or 32bit PCM\n");
+
+	/* sample rate and sample format conversion if necessary */
+	/* Note: S900 sample has 12bit resolution */
+	r=wav_conv_init(&wavconv,wavfd,wavsamplesize,wavchnr,wavbitnr,wavftag,
+					samplerate,wav_conv_samprate,(type==AKAI_SAMPLE900_FTYPE)?12:16,wav_conv_dither);
+	if (r<0){
+		goto akai_wav2sample_exit;
+	}
+	if (r>0){
+		PRINTF_ERR("invalid WAV format, must be 8bit or 16bit or 24bit or 32bit PCM or 32bit or 64bit float\n");
 		/* unknown or unsupported */
 		ret=1; /* no error */
 		goto akai_wav2sample_exit;
 	}
+	if (wavconv.active){
+		/* Note: WAV sample will be converted into 16bit while reading */
+		samplerate=wavconv.outrate;
+		wavbitnr=16;
+		/* number of samples after conversion (per channel) */
+		wavsamplecount=wavconv.outcount;
+		wavbufsize=wavsamplecount*wavchnr*2;
+	}else{
+		/* number of samples in WAV file (per channel) */
+		/* Note: can be an odd number */
+		wavsamplecount=wavsamplesize/(wavchnr*(wavbitnr/8));
+		wavbufsize=wavsamplesize;
+	}
 	if ((wavchnr==1)&&(wavbitnr==16)){
 		/* WAV file is mono 16bit */
 		wavmono16flag=1;
 	}else{
 		wavmono16flag=0;
 	}
-
-	/* number of samples in WAV file (per channel) */
-	/* Note: can be an odd number */
-	wavsamplecount=wavsamplesize/(wavchnr*(wavbitnr/8));
 #if 0
 	if (wavsamplecount==0){
 		PRINTF_ERR("no samples in WAV file\n");
@@ -2493,49 +3252,67 @@ akai_wav2sample(int wavfd,char *wavname,struct vol_s *volp,u_int findex,
 			samplesize=samplecount*2; /* *2 for 16bit per sample word */
 		}
 
-		/* allocate WAV 16bit sample buffer */
-		wavbuf16size=2*samplecount; /* *2 for 16bit per sample word in wavbuf16 */
-		if (wavmono16flag&&(wavbuf16size<wavsamplesize)){
-			/* Note: need at least wavsamplesize for wavbuf==wavbuf16 below */
-			wavbuf16size=wavsamplesize;
-		}
-		wavbuf16=(u_char *)malloc(wavbuf16size);
-		if (wavbuf16==NULL){
-			PRINTF_ERR("cannot allocate WAV 16bit buffer\n");
-			goto akai_wav2sample_exit;
-		}
 		if (type!=AKAI_SAMPLE900_FTYPE){ /* S1000/S3000 sample? */
-			/* use wavbuf16 as sample buffer */
-			sbuf=wavbuf16;
-		}
-		/* Note: for S900 sample, sbuf will be allocated below */
-
-		/* WAV sample buffer */
-		if (wavmono16flag){ /* WAV file is mono 16bit? */
-			/* use wavbuf16 as WAV sample buffer */
-			wavbuf=wavbuf16;
+			/* Note: WAV sample is streamed in chunks into sample file(s) after they have been created (see below), */
+			/*       skip it for now, sample header chunk in WAV file is behind it */
+			/* Note: LSEEK64 might not return file position, use relative positions */
+			wavdatabcount=bcount;
+			if (LSEEK64(wavfd,(OFF64_T)wavsamplesize,SEEK_CUR)<0){
+				PERROR("lseek");
+				goto akai_wav2sample_exit;
+			}
+			bcount+=wavsamplesize;
 		}else{
-			/* allocate WAV sample buffer */
-			wavbuf=(u_char *)malloc(wavsamplesize);
-			if (wavbuf==NULL){
-				PRINTF_ERR("cannot allocate WAV buffer\n");
+			/* S900 sample */
+			/* Note: S900 sample is converted as a whole (two parts, S900 compressed sample format needs two passes) */
+			/* allocate WAV 16bit sample buffer */
+			wavbuf16size=2*samplecount; /* *2 for 16bit per sample word in wavbuf16 */
+			if (wavmono16flag&&(wavbuf16size<wavbufsize)){
+				/* Note: need at least wavbufsize for wavbuf==wavbuf16 below */
+				wavbuf16size=wavbufsize;
+			}
+			wavbuf16=(u_char *)malloc(wavbuf16size);
+			if (wavbuf16==NULL){
+				PRINTF_ERR("cannot allocate WAV 16bit buffer\n");
 				goto akai_wav2sample_exit;
 			}
-		}
+			/* Note: sbuf will be allocated below */
 
-		/* read WAV sample to memory */
-		if (READ(wavfd,wavbuf,wavsamplesize)!=(int)wavsamplesize){
-			PRINTF_ERR("cannot read sample\n");
-			goto akai_wav2sample_exit;
-		}
-		bcount+=wavsamplesize;
+			/* WAV sample buffer */
+			if (wavmono16flag){ /* WAV file is mono 16bit? */
+				/* use wavbuf16 as WAV sample buffer */
+				wavbuf=wavbuf16;
+			}else{
+				/* allocate WAV sample buffer */
+				wavbuf=(u_char *)malloc(wavbufsize);
+				if (wavbuf==NULL){
+					PRINTF_ERR("cannot allocate WAV buffer\n");
+					goto akai_wav2sample_exit;
+				}
+			}
 
-		/* zero padding if necessary */
-		/* Note: must be after READ to wavbuf for case that wavbuf==wavbuf16 */
-		if (samplecount>wavsamplecount){
-			/* 16bit sample word */
-			wavbuf16[wavsamplecount*2+1]=0x00;
-			wavbuf16[wavsamplecount*2+0]=0x00;
+			/* read WAV sample to memory */
+			if (wavconv.active){
+				/* convert while reading in chunks */
+				if (wav_conv_read(&wavconv,wavbuf,wavsamplecount)<0){
+					PRINTF_ERR("cannot convert sample\n");
+					goto akai_wav2sample_exit;
+				}
+			}else{
+				if (READ(wavfd,wavbuf,wavsamplesize)!=(int)wavsamplesize){
+					PRINTF_ERR("cannot read sample\n");
+					goto akai_wav2sample_exit;
+				}
+			}
+			bcount+=wavsamplesize;
+
+			/* zero padding if necessary */
+			/* Note: must be after READ to wavbuf for case that wavbuf==wavbuf16 */
+			if (samplecount>wavsamplecount){
+				/* 16bit sample word */
+				wavbuf16[wavsamplecount*2+1]=0x00;
+				wavbuf16[wavsamplecount*2+0]=0x00;
+			}
 		}
 	}else{
 		samplecountpart=0;
@@ -2627,6 +3404,11 @@ akai_wav2sample(int wavfd,char *wavname,struct vol_s *volp,u_int findex,
 		if ((wavakaiheadtype==(int)wavakaiheadsearchtype)&&(wavakaiheadsize==hdrsize)){
 			/* found matching sample header chunk */
 			wavakaiheadfound=1;
+			if (wavconv.active&&(wavconv.outrate!=wavconv.inrate)){
+				/* Note: sample positions in header do not match converted sample rate */
+				PRINTF_OUT("sample header in WAV ignored due to sample rate conversion\n");
+				wavakaiheadfound=0;
+			}
 		}else{
 			wavakaiheadfound=0;
 		}
@@ -2734,42 +3516,16 @@ akai_wav2sample(int wavfd,char *wavname,struct vol_s *volp,u_int findex,
 	wavch=0;
 	for (;;){
 		if (wavsamplecount>0){
-			if (!wavmono16flag){ /* WAV file is not mono 16bit? */
+			if ((type==AKAI_SAMPLE900_FTYPE)&&(!wavmono16flag)){ /* S900 sample and WAV file is not mono 16bit? */
 				/* de-interleave WAV channels and convert sample format */
-				if (wavbitnr==8){
-					/* convert 8bit WAV sample format into 16bit WAV sample format */
-					for (i=0;i<wavsamplecount;i++){
-						wavbuf16[i*2+1]=0x80^wavbuf[wavchnr*i+wavch]; /* toggle sign bit */
-						wavbuf16[i*2+0]=0x00;
-					}
-				}else if (wavbitnr==16){
-					/* keep 16bit WAV sample format */
-					for (i=0;i<wavsamplecount;i++){
-						wavbuf16[i*2+0]=wavbuf[(wavchnr*i+wavch)*2+0];
-						wavbuf16[i*2+1]=wavbuf[(wavchnr*i+wavch)*2+1];
-					}
-				}else if (wavbitnr==24){
-					/* convert 24bit WAV sample format into 16bit WAV sample format */
-					for (i=0;i<wavsamplecount;i++){
-						/* Note: copy upper 16 bits, discard lower 8 bits */
-						wavbuf16[i*2+0]=wavbuf[(wavchnr*i+wavch)*3+1];
-						wavbuf16[i*2+1]=wavbuf[(wavchnr*i+wavch)*3+2];
-					}
-				}else if (wavbitnr==32){
-					/* convert 32bit WAV sample format into 16bit WAV sample format */
-					for (i=0;i<wavsamplecount;i++){
-						/* Note: copy upper 16 bits, discard lower 16 bits */
-						wavbuf16[i*2+0]=wavbuf[(wavchnr*i+wavch)*4+2];
-						wavbuf16[i*2+1]=wavbuf[(wavchnr*i+wavch)*4+3];
-					}
-				}
-			} /* Note: else: wavbuf==wavbuf16 */
+				akai_wav2sample_wav16(wavbuf16,wavbuf,wavsamplecount,wavchnr,wavch,wavbitnr);
+			} /* Note: else: wavbuf==wavbuf16 or S1000/S3000 sample (see below) */
 
 			if ((type==AKAI_SAMPLE900_FTYPE)&&s9cflag){ /* S900 compressed sample format? */
 				/* determine sample size */
 				/* first pass to convert 16bit WAV sample format into S900 compressed sample format */
 				/* Note: first pass of akai_sample900compr_wav2sample() requires 16bit WAV sample to be loaded to wavbuf16 */
-				r=akai_sample900compr_wav2sample(NULL,wavbuf16,samplecountpart); /* NULL: first pass */
+				r=akai_sample900compr_wav2sample(&s9cenc,NULL,wavbuf16,samplecountpart); /* NULL: first pass */
 				if (r<0){
 					goto akai_wav2sample_exit;
 				}
@@ -2846,13 +3602,19 @@ akai_wav2sample(int wavfd,char *wavname,struct vol_s *volp,u_int findex,
 			if (wavsamplecount>0){
 				if (s9cflag){
 					/* second pass to convert 16bit WAV sample format into S900 compressed sample format */
-					if (akai_sample900compr_wav2sample(sbuf,wavbuf16,samplecountpart)<0){ /* sbuf!=NULL: second pass */
+					if (akai_sample900compr_wav2sample(&s9cenc,sbuf,wavbuf16,samplecountpart)<0){ /* sbuf!=NULL: second pass */
 						goto akai_wav2sample_exit;
 					}
 				}else{
 					/* convert 16bit WAV sample format into S900 non-compressed sample format */
 					akai_sample900noncompr_wav2sample(sbuf,wavbuf16,samplecountpart);
 				}
+
+				/* write sample */
+				if (akai_write_file(0,sbuf,&tmpfile,hdrsize,hdrsize+samplesize)<0){
+					PRINTF_ERR("cannot write sample\n");
+					goto akai_wav2sample_exit;
+				}
 			}
 		}else{
 			/* S1000/S3000 sample */
@@ -2867,26 +3629,21 @@ akai_wav2sample(int wavfd,char *wavname,struct vol_s *volp,u_int findex,
 				goto akai_wav2sample_exit;
 			}
 
-			/* Note: sbuf==wavbuf16 for S1000/S3000 sample */
-		}
-
-		if (wavsamplecount>0){
-			/* write sample */
-			if (akai_write_file(0,sbuf,&tmpfile,hdrsize,hdrsize+samplesize)<0){
-				PRINTF_ERR("cannot write sample\n");
-				goto akai_wav2sample_exit;
-			}
+			/* Note: sample will be written below */
+			bcopy(&tmpfile,&sfile[wavch],sizeof(struct file_s));
 		}
 
-		if (wavchnr==1){ /* mono? */
+		if ((type==AKAI_SAMPLE900_FTYPE)||(wavsamplecount==0)){ /* sample done? */
+			if (wavchnr==1){ /* mono? */
 #if 1
-			PRINTF_OUT("sample imported from WAV\n");
+				PRINTF_OUT("sample imported from WAV\n");
 #endif
-			break; /* done */
-		} /* else: stereo */
+			}else{
 #if 1
-		PRINTF_OUT("%s sample imported from WAV\n",(wavch==0)?"left":"right");
+				PRINTF_OUT("%s sample imported from WAV\n",(wavch==0)?"left":"right");
 #endif
+			}
+		}
 
 		/* next WAV channel */
 		wavch++;
@@ -2901,15 +3658,88 @@ akai_wav2sample(int wavfd,char *wavname,struct vol_s *volp,u_int findex,
 				free(sbuf);
 				sbuf=NULL;
 			}
-			if (s9cflag){
-				akai_sample900compr_wav2sample(NULL,NULL,0); /* NULL,NULL: free buffers if still allocated */
+			/* Note: keep buffers of s9cenc for next channel */
+		}
+	}
+
+	if ((type!=AKAI_SAMPLE900_FTYPE)&&(wavsamplecount>0)){
+		/* S1000/S3000 sample: stream WAV sample in chunks into sample file(s) */
+		/* Note: return to WAV sample, afterwards continue behind part of WAV file read so far */
+		/* Note: LSEEK64 might not return file position, backward distance fits into OFF_T (see READ size) */
+		if (LSEEK(wavfd,-(OFF_T)(bcount-wavdatabcount),SEEK_CUR)<0){
+			PERROR("lseek");
+			goto akai_wav2sample_exit;
+		}
+		/* allocate buffers for one chunk */
+		wavbuf16=(u_char *)malloc(2*WAV2SAMPLE_CHUNKFRAMES); /* *2 for 16bit per sample word */
+		if (wavbuf16==NULL){
+			PRINTF_ERR("cannot allocate WAV 16bit buffer\n");
+			goto akai_wav2sample_exit;
+		}
+		if (wavmono16flag){ /* WAV file is mono 16bit? */
+			/* use wavbuf16 as WAV sample buffer */
+			wavbuf=wavbuf16;
+		}else{
+			wavbuf=(u_char *)malloc(WAV2SAMPLE_CHUNKFRAMES*wavchnr*(wavbitnr/8));
+			if (wavbuf==NULL){
+				PRINTF_ERR("cannot allocate WAV buffer\n");
+				goto akai_wav2sample_exit;
+			}
+		}
+		wavrdcount=0;
+		for (wavpos=0;wavpos<wavsamplecount;wavpos+=wavn){
+			wavn=wavsamplecount-wavpos;
+			if (wavn>WAV2SAMPLE_CHUNKFRAMES){
+				wavn=WAV2SAMPLE_CHUNKFRAMES;
+			}
+			/* read chunk of WAV sample */
+			if (wavconv.active){
+				/* convert while reading */
+				if (wav_conv_read(&wavconv,wavbuf,wavn)<0){
+					PRINTF_ERR("cannot convert sample\n");
+					goto akai_wav2sample_exit;
+				}
+				if (wavpos+wavn==wavsamplecount){
+					/* Note: wav_conv_read() has skipped rest of WAV sample */
+					wavrdcount=wavsamplesize;
+				}
+			}else{
+				if (READ(wavfd,wavbuf,wavn*wavchnr*(wavbitnr/8))!=(int)(wavn*wavchnr*(wavbitnr/8))){
+					PRINTF_ERR("cannot read sample\n");
+					goto akai_wav2sample_exit;
+				}
+				wavrdcount+=wavn*wavchnr*(wavbitnr/8);
+			}
+			for (wavch=0;wavch<wavchnr;wavch++){
+				if (!wavmono16flag){ /* WAV file is not mono 16bit? */
+					/* de-interleave WAV channels and convert sample format */
+					akai_wav2sample_wav16(wavbuf16,wavbuf,wavn,wavchnr,wavch,wavbitnr);
+				} /* Note: else: wavbuf==wavbuf16 */
+				/* write chunk of sample */
+				if (akai_write_file(0,wavbuf16,&sfile[wavch],hdrsize+2*wavpos,hdrsize+2*(wavpos+wavn))<0){
+					PRINTF_ERR("cannot write sample\n");
+					goto akai_wav2sample_exit;
+				}
 			}
 		}
+		if (LSEEK64(wavfd,(OFF64_T)(bcount-wavdatabcount)-(OFF64_T)wavrdcount,SEEK_CUR)<0){
+			PERROR("lseek");
+			goto akai_wav2sample_exit;
+		}
+#if 1
+		if (wavchnr==1){ /* mono? */
+			PRINTF_OUT("sample imported from WAV\n");
+		}else{
+			PRINTF_OUT("left sample imported from WAV\n");
+			PRINTF_OUT("right sample imported from WAV\n");
+		}
+#endif
 	}
 
 	ret=0; /* success */
 
 akai_wav2sample_exit:
+	wav_conv_free(&wavconv);
 	if (wavbuf16!=NULL){
 		free(wavbuf16);
 	}
@@ -2921,7 +3751,7 @@ akai_wav2sample_exit:
 			free(sbuf);
 		}
 		if (s9cflag){
-			akai_sample900compr_wav2sample(NULL,NULL,0); /* NULL,NULL: free buffers if still allocated */
+			akai_sample900compr_wav2sample(&s9cenc,NULL,NULL,0); /* NULL,NULL: free buffers if still allocated */
 		}
 	}
 	if (what&WAV2SAMPLE_OPEN){
@@ -82,6 +82,72 @@ struct akai_sample900_s{
 #define SAMPLE900COMPR_BITMASK				(SAMPLE900COMPR_INTERVALSIZ-1)  /* bit mask for interval */
 #define SAMPLE900COMPR_INTERVALSIZ2			(SAMPLE900COMPR_INTERVALSIZ>>1) /* half interval size */
 
+/* bit reader for S900 compressed sample format */
+struct akai_sample900compr_bitrd_s{
+	u_char *buf;    /* input buffer */
+	u_int bufsiz;   /* size of input buffer in bytes */
+	u_int bytepos;  /* next byte to be loaded from buffer */
+	U_INT64 acc;    /* bit accumulator, Note: upper bit first, left-aligned */
+	u_int accbits;  /* number of valid bits in acc */
+	/* optional: refill buffer from file */
+	struct file_s *fp; /* file (or NULL if buffer only) */
+	u_int fbegin;   /* begin byte position in file */
+	u_int fpos;     /* next byte position in file */
+	u_int fend;     /* end byte position in file */
+	u_int bufmax;   /* max. size of input buffer in bytes */
+	int err;        /* read error occurred */
+};
+
+/* bytes of 16bit WAV sample per chunk in akai_sample2wav() */
+#define SAMPLE2WAV_CHUNKSIZE	AKAI_FILE_RUNSIZE /* Note: must be even */
+
+/* state of S900 decompressor */
+struct akai_sample900compr_dec_s{
+	struct akai_sample900compr_bitrd_s rd;
+	u_int bitremain; /* remaining bits of compressed sample */
+	short curval;
+	short curinc;
+	u_char upbitnum; /* number of bits for upabsval in current group */
+	u_int upsigns;   /* sign flag bits of current group */
+	u_int gi;        /* index of next sample word in current group */
+};
+
+/* checkpoint of S900 decompressor at start of group */
+struct akai_sample900compr_ckpt_s{
+	u_int bitpos;  /* bit position of code nibble in compressed sample */
+	short curval;
+	short curinc;
+};
+
+/* groups per checkpoint */
+#define SAMPLE900COMPR_INDEX_GROUPSTEP	256
+
+/* checkpoint index of S900 compressed sample */
+struct akai_sample900compr_index_s{
+	u_int bitnum;     /* size of compressed sample in bits */
+	u_int groupstep;  /* groups per checkpoint */
+	u_int ckptnum;    /* number of checkpoints */
+	struct akai_sample900compr_ckpt_s *ckpt; /* checkpoint i at start of group i*groupstep */
+	u_int samplecount; /* number of decodable sample words */
+};
+
+/* bit writer for S900 compressed sample format */
+struct akai_sample900compr_bitwr_s{
+	u_char *buf;    /* output buffer */
+	u_int bytepos;  /* next byte to be stored to buffer */
+	U_INT64 acc;    /* bit accumulator, Note: upper bit first, left-aligned */
+	u_int accbits;  /* number of valid bits in acc */
+};
+
+/* state of S900 compressor (between first and second pass) */
+struct akai_sample900compr_enc_s{
+	u_char *upbitnumbuf;  /* number of bits for upabsval per group */
+	u_int *upsignbuf;     /* sign flag bits per group */
+	u_short *upabsvalbuf; /* upabsval per sample word */
+	u_int groupcount;     /* number of groups */
+	u_int groupcountmax;  /* number of groups allocated in buffers */
+};
+
 #define AKAI_SAMPLE900_FTYPE	'S' /* file type */
 
 
@@ -536,24 +602,66 @@ extern int akai_s900comprfile_updateuncompr(struct file_s *fp);
 extern u_int akai_sample900_getsamplesize(struct file_s *fp);
 
 extern void akai_sample900noncompr_sample2wav(u_char *sbuf,u_char *wavbuf,u_int samplecountpart);
+extern void akai_sample900noncompr_sample2wavpart(u_char *sbuf1,u_char *sbuf2,u_char *wavbuf,u_int samplecount);
 extern void akai_sample900noncompr_wav2sample(u_char *sbuf,u_char *wavbuf,u_int samplecountpart);
 
 extern u_int akai_sample900compr_getbits(u_char *buf,u_int bitpos,u_int bitnum);
+extern void akai_sample900compr_bitrd_init(struct akai_sample900compr_bitrd_s *rp,u_char *buf,u_int bufsiz);
+extern void akai_sample900compr_bitrd_initfile(struct akai_sample900compr_bitrd_s *rp,struct file_s *fp,u_int begin,u_int end,u_char *buf,u_int bufmax);
+extern void akai_sample900compr_bitrd_fill(struct akai_sample900compr_bitrd_s *rp);
+extern u_int akai_sample900compr_bitrd_get(struct akai_sample900compr_bitrd_s *rp,u_int bitnum);
+extern void akai_sample900compr_bitrd_seek(struct akai_sample900compr_bitrd_s *rp,u_int bitpos);
+extern void akai_sample900compr_dec_init(struct akai_sample900compr_dec_s *dp,u_int sbufsiz);
+extern u_int akai_sample900compr_dec_run(struct akai_sample900compr_dec_s *dp,u_char *wavbuf,u_int wavbufsiz);
+extern int akai_sample900compr_dec_skipgroup(struct akai_sample900compr_dec_s *dp);
+extern int akai_sample900compr_index_build(struct akai_sample900compr_index_s *ip,struct akai_sample900compr_dec_s *dp,u_int groupstep);
+extern void akai_sample900compr_index_free(struct akai_sample900compr_index_s *ip);
+extern int akai_sample900compr_dec_seek(struct akai_sample900compr_dec_s *dp,struct akai_sample900compr_index_s *ip,u_int samplepos);
 extern u_int akai_sample900compr_sample2wav(u_char *sbuf,u_char *wavbuf,u_int sbufsiz,u_int wavbufsiz);
 extern void akai_sample900compr_setbits(u_char *buf,u_int bitpos,u_int bitnum,u_int val);
-extern int akai_sample900compr_wav2sample(u_char *sbuf,u_char *wavbuf,u_int samplecountpart);
+extern void akai_sample900compr_bitwr_init(struct akai_sample900compr_bitwr_s *wp,u_char *buf);
+extern void akai_sample900compr_bitwr_put(struct akai_sample900compr_bitwr_s *wp,u_int bitnum,u_int val);
+extern u_int akai_sample900compr_bitwr_flush(struct akai_sample900compr_bitwr_s *wp);
+extern void akai_sample900compr_enc_init(struct akai_sample900compr_enc_s *ep);
+extern int akai_sample900compr_wav2sample(struct akai_sample900compr_enc_s *ep,u_char *sbuf,u_char *wavbuf,u_int samplecountpart);
 
 extern int akai_sample900_noncompr2compr(struct file_s *fp,struct vol_s *volp);
 extern int akai_sample900_compr2noncompr(struct file_s *fp,struct vol_s *volp);
 
+/* context for conversion of sample into WAV file */
+struct akai_sample2wav_s{
+	struct file_s file; /* copy of sample file */
+	struct akai_sample3000_s s3000hdr; /* Note: also used as buffer for S900 header */
+	u_int hdrsize;
+	u_int samplecount;
+	u_int samplecountpart;
+	u_int samplesize;
+	u_int samplerate;
+	u_int wavsamplesize;
+	char wavname[AKAI_NAME_LEN+4+1]; /* name (ASCII), +4 for ".<type>", +1 for '\0' */
+	int probed; /* header has been read and checked */
+	u_char *sbuf; /* sample buffer for one chunk */
+	u_char *wavbuf; /* WAV buffer for one chunk */
+	struct akai_sample900compr_dec_s dec; /* S900 decompressor */
+	struct akai_sample900compr_index_s s9cidx; /* checkpoint index for S900 compressed sample, built on demand */
+	u_int wavbegin; /* first sample word to export */
+	u_int wavend;   /* end sample word to export */
+};
+
 #define SAMPLE2WAV_CHECK		1
 #define SAMPLE2WAV_EXPORT		2
 #define SAMPLE2WAV_CREATE		4
 #define SAMPLE2WAV_ALL			0xff
+extern int akai_sample2wav_open(struct akai_sample2wav_s *cp,struct file_s *fp);
+extern int akai_sample2wav_probe(struct akai_sample2wav_s *cp,u_int *sizep,char **wavnamep);
+extern int akai_sample2wav_setrange(struct akai_sample2wav_s *cp,u_int begin,u_int end,u_int *sizep);
+extern int akai_sample2wav_convert(struct akai_sample2wav_s *cp,int wavfd);
+extern void akai_sample2wav_close(struct akai_sample2wav_s *cp);
 extern int akai_sample2wav(struct file_s *fp,int wavfd,u_int *sizep,char **wavnamep,int what);
 
 #define WAV2SAMPLE_OPEN			1
 #define WAV2SAMPLE_OVERWRITE	2
+#define WAV2SAMPLE_CHUNKFRAMES	(64*1024) /* WAV frames per chunk for S1000/S3000 sample, which is streamed */
 extern int akai_wav2sample(int wavfd,char *wavname,struct vol_s *volp,u_int findex,
 						   u_int type,int s9cflag,u_int osver,u_char *tagp,
 						   u_int *bcountp,int what);
@@ -0,0 +1,172 @@
+/*
+* Copyright (C) 2008-2022 Klaus Michael Indlekofer. All rights reserved.
+*
+* m.indlekofer@gmx.de
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*/
+
+
+
+/* test: S900 non-compressed sample conversion against reference loops */
+
+#include "commoninclude.h"
+#include "akaiutil.h"
+#include "akaiutil_file.h"
+
+
+
+#define TEST_SAMPLECOUNTPART_MAX	300 /* all counts below, incl. odd ones */
+#define TEST_SAMPLECOUNTPART_BIG	65537 /* one large odd count */
+
+
+
+/* reference: original per-part loops */
+
+static void
+ref_sample2wav(u_char *sbuf,u_char *wavbuf,u_int samplecountpart)
+{
+	u_int i;
+
+	for (i=0;i<samplecountpart;i++){ /* first part */
+		wavbuf[i*2+1]=sbuf[i*2+1];
+		wavbuf[i*2+0]=0xf0&sbuf[i*2+0];
+	}
+	for (i=0;i<samplecountpart;i++){ /* second part */
+		wavbuf[samplecountpart*2+i*2+1]=sbuf[samplecountpart*2+i];
+		wavbuf[samplecountpart*2+i*2+0]=0xf0&(sbuf[i*2+0]<<4);
+	}
+}
+
+static void
+ref_wav2sample(u_char *sbuf,u_char *wavbuf,u_int samplecountpart)
+{
+	u_int i;
+
+	for (i=0;i<samplecountpart;i++){ /* first part */
+		sbuf[i*2+1]=wavbuf[i*2+1];
+		sbuf[i*2+0]=0xf0&wavbuf[i*2+0];
+	}
+	for (i=0;i<samplecountpart;i++){ /* second part */
+		sbuf[samplecountpart*2+i]=wavbuf[samplecountpart*2+i*2+1];
+		sbuf[i*2+0]|=0x0f&(wavbuf[samplecountpart*2+i*2+0]>>4);
+	}
+}
+
+
+
+static void
+fill_random(u_char *buf,u_int size)
+{
+	u_int i;
+
+	for (i=0;i<size;i++){
+		buf[i]=(u_char)(rand()>>7);
+	}
+}
+
+static int
+test_count(u_int samplecountpart,u_char *sbuf,u_char *sbufref,u_char *wavbuf,u_char *wavbufref)
+{
+	u_int ssize,wsize;
+	int err;
+
+	ssize=3*samplecountpart;
+	wsize=4*samplecountpart;
+	err=0;
+
+	/* sample2wav */
+	fill_random(sbuf,ssize);
+	fill_random(wavbuf,wsize);
+	bcopy(wavbuf,wavbufref,wsize);
+	akai_sample900noncompr_sample2wav(sbuf,wavbuf,samplecountpart);
+	ref_sample2wav(sbuf,wavbufref,samplecountpart);
+	if (memcmp(wavbuf,wavbufref,wsize)!=0){
+		PRINTF_ERR("sample2wav mismatch for samplecountpart=%u\n",samplecountpart);
+		err=1;
+	}
+
+	/* sample2wavpart, both parts */
+	fill_random(wavbuf,wsize);
+	akai_sample900noncompr_sample2wavpart(sbuf,NULL,wavbuf,samplecountpart);
+	akai_sample900noncompr_sample2wavpart(sbuf,sbuf+2*samplecountpart,wavbuf+2*samplecountpart,samplecountpart);
+	if (memcmp(wavbuf,wavbufref,wsize)!=0){
+		PRINTF_ERR("sample2wavpart mismatch for samplecountpart=%u\n",samplecountpart);
+		err=1;
+	}
+
+	/* wav2sample */
+	fill_random(wavbuf,wsize);
+	fill_random(sbuf,ssize);
+	bcopy(sbuf,sbufref,ssize);
+	akai_sample900noncompr_wav2sample(sbuf,wavbuf,samplecountpart);
+	ref_wav2sample(sbufref,wavbuf,samplecountpart);
+	if (memcmp(sbuf,sbufref,ssize)!=0){
+		PRINTF_ERR("wav2sample mismatch for samplecountpart=%u\n",samplecountpart);
+		err=1;
+	}
+
+	/* round trip */
+	akai_sample900noncompr_sample2wav(sbuf,wavbuf,samplecountpart);
+	akai_sample900noncompr_wav2sample(sbufref,wavbuf,samplecountpart);
+	if (memcmp(sbuf,sbufref,ssize)!=0){
+		PRINTF_ERR("round trip mismatch for samplecountpart=%u\n",samplecountpart);
+		err=1;
+	}
+
+	return err;
+}
+
+int
+main(int argc,char **argv)
+{
+	u_char *sbuf,*sbufref;
+	u_char *wavbuf,*wavbufref;
+	u_int n;
+	int err;
+
+	(void)argc;
+	(void)argv;
+
+	sbuf=(u_char *)malloc(3*TEST_SAMPLECOUNTPART_BIG);
+	sbufref=(u_char *)malloc(3*TEST_SAMPLECOUNTPART_BIG);
+	wavbuf=(u_char *)malloc(4*TEST_SAMPLECOUNTPART_BIG);
+	wavbufref=(u_char *)malloc(4*TEST_SAMPLECOUNTPART_BIG);
+	if ((sbuf==NULL)||(sbufref==NULL)||(wavbuf==NULL)||(wavbufref==NULL)){
+		PRINTF_ERR("cannot allocate memory\n");
+		return 1;
+	}
+
+	srand(900); /* reproducible */
+	err=0;
+	for (n=0;n<TEST_SAMPLECOUNTPART_MAX;n++){
+		err|=test_count(n,sbuf,sbufref,wavbuf,wavbufref);
+	}
+	err|=test_count(TEST_SAMPLECOUNTPART_BIG,sbuf,sbufref,wavbuf,wavbufref);
+
+	free(sbuf);
+	free(sbufref);
+	free(wavbuf);
+	free(wavbufref);
+
+	if (err){
+		PRINTF_ERR("S900 non-compressed sample conversion: FAILED\n");
+		return 1;
+	}
+	PRINTF_OUT("S900 non-compressed sample conversion: OK\n");
+	return 0;
+}
+
+/* EOF */
@@ -20,8 +20,17 @@
 
 
 
+#ifdef __linux__
+#define _GNU_SOURCE /* for copy_file_range() */
+#endif /* __linux__ */
 #include "commoninclude.h"
 #include "akaiutil_io.h"
+#ifdef IO_MAP
+#include <sys/mman.h>
+#endif /* IO_MAP */
+#ifdef IO_COPY
+#include <sys/sendfile.h>
+#endif /* IO_COPY */
 
 
 
@@ -361,37 +370,126 @@ fldr_format(int fldrn)
 
 /* cache */
 
-struct blk_cache_s blk_cache[BLK_CACHE_NUM];
+struct blk_cache_s *blk_cache=NULL;
+u_int blk_cache_num=0;
+u_int blk_cache_size=BLK_CACHE_SIZE_DEF;
+u_char *blk_cache_slab=NULL;
+int *blk_cache_hash=NULL;
+u_int blk_cache_hashnum=0;
+int blk_cache_lruhead;
+int blk_cache_lrutail;
+struct blk_cache_stat_s blk_cache_stat;
 int blk_cache_enable;
 
+/* memory-mapped disk-files */
+struct io_map_s io_map[IO_MAP_NUM];
+u_int io_map_num=0;
+int io_map_enable=0; /* optional, see -M option */
 
 
-void
-init_blk_cache(void)
+
+/* Note: cachesize in bytes, 0 means: keep current blk_cache_size */
+int
+init_blk_cache(u_int cachesize)
 {
-	int i;
+	u_int i;
+
+	/* free old cache (if any) */
+	/* Note: caller must have flushed the cache before */
+	end_blk_cache();
 
-	for (i=0;i<BLK_CACHE_NUM;i++){
+	if (cachesize==0){
+		cachesize=blk_cache_size;
+	}
+	if (cachesize<BLK_CACHE_SIZE_MIN){
+		cachesize=BLK_CACHE_SIZE_MIN;
+	}
+	if (cachesize>BLK_CACHE_SIZE_MAX){
+		cachesize=BLK_CACHE_SIZE_MAX;
+	}
+	blk_cache_num=cachesize/BLK_CACHE_BLKSIZE_MAX;
+	blk_cache_size=blk_cache_num*BLK_CACHE_BLKSIZE_MAX;
+	/* hash table: at least 2 buckets per entry */
+	for (blk_cache_hashnum=1;blk_cache_hashnum<2*blk_cache_num;blk_cache_hashnum<<=1);
+
+	/* allocate entries, hash table, and one slab for all buffers */
+	blk_cache=(struct blk_cache_s *)malloc(blk_cache_num*sizeof(struct blk_cache_s));
+	blk_cache_hash=(int *)malloc(blk_cache_hashnum*sizeof(int));
+	blk_cache_slab=(u_char *)malloc(blk_cache_size);
+	if ((blk_cache==NULL)||(blk_cache_hash==NULL)||(blk_cache_slab==NULL)){
+		PERROR("malloc");
+		end_blk_cache();
+		return -1;
+	}
+
+	for (i=0;i<blk_cache_num;i++){
 		blk_cache[i].valid=0; /* free entry */
-		blk_cache[i].buf=NULL; /* not allocated yet */
+		blk_cache[i].modified=0;
+		blk_cache[i].blksize=0;
+		/* fixed slot in slab */
+		blk_cache[i].buf=blk_cache_slab+i*BLK_CACHE_BLKSIZE_MAX;
+		blk_cache[i].hprev=-1;
+		blk_cache[i].hnext=-1;
+		/* LRU list in index order */
+		blk_cache[i].lruprev=((int)i)-1;
+		blk_cache[i].lrunext=(i+1<blk_cache_num)?((int)(i+1)):-1;
 	}
+	blk_cache_lruhead=0;
+	blk_cache_lrutail=((int)blk_cache_num)-1;
+	for (i=0;i<blk_cache_hashnum;i++){
+		blk_cache_hash[i]=-1; /* empty hash chain */
+	}
+	bzero(&blk_cache_stat,sizeof(struct blk_cache_stat_s));
+
+	return 0;
 }
 
 
 
+/* Note: invalidates all entries, keeps cache allocated */
 void
 free_blk_cache(void)
 {
-	int i;
+	u_int i;
 
-	for (i=0;i<BLK_CACHE_NUM;i++){
-		if (blk_cache[i].buf!=NULL){ /* buffer allocated? */
-			/* free buffer */
-			free(blk_cache[i].buf);
-			blk_cache[i].valid=0; /* free entry */
-			blk_cache[i].buf=NULL; /* not allocated yet */
-		}
+	if (blk_cache==NULL){
+		return;
+	}
+
+	for (i=0;i<blk_cache_num;i++){
+		blk_cache[i].valid=0; /* free entry */
+		blk_cache[i].hprev=-1;
+		blk_cache[i].hnext=-1;
+	}
+	for (i=0;i<blk_cache_hashnum;i++){
+		blk_cache_hash[i]=-1; /* empty hash chain */
 	}
+	/* Note: LRU list and statistics are kept, all entries are free now */
+}
+
+
+
+/* Note: releases all cache memory, keeps blk_cache_size for next init_blk_cache() */
+void
+end_blk_cache(void)
+{
+
+	if (blk_cache!=NULL){
+		free(blk_cache);
+		blk_cache=NULL;
+	}
+	if (blk_cache_hash!=NULL){
+		free(blk_cache_hash);
+		blk_cache_hash=NULL;
+	}
+	if (blk_cache_slab!=NULL){
+		free(blk_cache_slab);
+		blk_cache_slab=NULL;
+	}
+	blk_cache_num=0;
+	blk_cache_hashnum=0;
+	blk_cache_lruhead=-1;
+	blk_cache_lrutail=-1;
 }
 
 
@@ -400,6 +498,8 @@ void
 print_blk_cache(void)
 {
 	int i;
+	u_int age;
+	u_int lookups;
 
 #ifdef _VISUALCPP
 	PRINTF_OUT("nr    fd   fldrn start/B       blksize blk     age         mod\n");
@@ -408,9 +508,10 @@ print_blk_cache(void)
 	PRINTF_OUT("nr    fd   start/B       blksize blk     age         mod\n");
 	PRINTF_OUT("--------------------------------------------------------\n");
 #endif /* !_VISUALCPP */
-	for (i=0;i<BLK_CACHE_NUM;i++){
+	/* walk LRU list, youngest first */
+	for (i=blk_cache_lruhead,age=0;i>=0;i=blk_cache[i].lrunext,age++){
 		if (!blk_cache[i].valid){ /* free entry? */
-			continue; /* next */
+			break; /* done, Note: free entries are at the old end */
 		}
 #ifdef _VISUALCPP
 		PRINTF_OUT("%4i  %3i  %3i   0x%02x%08x  0x%04x  0x%04x  0x%08x  %i\n",
@@ -421,7 +522,7 @@ print_blk_cache(void)
 			(u_int)(0xffffffff&blk_cache[i].startoff),
 			blk_cache[i].blksize,
 			blk_cache[i].blk,
-			blk_cache[i].age,
+			age,
 			blk_cache[i].modified);
 #else /* !_VISUALCPP */
 		PRINTF_OUT("%4i  %3i  0x%02x%08x  0x%04x  0x%04x  0x%08x  %i\n",
@@ -431,7 +532,7 @@ print_blk_cache(void)
 			(u_int)(0xffffffff&blk_cache[i].startoff),
 			blk_cache[i].blksize,
 			blk_cache[i].blk,
-			blk_cache[i].age,
+			age,
 			blk_cache[i].modified);
 #endif /* !_VISUALCPP */
 	}
@@ -440,6 +541,90 @@ print_blk_cache(void)
 #else /* !_VISUALCPP */
 	PRINTF_OUT("--------------------------------------------------------\n");
 #endif /* !_VISUALCPP */
+	PRINTF_OUT("size:        %u KB\n",blk_cache_size/1024);
+	PRINTF_OUT("entries:     %u used, %u total\n",age,blk_cache_num);
+	lookups=blk_cache_stat.hits+blk_cache_stat.misses;
+	PRINTF_OUT("hits:        %u (%5.1lf%%)\n",blk_cache_stat.hits,
+		(lookups>0)?(100.0*((double)blk_cache_stat.hits)/((double)lookups)):0.0);
+	PRINTF_OUT("misses:      %u\n",blk_cache_stat.misses);
+	PRINTF_OUT("evictions:   %u\n",blk_cache_stat.evictions);
+	PRINTF_OUT("write-backs: %u\n",blk_cache_stat.writebacks);
+}
+
+
+
+u_int
+blk_cache_hashindex(int fd,
+#ifdef _VISUALCPP
+					int fldrn,
+#endif /* _VISUALCPP */
+					OFF64_T startoff,u_int blk,u_int blksize)
+{
+	u_int h;
+
+	/* Note: consecutive blocks of the same fd must go to different buckets */
+	h=blk;
+	h^=((u_int)fd)*0x9e3779b1;
+#ifdef _VISUALCPP
+	h^=((u_int)fldrn)*0x85ebca6b;
+#endif /* _VISUALCPP */
+	h^=((u_int)(startoff>>13))*0xc2b2ae35; /* XXX startoff is typically a multiple of 8KB */
+	h^=(u_int)(startoff>>32);
+	h^=blksize>>10; /* XXX 1KB or 8KB */
+	h^=h>>16;
+
+	return h&(blk_cache_hashnum-1);
+}
+
+
+
+/* Note: entry i must be valid and not linked yet */
+void
+blk_cache_hash_insert(int i)
+{
+	u_int h;
+
+	if ((i<0)||(i>=(int)blk_cache_num)){
+		return;
+	}
+
+	h=blk_cache_hashindex(blk_cache[i].fd,
+#ifdef _VISUALCPP
+						  blk_cache[i].fldrn,
+#endif /* _VISUALCPP */
+						  blk_cache[i].startoff,blk_cache[i].blk,blk_cache[i].blksize);
+	blk_cache[i].hash=h;
+	/* insert as first entry in hash chain */
+	blk_cache[i].hprev=-1;
+	blk_cache[i].hnext=blk_cache_hash[h];
+	if (blk_cache_hash[h]>=0){
+		blk_cache[blk_cache_hash[h]].hprev=i;
+	}
+	blk_cache_hash[h]=i;
+}
+
+
+
+/* Note: entry i must be valid and linked */
+void
+blk_cache_hash_remove(int i)
+{
+
+	if ((i<0)||(i>=(int)blk_cache_num)){
+		return;
+	}
+
+	if (blk_cache[i].hprev>=0){
+		blk_cache[blk_cache[i].hprev].hnext=blk_cache[i].hnext;
+	}else{
+		/* first entry in hash chain */
+		blk_cache_hash[blk_cache[i].hash]=blk_cache[i].hnext;
+	}
+	if (blk_cache[i].hnext>=0){
+		blk_cache[blk_cache[i].hnext].hprev=blk_cache[i].hprev;
+	}
+	blk_cache[i].hprev=-1;
+	blk_cache[i].hnext=-1;
 }
 
 
@@ -453,14 +638,19 @@ find_blk_cache(int fd,
 {
 	int i;
 
-	/* scan cache */
-	for (i=0;i<BLK_CACHE_NUM;i++){
-		if (blk_cache[i].buf==NULL){
-			continue; /* next */
-		}
-		if (!blk_cache[i].valid){ /* free? */
-			continue; /* next */
-		}
+	if (blk_cache==NULL){
+		return -1;
+	}
+
+	/* scan hash chain */
+	/* Note: only valid entries with buffer are linked into hash chains */
+	for (i=blk_cache_hash[blk_cache_hashindex(fd,
+#ifdef _VISUALCPP
+											  fldrn,
+#endif /* _VISUALCPP */
+											  startoff,blk,blksize)];
+		 i>=0;
+		 i=blk_cache[i].hnext){
 		/* check if contained within cache */
 		/* Note: must check for blksize as well!!! */
 		if ((fd==blk_cache[i].fd)
@@ -470,54 +660,60 @@ find_blk_cache(int fd,
 			&&(startoff==blk_cache[i].startoff)
 			&&(blk==blk_cache[i].blk)
 			&&(blksize==blk_cache[i].blksize)){
-			break; /* found it */
+			return i; /* found it */
 		}
 	}
 
-	if (i==BLK_CACHE_NUM){ /* none found? */
-		return -1;
+	return -1; /* none found */
+}
+
+
+
+void
+blk_cache_lru_remove(int i)
+{
+
+	if ((i<0)||(i>=(int)blk_cache_num)){
+		return;
 	}
 
-	return i;
+	if (blk_cache[i].lruprev>=0){
+		blk_cache[blk_cache[i].lruprev].lrunext=blk_cache[i].lrunext;
+	}else{
+		blk_cache_lruhead=blk_cache[i].lrunext;
+	}
+	if (blk_cache[i].lrunext>=0){
+		blk_cache[blk_cache[i].lrunext].lruprev=blk_cache[i].lruprev;
+	}else{
+		blk_cache_lrutail=blk_cache[i].lruprev;
+	}
+	blk_cache[i].lruprev=-1;
+	blk_cache[i].lrunext=-1;
 }
 
 
 
+/* make entry i the youngest one */
 void
 blk_cache_aging(int i)
 {
-	int j;
-	u_int agemin;
 
-	if ((i<0)||(i>=BLK_CACHE_NUM)||(!blk_cache[i].valid)){
+	if ((i<0)||(i>=(int)blk_cache_num)||(!blk_cache[i].valid)){
 		return;
 	}
+	if (i==blk_cache_lruhead){
+		return; /* already youngest */
+	}
 
-	blk_cache[i].age=0; /* reset age */
-
-	/* find the youngest of the others */
-	agemin=BLK_CACHE_AGE_MAX;
-	for (j=0;j<BLK_CACHE_NUM;j++){
-		if (!blk_cache[j].valid){ /* free? */
-			continue; /* next */
-		}
-		if (j==i){
-			continue; /* next */
-		}
-		if (blk_cache[j].age<agemin){
-			agemin=blk_cache[j].age;
-		}
+	/* move to young end of LRU list */
+	blk_cache_lru_remove(i);
+	blk_cache[i].lrunext=blk_cache_lruhead;
+	if (blk_cache_lruhead>=0){
+		blk_cache[blk_cache_lruhead].lruprev=i;
 	}
-	if (agemin==0){ /* somebody else too young? */
-		/* increment age of the others */
-		for (j=0;j<BLK_CACHE_NUM;j++){
-			if (j==i){
-				continue; /* next */
-			}
-			if (blk_cache[j].age<BLK_CACHE_AGE_MAX){
-				blk_cache[j].age++; /* increase age */
-			}
-		}
+	blk_cache_lruhead=i;
+	if (blk_cache_lrutail<0){
+		blk_cache_lrutail=i;
 	}
 }
 
@@ -531,9 +727,11 @@ io_blks_direct(int fd,
 			   OFF64_T startoff,u_char *buf,u_int bstart,u_int bsize,u_int blksize,int cachealloc,int mode)
 {
 	int err;
-	int j,jmax;
-	u_int agemax;
+	int jmax;
 	u_int blk,blkmin,blkmax,blkchunk;
+#ifdef IO_MAP
+	u_char *mp;
+#endif /* IO_MAP */
 
 	if (buf==NULL){
 		return -1;
@@ -561,7 +759,7 @@ io_blks_direct(int fd,
 		return 0; /* done */
 	}
 
-	if (!blk_cache_enable){ /* cache disabled? */
+	if ((!blk_cache_enable)||(blk_cache==NULL)||(blksize>BLK_CACHE_BLKSIZE_MAX)){ /* cache disabled or not usable? */
 		cachealloc=0; /* don't allocate cache */
 	}
 
@@ -590,17 +788,19 @@ io_blks_direct(int fd,
 			}
 		}else /* no floppy drive */
 #endif /* _VISUALCPP */
+#ifdef IO_MAP
+		/* Note: mapping is read-only, writes go through fd (MAP_SHARED sees them) */
+		if ((mode!=IO_BLKS_WRITE)&&((mp=io_blks_ptr(fd,startoff,blk,blkchunk,blksize))!=NULL)){ /* memory-mapped? */
+			/* read block(s) */
+			bcopy(mp,buf+(blk-blkmin)*blksize,blkchunk*blksize);
+		}else /* not memory-mapped or write */
+#endif /* IO_MAP */
 		{
-			/* goto blk */
-			if (LSEEK64(fd,startoff+(OFF64_T)(blk*blksize),SEEK_SET)<0){
-#ifdef DEBUG
-				PERROR("lseek");
-#endif
-				return -1;
-			}
+			/* Note: positional I/O at blk, fd offset is not used */
 			if (mode==IO_BLKS_WRITE){
 				/* write block(s) */
-				err=WRITE(fd,(void *)(buf+(blk-blkmin)*blksize),blkchunk*blksize);
+				err=PWRITE64(fd,(void *)(buf+(blk-blkmin)*blksize),blkchunk*blksize,
+							 startoff+((OFF64_T)blk)*((OFF64_T)blksize));
 				if (err<0){
 #ifdef DEBUG
 					PERROR("write");
@@ -615,7 +815,8 @@ io_blks_direct(int fd,
 				}
 			}else{
 				/* read block(s) */
-				err=READ(fd,(void *)(buf+(blk-blkmin)*blksize),blkchunk*blksize);
+				err=PREAD64(fd,(void *)(buf+(blk-blkmin)*blksize),blkchunk*blksize,
+							startoff+((OFF64_T)blk)*((OFF64_T)blksize));
 				if (err<0){
 #ifdef DEBUG
 					PERROR("read");
@@ -631,22 +832,12 @@ io_blks_direct(int fd,
 			}
 		}
 		if (cachealloc){ /* must allocate cache? */
-			/* find free entry or the oldest one */
-			agemax=0;
-			jmax=0; /* first guess */
-			for (j=0;j<BLK_CACHE_NUM;j++){
-				if (!blk_cache[j].valid){ /* free? */
-					jmax=j;
-					break; /* found one */
-				}
-				if (blk_cache[j].age>=agemax){ /* older or equal? */
-					agemax=blk_cache[j].age;
-					jmax=j;
-				}
-			}
+			/* take free entry or the oldest one */
+			/* Note: free entries are at the old end of LRU list */
+			jmax=blk_cache_lrutail;
 			/* old cache entry not free and modified? */
 			err=0;
-			if ((blk_cache[jmax].valid)&&(blk_cache[jmax].modified)&&(blk_cache[jmax].buf!=NULL)){
+			if ((blk_cache[jmax].valid)&&(blk_cache[jmax].modified)){
 				/* must flush this block */
 				if (io_blks_direct(blk_cache[jmax].fd,
 #ifdef _VISUALCPP
@@ -661,25 +852,23 @@ io_blks_direct(int fd,
 									IO_BLKS_WRITE)<0){
 					PRINTF_ERR("cannot flush cache block 0x%08x of fd %i\n",blk_cache[jmax].blk,blk_cache[jmax].fd);
 					err=1; /* cannot allocate below */
+				}else{
+					blk_cache_stat.writebacks++;
 				}
 			}
 			if (!err){
-				if ((blk_cache[jmax].buf!=NULL)&&(blk_cache[jmax].blksize!=blksize)){ /* not compatible? */
-					/* free buffer */
-					free(blk_cache[jmax].buf);
-					blk_cache[jmax].buf=NULL;
-				}
-				if (blk_cache[jmax].buf==NULL){ /* buffer not allocated yet/anymore? */
-					/* need to allocate buffer */
-					if ((blk_cache[jmax].buf=(u_char *)malloc(blksize))==NULL){
-						PERROR("malloc");
-						err=1; /* cannot allocate below */
-					}
+				if (blk_cache[jmax].valid){ /* old cache entry not free? */
+					/* remove old cache entry from hash chain */
+					blk_cache_hash_remove(jmax);
 					blk_cache[jmax].valid=0; /* free */
-					blk_cache[jmax].blksize=blksize;
+					blk_cache_stat.evictions++;
 				}
+				/* Note: slot in slab is large enough for any blksize<=BLK_CACHE_BLKSIZE_MAX */
+				blk_cache[jmax].blksize=blksize;
 			}
-			if (!err){
+			if (err){
+				blk_cache_aging(jmax); /* XXX try another victim next time */
+			}else{
 				/* allocate cache entry */
 				blk_cache[jmax].valid=1;
 				blk_cache[jmax].modified=0;
@@ -689,6 +878,7 @@ io_blks_direct(int fd,
 #endif /* _VISUALCPP */
 				blk_cache[jmax].startoff=startoff;
 				blk_cache[jmax].blk=blk;
+				blk_cache_hash_insert(jmax); /* link into hash chain */
 				blk_cache_aging(jmax); /* adjust ages */
 				/* copy data */
 				bcopy(buf+(blk-blkmin)*blksize,blk_cache[jmax].buf,blksize);
@@ -710,10 +900,7 @@ flush_blk_cache(void)
 
 	/* scan cache */
 	ret=0; /* no error so far */
-	for (i=0;i<BLK_CACHE_NUM;i++){
-		if (blk_cache[i].buf==NULL){
-			continue; /* next */
-		}
+	for (i=0;i<(int)blk_cache_num;i++){
 		if (!blk_cache[i].valid){ /* free? */
 			continue; /* next */
 		}
@@ -737,6 +924,7 @@ flush_blk_cache(void)
 			ret=-1;
 		}else{
 			blk_cache[i].modified=0; /* done */
+			blk_cache_stat.writebacks++;
 		}
 	}
 
@@ -778,7 +966,14 @@ io_blks(int fd,
 	}
 #endif /* !_VISUALCPP */
 
-	if (!blk_cache_enable){ /* cache disabled? */
+#ifdef IO_MAP
+	if (io_map_find(fd)>=0){ /* memory-mapped? */
+		/* Note: mapping is served from page cache, no need for our cache */
+		return io_blks_direct(fd,startoff,buf,bstart,bsize,blksize,0,mode); /* 0: don't alloc cache */
+	}
+#endif /* IO_MAP */
+
+	if ((!blk_cache_enable)||(blk_cache==NULL)||(blksize>BLK_CACHE_BLKSIZE_MAX)){ /* cache disabled or not usable? */
 		cachealloc=0; /* don't allocate cache */
 	}
 
@@ -786,7 +981,7 @@ io_blks(int fd,
 	chunkstart=bstart;
 	chunksize=0; /* no chunk of missing blocks so far */
 	for (blk=bstart;blk<(bstart+bsize);blk++){
-		if (blk_cache_enable){ /* cache enabled? */
+		if (blk_cache_enable&&(blk_cache!=NULL)){ /* cache enabled? */
 			/* look in cache */
 			i=find_blk_cache(fd,
 #ifdef _VISUALCPP
@@ -799,6 +994,9 @@ io_blks(int fd,
 			i=-1; /* not found in cache */
 		}
 		if (i<0){ /* not found in cache? */
+			if (blk_cache_enable&&(blk_cache!=NULL)){
+				blk_cache_stat.misses++;
+			}
 			if (chunksize==0){ /* new chunk of missing blocks? */
 				chunkstart=blk; /* start of chunk */
 			}
@@ -806,6 +1004,7 @@ io_blks(int fd,
 		}else{
 			/* found in cache */
 			/* Note: now, blk_cache[i].buf!=NULL */
+			blk_cache_stat.hits++;
 
 			/* Note: must do cache-I/O first, since io_blks_direct could steal i from cache */
 			if (mode==IO_BLKS_WRITE){
@@ -862,4 +1061,259 @@ io_blks(int fd,
 
 
 
+/* map whole disk-file into memory for reading */
+/* returns 0 if mapped, -1 if not (caller may use fd as usual) */
+/* Note: read-only mapping, a writable one could raise SIGBUS on write errors (e.g. full filesystem) */
+int
+io_map_open(int fd)
+{
+#ifdef IO_MAP
+	struct stat st;
+	u_char *base;
+	int i;
+
+	if ((!io_map_enable)||(fd<0)){
+		return -1;
+	}
+	if (io_map_find(fd)>=0){
+		return 0; /* already mapped, e.g. pseudo-disks */
+	}
+	if (io_map_num>=IO_MAP_NUM){
+		return -1;
+	}
+
+	if (fstat(fd,&st)<0){
+		return -1;
+	}
+	if (!S_ISREG(st.st_mode)){ /* no regular file? */
+		return -1; /* e.g. device */
+	}
+	/* Note: mapping must fit into address space */
+	if ((st.st_size<=0)||(((OFF64_T)(size_t)st.st_size)!=((OFF64_T)st.st_size))){
+		return -1;
+	}
+
+	base=(u_char *)mmap(NULL,(size_t)st.st_size,
+						PROT_READ,MAP_SHARED,fd,0);
+	if (base==(u_char *)MAP_FAILED){
+#ifdef DEBUG
+		PERROR("mmap");
+#endif
+		return -1;
+	}
+
+	i=(int)io_map_num;
+	io_map[i].fd=fd;
+	io_map[i].base=base;
+	io_map[i].size=(OFF64_T)st.st_size;
+	io_map_num++;
+
+	return 0;
+#else /* !IO_MAP */
+	return -1;
+#endif /* !IO_MAP */
+}
+
+
+
+void
+io_map_close(int fd)
+{
+#ifdef IO_MAP
+	int i;
+
+	i=io_map_find(fd);
+	if (i<0){
+		return; /* not mapped */
+	}
+
+	munmap(io_map[i].base,(size_t)io_map[i].size);
+
+	/* move last entry into free slot */
+	io_map_num--;
+	if (i!=(int)io_map_num){
+		io_map[i]=io_map[io_map_num];
+	}
+	io_map[io_map_num].fd=-1; /* free */
+#endif /* IO_MAP */
+}
+
+
+
+int
+io_map_find(int fd)
+{
+	int i;
+
+	if (fd<0){
+		return -1;
+	}
+
+	for (i=0;i<(int)io_map_num;i++){
+		if (io_map[i].fd==fd){
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+
+
+/* returns pointer to blocks in memory-mapped disk-file (or NULL if not mapped) */
+/* Note: for reading only, writes must go through io_blks() */
+u_char *
+io_blks_ptr(int fd,OFF64_T startoff,u_int bstart,u_int bsize,u_int blksize)
+{
+	int i;
+	OFF64_T off;
+
+	i=io_map_find(fd);
+	if (i<0){
+		return NULL; /* not mapped */
+	}
+
+	off=startoff+((OFF64_T)bstart)*((OFF64_T)blksize);
+	if ((off<0)||((off+((OFF64_T)bsize)*((OFF64_T)blksize))>io_map[i].size)){
+		return NULL; /* outside of mapping */
+	}
+
+	return io_map[i].base+off;
+}
+
+
+
+#ifdef IO_MAP
+/* write all buffers of iov to fd */
+/* Note: iov is modified */
+int
+io_writev(int fd,struct iovec *iov,int iovcnt)
+{
+	ssize_t n;
+
+	for (;;){
+		/* skip empty buffers */
+		while ((iovcnt>0)&&(iov->iov_len==0)){
+			iov++;
+			iovcnt--;
+		}
+		if (iovcnt==0){
+			break; /* done */
+		}
+		n=writev(fd,iov,iovcnt);
+		if (n<0){
+			if (errno==EINTR){
+				continue;
+			}
+			PERROR("write");
+			return -1;
+		}
+		if (n==0){
+			PRINTF_ERR("write: incomplete\n");
+			return -1;
+		}
+		/* skip written buffers */
+		while ((iovcnt>0)&&(((size_t)n)>=iov->iov_len)){
+			n-=(ssize_t)iov->iov_len;
+			iov++;
+			iovcnt--;
+		}
+		if (iovcnt>0){
+			/* rest of partially written buffer */
+			iov->iov_base=(void *)(((u_char *)iov->iov_base)+n);
+			iov->iov_len-=(size_t)n;
+		}
+	}
+
+	return 0;
+}
+#endif /* IO_MAP */
+
+
+
+#ifdef IO_COPY
+int io_copy_enable=1;
+static int io_copy_sendfilefd=-1; /* last outfd which required sendfile() */
+#else /* !IO_COPY */
+int io_copy_enable=0;
+#endif /* !IO_COPY */
+
+/* copy bytes skip...skip+len-1 of blocks to outfd within kernel (without user-space buffer) */
+/* returns 0 if done, 1 if not possible (caller must read and write), -1 if error */
+int
+io_blks_copy(int fd,OFF64_T startoff,u_int bstart,u_int bsize,u_int blksize,u_int skip,u_int len,int outfd)
+{
+#ifdef IO_COPY
+	u_int blk;
+	int i;
+	OFF64_T off;
+	loff_t cfroff;
+	off_t sfoff;
+	ssize_t n;
+	u_int done;
+	int sfflag;
+
+	if ((!io_copy_enable)||(fd<0)||(outfd<0)){
+		return 1;
+	}
+	if ((((OFF64_T)skip)+((OFF64_T)len))>((OFF64_T)bsize)*((OFF64_T)blksize)){
+		return -1;
+	}
+	if (len==0){
+		return 0; /* done */
+	}
+
+	/* Note: modified blocks in cache have not been written to disk-file yet */
+	if (blk_cache_enable&&(blk_cache!=NULL)){
+		for (blk=bstart;blk<(bstart+bsize);blk++){
+			i=find_blk_cache(fd,startoff,blk,blksize);
+			if ((i>=0)&&blk_cache[i].modified){
+				return 1;
+			}
+		}
+	}
+
+	off=startoff+((OFF64_T)bstart)*((OFF64_T)blksize)+((OFF64_T)skip);
+	/* Note: if sendfile() was required for same outfd before, use it again */
+	/*       (fd might have been reused in the meantime, but sendfile() works anyway) */
+	sfflag=(outfd==io_copy_sendfilefd); /* else: try copy_file_range() first */
+	for (done=0;done<len;done+=(u_int)n){
+		if (!sfflag){
+			cfroff=(loff_t)(off+done);
+			n=copy_file_range(fd,&cfroff,outfd,NULL,len-done,0);
+			if ((n<0)&&((errno==EXDEV)||(errno==EINVAL)||(errno==ENOSYS)||(errno==EOPNOTSUPP)||(errno==EBADF))){
+				/* e.g. different filesystems or outfd not a regular file */
+				sfflag=1; /* use sendfile() */
+				io_copy_sendfilefd=outfd;
+			}
+		}
+		if (sfflag){
+			sfoff=(off_t)(off+done);
+			n=sendfile(outfd,fd,&sfoff,len-done);
+		}
+		if (n<0){
+			if (errno==EINTR){
+				n=0;
+				continue;
+			}
+			if ((done==0)&&((errno==EINVAL)||(errno==ENOSYS))){
+				return 1; /* not possible */
+			}
+			PERROR("copy");
+			return -1;
+		}
+		if (n==0){
+			PRINTF_ERR("copy: incomplete\n");
+			return -1;
+		}
+	}
+
+	return 0;
+#else /* !IO_COPY */
+	return 1; /* not possible */
+#endif /* !IO_COPY */
+}
+
+
+
 /* EOF */
@@ -82,20 +82,92 @@ struct blk_cache_s{
 	OFF64_T startoff;
 	u_int blk;
 	u_int blksize;
-#define BLK_CACHE_AGE_MAX		0xffffffff /* XXX max. age */
-	u_int age; /* age */
 	u_char *buf;
+	int lruprev; /* previous (younger) entry in LRU list (or -1 if youngest) */
+	int lrunext; /* next (older) entry in LRU list (or -1 if oldest) */
+	int hprev; /* previous entry in hash chain (or -1 if first) */
+	int hnext; /* next entry in hash chain (or -1 if last) */
+	u_int hash; /* hash index of entry (only valid if entry is valid) */
 };
 
 #ifndef BLK_CACHE_NUM
-#define BLK_CACHE_NUM	512 /* XXX */
+#define BLK_CACHE_NUM	512 /* XXX default number of cache entries */
 #endif
-extern struct blk_cache_s blk_cache[BLK_CACHE_NUM];
+/* max. blocksize of cached blocks, Note: all entries share one slab with slots of this size */
+#define BLK_CACHE_BLKSIZE_MAX	0x2000 /* 8KB */
+/* Note: must be >= AKAI_HD_BLOCKSIZE (harddisk filesystem blocksize, defined in akaiutil.h) */
+#if defined(AKAI_HD_BLOCKSIZE)&&(BLK_CACHE_BLKSIZE_MAX<AKAI_HD_BLOCKSIZE)
+#error "BLK_CACHE_BLKSIZE_MAX<AKAI_HD_BLOCKSIZE"
+#endif
+#define BLK_CACHE_SIZE_DEF		(BLK_CACHE_NUM*BLK_CACHE_BLKSIZE_MAX) /* default cache size in bytes */
+#define BLK_CACHE_SIZE_MIN		BLK_CACHE_BLKSIZE_MAX /* min. cache size in bytes (1 entry) */
+#define BLK_CACHE_SIZE_MAX		0x40000000 /* XXX max. cache size in bytes (1GB) */
+extern struct blk_cache_s *blk_cache; /* cache entries (or NULL if not allocated) */
+extern u_int blk_cache_num; /* number of cache entries */
+extern u_int blk_cache_size; /* cache size in bytes */
+extern u_char *blk_cache_slab; /* buffers of all cache entries */
+
+/* hash table for lookup of valid cache entries */
+extern int *blk_cache_hash; /* first entry in hash chain (or -1 if none) */
+extern u_int blk_cache_hashnum; /* number of hash buckets, Note: power of 2 */
+
+/* LRU list of all cache entries, Note: free entries are kept at the old end */
+extern int blk_cache_lruhead; /* youngest entry */
+extern int blk_cache_lrutail; /* oldest entry */
+
+/* cache statistics */
+struct blk_cache_stat_s{
+	u_int hits; /* blocks found in cache */
+	u_int misses; /* blocks not found in cache */
+	u_int evictions; /* valid entries replaced by other blocks */
+	u_int writebacks; /* modified entries written to disk */
+};
+extern struct blk_cache_stat_s blk_cache_stat;
 
 extern int blk_cache_enable;
 
 
 
+/* memory-mapped disk-files */
+
+#ifndef _VISUALCPP
+#ifndef NO_IO_MAP
+#define IO_MAP /* use mmap() for disk-files if possible */
+#endif
+#endif /* !_VISUALCPP */
+
+struct io_map_s{
+	int fd; /* file descriptor (or -1 if free) */
+	u_char *base; /* start of mapping */
+	OFF64_T size; /* size of mapping in bytes */
+};
+
+#ifndef IO_MAP_NUM
+#define IO_MAP_NUM		64 /* XXX max. number of mapped files */
+#endif
+extern struct io_map_s io_map[IO_MAP_NUM];
+extern u_int io_map_num; /* number of used entries in io_map[] */
+
+extern int io_map_enable;
+
+#ifdef IO_MAP
+#include <sys/uio.h> /* for writev() */
+#endif /* IO_MAP */
+
+
+
+/* copy from disk-files to external files within kernel */
+
+#ifdef __linux__
+#ifndef NO_IO_COPY
+#define IO_COPY /* use copy_file_range()/sendfile() if possible */
+#endif
+#endif /* __linux__ */
+
+extern int io_copy_enable;
+
+
+
 #define IO_BLKS_READ	0
 #define IO_BLKS_WRITE	1
 
@@ -111,14 +183,23 @@ extern int fldr_checkfloppyinserted(int fldrn);
 extern int fldr_io_direct(int fldrn,u_int blk,u_char *buf,int mode);
 extern int fldr_format(int fldrn);
 #endif /* _VISUALCPP */
-extern void init_blk_cache(void);
+extern int init_blk_cache(u_int cachesize);
 extern void free_blk_cache(void);
+extern void end_blk_cache(void);
 extern void print_blk_cache(void);
+extern u_int blk_cache_hashindex(int fd,
+#ifdef _VISUALCPP
+								  int fldrn,
+#endif
+								  OFF64_T startoff,u_int blk,u_int blksize);
+extern void blk_cache_hash_insert(int i);
+extern void blk_cache_hash_remove(int i);
 extern int find_blk_cache(int fd,
 #ifdef _VISUALCPP
 						  int fldrnr,
 #endif
 						  OFF64_T startoff,u_int blk,u_int blksize);
+extern void blk_cache_lru_remove(int i);
 extern void blk_cache_aging(int i);
 extern int io_blks_direct(int fd,
 #ifdef _VISUALCPP
@@ -131,6 +212,14 @@ extern int io_blks(int fd,
 				   int fldrn,
 #endif
 				   OFF64_T startoff,u_char *buf,u_int bstart,u_int bsize,u_int blksize,int cachealloc,int mode);
+extern int io_map_open(int fd);
+extern void io_map_close(int fd);
+extern int io_map_find(int fd);
+extern u_char *io_blks_ptr(int fd,OFF64_T startoff,u_int bstart,u_int bsize,u_int blksize);
+#ifdef IO_MAP
+extern int io_writev(int fd,struct iovec *iov,int iovcnt);
+#endif /* IO_MAP */
+extern int io_blks_copy(int fd,OFF64_T startoff,u_int bstart,u_int bsize,u_int blksize,u_int skip,u_int len,int outfd);
 
 
 
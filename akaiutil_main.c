@@ -28,6 +28,8 @@
 #include "akaiutil_tar.h"
 #include "akaiutil_file.h"
 #include "akaiutil_take.h"
+#include "akaiutil_wav.h"
+#include "akaiutil_cat.h"
 
 
 
@@ -41,6 +43,441 @@
 
 
 
+/* batch export: max. number of parallel jobs, <=1: serial */
+#define BATCH_JOBS_MAX		256
+static u_int batchjobs=1;
+
+#ifndef _VISUALCPP
+/* tar-file "-": output to stdout (-O option), console output is redirected to stderr */
+#define TAR_STDOUT_NAME		"-"
+static int tarstdoutfd=-1; /* original stdout, -1 if -O option not given */
+#endif /* !_VISUALCPP */
+
+/* batch job: export item with index i, returns 0 if success, -1 if error, -2 if batch must be aborted */
+typedef int (*batchfunc_t)(void *arg,u_int i);
+
+#ifndef _VISUALCPP
+struct batchjob_s{
+	pid_t pid; /* child process, 0 if finished */
+	int ret; /* returned value of job */
+	FILE *outfp; /* buffered output of job */
+	FILE *errfp; /* buffered error output of job */
+};
+
+static void
+batch_copyout(FILE *fp,FILE *outfp)
+{
+	static char buf[4096];
+	size_t n;
+
+	if (fp==NULL){
+		return;
+	}
+	rewind(fp);
+	while ((n=fread(buf,1,sizeof(buf),fp))>0){
+		fwrite(buf,1,n,outfp);
+	}
+	fclose(fp);
+}
+#endif /* !_VISUALCPP */
+
+/* run func for items idx[0..n-1] */
+/* Note: with batchjobs>1, each job runs in a child process (read-only access to disks), */
+/*       output of jobs is buffered and printed in order of items */
+/* returns number of successful jobs or -1 if batch has been aborted */
+/* *lastp: index of last successful item, unchanged if none */
+static int
+batch_run(batchfunc_t func,void *arg,u_int *idx,u_int n,u_int *lastp)
+{
+#ifndef _VISUALCPP
+	struct batchjob_s *jobs;
+	u_int next,done,running;
+	pid_t pid;
+	int status;
+#endif /* !_VISUALCPP */
+	int abortflag;
+	u_int k;
+	int r;
+	int count;
+
+	count=0;
+	abortflag=0;
+#ifndef _VISUALCPP
+	jobs=NULL;
+	if ((batchjobs>1)&&(n>1)){
+		jobs=(struct batchjob_s *)malloc(n*sizeof(struct batchjob_s));
+		if (jobs==NULL){
+			PRINTF_ERR("cannot allocate memory, running serially\n");
+		}
+	}
+	if (jobs==NULL)
+#endif /* !_VISUALCPP */
+	{
+		/* serial */
+		for (k=0;k<n;k++){
+			r=(*func)(arg,idx[k]);
+			if (r==0){
+				count++;
+				if (lastp!=NULL){
+					*lastp=idx[k];
+				}
+			}else if (r==-2){
+				abortflag=1;
+				break;
+			}
+		}
+		return abortflag?-1:count;
+	}
+
+#ifndef _VISUALCPP
+	next=0; /* next job to start */
+	done=0; /* next job to print */
+	running=0;
+	while (done<n){
+		/* start jobs */
+		while ((!abortflag)&&(running<batchjobs)&&(next<n)){
+			jobs[next].outfp=tmpfile();
+			jobs[next].errfp=tmpfile();
+			FLUSH_ALL; /* Note: before fork */
+			if ((jobs[next].outfp==NULL)||(jobs[next].errfp==NULL)
+				||((pid=fork())<0)){
+				if (jobs[next].outfp!=NULL){
+					fclose(jobs[next].outfp);
+				}
+				if (jobs[next].errfp!=NULL){
+					fclose(jobs[next].errfp);
+				}
+				jobs[next].outfp=NULL;
+				jobs[next].errfp=NULL;
+				if (running>0){
+					break; /* wait for running jobs first */
+				}
+				/* no child process: run job here */
+				/* Note: all previous jobs have been printed */
+				jobs[next].pid=0;
+				jobs[next].ret=(*func)(arg,idx[next]);
+				next++;
+				continue;
+			}
+			if (pid==0){
+				/* child process */
+				dup2(fileno(jobs[next].outfp),STDOUT_FILENO);
+				dup2(fileno(jobs[next].errfp),STDERR_FILENO);
+				r=(*func)(arg,idx[next]);
+				FLUSH_ALL;
+				/* Note: _exit() in order to avoid exit handlers and flushing of inherited stdio buffers */
+				_exit((r==0)?0:((r==-2)?2:1));
+			}
+			jobs[next].pid=pid;
+			jobs[next].ret=-1;
+			next++;
+			running++;
+		}
+
+		/* print finished jobs in order */
+		while ((done<next)&&(jobs[done].pid==0)){
+			/* Note: output before error output of each job */
+			batch_copyout(jobs[done].outfp,stdout);
+			FLUSH_ALL;
+			batch_copyout(jobs[done].errfp,stderr);
+			FLUSH_ALL;
+			if (jobs[done].ret==0){
+				count++;
+				if (lastp!=NULL){
+					*lastp=idx[done];
+				}
+			}else if (jobs[done].ret==-2){
+				abortflag=1;
+			}
+			done++;
+		}
+		if (done>=next){
+			if (abortflag||(next>=n)){
+				break;
+			}
+			continue;
+		}
+
+		/* wait for any job */
+		pid=waitpid(-1,&status,0);
+		if (pid<0){
+			if (errno==EINTR){
+				continue;
+			}
+			PERROR("waitpid");
+			/* XXX mark remaining jobs as failed */
+			for (k=done;k<next;k++){
+				if (jobs[k].pid!=0){
+					jobs[k].pid=0;
+					jobs[k].ret=-1;
+				}
+			}
+			running=0;
+			continue;
+		}
+		for (k=done;k<next;k++){
+			if (jobs[k].pid==pid){
+				jobs[k].pid=0;
+				if (WIFEXITED(status)){
+					r=WEXITSTATUS(status);
+					jobs[k].ret=(r==0)?0:((r==2)?-2:-1);
+				}else{
+					jobs[k].ret=-1;
+				}
+				running--;
+				break;
+			}
+		}
+		/* Note: ignore other child processes */
+	}
+
+	free(jobs);
+	return abortflag?-1:count;
+#endif /* !_VISUALCPP */
+}
+
+#ifndef _VISUALCPP
+/* parallel disk scan */
+struct scanjob_s{
+	int floppyenable;
+	int restartflag;
+	FILE *resfp[DISK_NUM_MAX]; /* scan result of each disk */
+};
+
+/* scan result of disk, followed by partnum partitions */
+/* Note: explicit fields only, pointers of child process are not passed */
+struct scandisk_s{
+	u_int type; /* disk type */
+	u_int blksize; /* blocksize in bytes */
+	u_int bsize; /* size in blocks */
+	u_int partnum; /* number of partitions */
+};
+
+/* scan result of partition, see struct part_s */
+struct scanpart_s{
+	int valid;
+	u_int type;
+	u_int index;
+	u_int blksize;
+	u_int bstart;
+	u_int bsize;
+	u_int csize;
+	u_int bsyssize;
+	u_int bfree;
+	u_int bbad;
+	u_int volnummax;
+	char letter;
+	union akai_head_u head;
+};
+
+/* batch job: scan disk i */
+/* Note: scans into part[] starting at index 0, result is merged by scan_alldisks_parallel() */
+static int
+batch_scandisk(void *arg,u_int i)
+{
+	static struct scanpart_s sp;
+	struct scanjob_s *jp;
+	struct scandisk_s sd;
+	FILE *fp;
+	u_int k;
+	int ret;
+
+	jp=(struct scanjob_s *)arg;
+	fp=jp->resfp[i];
+	if (jp->restartflag){
+		PRINTF_OUT("disk%u\r",i);
+	}
+	FLUSH_ALL;
+	part_num=0;
+	ret=akai_scan_disk(&disk[i],jp->floppyenable);
+	/* result: disk incl. number of partitions, partitions */
+	bzero(&sd,sizeof(struct scandisk_s));
+	sd.type=disk[i].type;
+	sd.blksize=disk[i].blksize;
+	sd.bsize=disk[i].bsize;
+	sd.partnum=part_num;
+	if (fwrite(&sd,sizeof(struct scandisk_s),1,fp)!=1){
+		goto batch_scandisk_error;
+	}
+	for (k=0;k<part_num;k++){
+		bzero(&sp,sizeof(struct scanpart_s));
+		sp.valid=part[k].valid;
+		sp.type=part[k].type;
+		sp.index=part[k].index;
+		sp.blksize=part[k].blksize;
+		sp.bstart=part[k].bstart;
+		sp.bsize=part[k].bsize;
+		sp.csize=part[k].csize;
+		sp.bsyssize=part[k].bsyssize;
+		sp.bfree=part[k].bfree;
+		sp.bbad=part[k].bbad;
+		sp.volnummax=part[k].volnummax;
+		sp.letter=part[k].letter;
+		bcopy(&part[k].head,&sp.head,sizeof(union akai_head_u));
+		if (fwrite(&sp,sizeof(struct scanpart_s),1,fp)!=1){
+			goto batch_scandisk_error;
+		}
+	}
+	if (fflush(fp)!=0){
+		goto batch_scandisk_error;
+	}
+	return (ret<0)?-1:0;
+
+batch_scandisk_error:
+	PRINTF_ERR("disk%u: cannot write scan result\n",i);
+	return -1;
+}
+
+/* scan all disks in parallel, fill part[] in order of disks */
+/* Note: each disk is scanned in a child process, block cache of parent is not filled */
+/* returns 0 if OK, -1 if not possible (caller may scan serially) */
+static int
+scan_alldisks_parallel(int floppyenable,int restartflag)
+{
+	static struct scanjob_s scanjob;
+	static struct scanpart_s sp;
+	struct scandisk_s sd;
+	struct part_s *pp;
+	u_int idx[DISK_NUM_MAX];
+	u_int i,k;
+	FILE *fp;
+	int ret;
+
+	scanjob.floppyenable=floppyenable;
+	scanjob.restartflag=restartflag;
+	ret=0;
+	for (i=0;i<disk_num;i++){
+		idx[i]=i;
+		if ((scanjob.resfp[i]=tmpfile())==NULL){
+			ret=-1;
+		}
+	}
+	if (ret<0){
+		goto scan_alldisks_parallel_exit;
+	}
+
+	batch_run(batch_scandisk,&scanjob,idx,disk_num,NULL); /* Note: errors are handled below */
+
+	/* merge results */
+	part_num=0;
+	for (i=0;i<disk_num;i++){
+		fp=scanjob.resfp[i];
+		rewind(fp);
+		if (fread(&sd,sizeof(struct scandisk_s),1,fp)!=1){
+			PRINTF_OUT("disk%u: scan failed\n",i);
+			continue;
+		}
+		/* Note: disk type and blocksize may have changed */
+		disk[i].type=sd.type;
+		disk[i].blksize=sd.blksize;
+		disk[i].bsize=sd.bsize;
+		for (k=0;k<sd.partnum;k++){
+			if (part_num>=PART_NUM_MAX){
+				PRINTF_OUT("disk%u: max. number (%u) of partitions reached, %u partition(s) ignored\n",
+					i,PART_NUM_MAX,sd.partnum-k);
+				break;
+			}
+			if (fread(&sp,sizeof(struct scanpart_s),1,fp)!=1){
+				PRINTF_OUT("disk%u: scan failed\n",i);
+				break;
+			}
+			pp=&part[part_num];
+			bzero(pp,sizeof(struct part_s));
+			pp->diskp=&disk[i];
+			pp->valid=sp.valid;
+			pp->type=sp.type;
+			pp->index=sp.index;
+			pp->blksize=sp.blksize;
+			pp->bstart=sp.bstart;
+			pp->bsize=sp.bsize;
+			pp->csize=sp.csize;
+			pp->bsyssize=sp.bsyssize;
+			pp->bfree=sp.bfree;
+			pp->bbad=sp.bbad;
+			pp->volnummax=sp.volnummax;
+			pp->letter=sp.letter;
+			bcopy(&sp.head,&pp->head,sizeof(union akai_head_u));
+			/* start of FAT from partition type, as in akai_scan_disk() */
+			akai_fix_partfat(pp);
+			part_num++;
+		}
+	}
+
+scan_alldisks_parallel_exit:
+	for (i=0;i<disk_num;i++){
+		if (scanjob.resfp[i]!=NULL){
+			fclose(scanjob.resfp[i]);
+			scanjob.resfp[i]=NULL;
+		}
+	}
+	return ret;
+}
+#endif /* !_VISUALCPP */
+
+/* batch job: export file fi of volume arg */
+static int
+batch_getfile(void *arg,u_int fi)
+{
+	struct file_s tmpfile;
+	int outfd;
+	int ret;
+
+	if (akai_get_file((struct vol_s *)arg,&tmpfile,fi)<0){
+		return -1;
+	}
+	/* export file */
+	PRINTF_OUT("exporting \"%s\"\n",tmpfile.name);
+	FLUSH_ALL;
+	/* create external file */
+	if ((outfd=OPEN(tmpfile.name,O_RDWR|O_CREAT|O_TRUNC|O_BINARY,0666))<0){
+		PERROR("open");
+		return -2; /* abort */
+	}
+	/* export file */
+	if (akai_read_file(outfd,NULL,&tmpfile,0,tmpfile.size)==0){
+		ret=0;
+	}else{
+		PRINTF_ERR("export error\n");
+		ret=-1;
+	}
+	CLOSE(outfd);
+	return ret;
+}
+
+/* batch job: export sample file fi of volume arg to WAV */
+static int
+batch_sample2wav(void *arg,u_int fi)
+{
+	struct file_s tmpfile;
+
+	if (akai_get_file((struct vol_s *)arg,&tmpfile,fi)<0){
+		return -1;
+	}
+	/* export file */
+	PRINTF_OUT("exporting \"%s\"\n",tmpfile.name);
+	FLUSH_ALL;
+	if (akai_sample2wav(&tmpfile,-1,NULL,NULL,SAMPLE2WAV_ALL)!=0){
+		return -1;
+	}
+	return 0;
+}
+
+/* batch job: export DD take ti of partition arg to WAV */
+static int
+batch_take2wav(void *arg,u_int ti)
+{
+
+	/* export take to WAV */
+	PRINTF_OUT("exporting take %u\n",ti+1);
+	FLUSH_ALL;
+	if (akai_take2wav((struct part_s *)arg,ti,-1,NULL,NULL,TAKE2WAV_ALL)!=0){
+		return -1;
+	}
+	return 0;
+}
+
+
+
 static void
 print_progressbar(u_int end,u_int now)
 {
@@ -76,11 +513,13 @@ usage(char *name)
 	}
 
 #ifdef _VISUALCPP
-	PRINTF_ERR("usage: %s [-h] [-r] [-F] [-C] [-l <lock-file>] [-o <start-offset>] [-s <pseudo-disk-size>] [-n <pseudo-disk-number>] [-c <cdrom-index> ...] [-p <physdrive-index> ...] [[-f] <floppy-drive> ...] [[-f] <disk-file> ...]\n",name);
+	PRINTF_ERR("usage: %s [-h] [-r] [-F] [-C] [-m <cache-size>] [-x] [-l <lock-file>] [-o <start-offset>] [-s <pseudo-disk-size>] [-n <pseudo-disk-number>] [-c <cdrom-index> ...] [-p <physdrive-index> ...] [[-f] <floppy-drive> ...] [[-f] <disk-file> ...]\n",name);
 	PRINTF_ERR("\t-h\tprint this info\n");
 	PRINTF_ERR("\t-r\tread-only mode\n");
 	PRINTF_ERR("\t-F\tdisable floppy filesystem for disk-files/CD-ROM drives/physical drives\n");
 	PRINTF_ERR("\t-C\tdisable cache\n");
+	PRINTF_ERR("\t-m\tset cache size in KB\n");
+	PRINTF_ERR("\t-x\tuse catalog files for disk-files\n");
 	PRINTF_ERR("\t-l\tlock-file\n");
 	PRINTF_ERR("\t-o\tset start offset for disk-file/drive in bytes\n");
 	PRINTF_ERR("\t-s\tset pseudo-disk size in KB\n");
@@ -90,11 +529,16 @@ usage(char *name)
 	PRINTF_ERR("\t-f\tfloppy drive or disk-file\n");
 	PRINTF_ERR("\t\t<floppy-drive> = floppyla: | floppylb: | floppyha: | floppyhb:\n");
 #elif defined(__CYGWIN__)
-	PRINTF_ERR("usage: %s [-h] [-r] [-F] [-C] [-l <lock-file>] [-o <start-offset>] [-s <pseudo-disk-size>] [-n <pseudo-disk-number>] [-c <cdrom-index> ...] [-p <physdrive-index> ...] [[-f] <disk-file> ...]\n",name);
+	PRINTF_ERR("usage: %s [-h] [-r] [-F] [-C] [-m <cache-size>] [-M] [-j <jobs>] [-x] [-O] [-l <lock-file>] [-o <start-offset>] [-s <pseudo-disk-size>] [-n <pseudo-disk-number>] [-c <cdrom-index> ...] [-p <physdrive-index> ...] [[-f] <disk-file> ...]\n",name);
 	PRINTF_ERR("\t-h\tprint this info\n");
 	PRINTF_ERR("\t-r\tread-only mode\n");
 	PRINTF_ERR("\t-F\tdisable floppy filesystem\n");
 	PRINTF_ERR("\t-C\tdisable cache\n");
+	PRINTF_ERR("\t-m\tset cache size in KB\n");
+	PRINTF_ERR("\t-M\tuse memory-mapped I/O for reading disk-files (bypasses cache)\n");
+	PRINTF_ERR("\t-j\tset max. number of parallel jobs for disk scan and getall/sample2wavall/take2wavall\n");
+	PRINTF_ERR("\t-x\tuse catalog files for disk-files\n");
+	PRINTF_ERR("\t-O\tconsole output to stderr, tar-file \"-\" to stdout\n");
 	PRINTF_ERR("\t-l\tlock-file\n");
 	PRINTF_ERR("\t-o\tset start offset for disk-file/drive in bytes\n");
 	PRINTF_ERR("\t-s\tset pseudo-disk size in KB\n");
@@ -103,11 +547,16 @@ usage(char *name)
 	PRINTF_ERR("\t-p\tphysical drive\n");
 	PRINTF_ERR("\t-f\tdisk-file\n");
 #else
-	PRINTF_ERR("usage: %s [-h] [-r] [-F] [-C] [-l <lock-file>] [-o <start-offset>] [-s <pseudo-disk-size>] [-n <pseudo-disk-number>] [[-f] <disk-file> ...]\n",name);
+	PRINTF_ERR("usage: %s [-h] [-r] [-F] [-C] [-m <cache-size>] [-M] [-j <jobs>] [-x] [-O] [-l <lock-file>] [-o <start-offset>] [-s <pseudo-disk-size>] [-n <pseudo-disk-number>] [[-f] <disk-file> ...]\n",name);
 	PRINTF_ERR("\t-h\tprint this info\n");
 	PRINTF_ERR("\t-r\tread-only mode\n");
 	PRINTF_ERR("\t-F\tdisable floppy filesystem\n");
 	PRINTF_ERR("\t-C\tdisable cache\n");
+	PRINTF_ERR("\t-m\tset cache size in KB\n");
+	PRINTF_ERR("\t-M\tuse memory-mapped I/O for reading disk-files (bypasses cache)\n");
+	PRINTF_ERR("\t-j\tset max. number of parallel jobs for disk scan and getall/sample2wavall/take2wavall\n");
+	PRINTF_ERR("\t-x\tuse catalog files for disk-files\n");
+	PRINTF_ERR("\t-O\tconsole output to stderr, tar-file \"-\" to stdout\n");
 	PRINTF_ERR("\t-l\tlock-file\n");
 	PRINTF_ERR("\t-o\tset start offset for disk-file/drive in bytes\n");
 	PRINTF_ERR("\t-s\tset pseudo-disk size in KB\n");
@@ -168,8 +617,12 @@ AKAIUTIL_MAIN(int argc, char **argv)
 	}
 
 	disk_num=0; /* no disks so far */
-	init_blk_cache(); /* init cache */
-	blk_cache_enable=1; /* enable cache */
+	if (init_blk_cache(BLK_CACHE_SIZE_DEF)<0){ /* init cache */
+		PRINTF_ERR("cannot allocate cache, cache disabled\n");
+		blk_cache_enable=0; /* disable cache */
+	}else{
+		blk_cache_enable=1; /* enable cache */
+	}
 #ifdef _VISUALCPP
 	if (fldr_init()<0){
 		mainret=1; /* error */
@@ -205,10 +658,12 @@ AKAIUTIL_MAIN(int argc, char **argv)
 	startoff=0;
 	pseudodisksize=0; /* 0 means: pseudo-disk size is not specified */
 	pseudodisknum=0; /* 0 means: max. number of pseudo-disks is not specified */
-#if defined(_VISUALCPP)||defined(__CYGWIN__)
-#define OPT_STRING "hrFCl:o:s:n:c:p:f:"
+#if defined(_VISUALCPP)
+#define OPT_STRING "hrFCm:Mxl:o:s:n:c:p:f:"
+#elif defined(__CYGWIN__)
+#define OPT_STRING "hrFCm:Mj:xOl:o:s:n:c:p:f:"
 #else
-#define OPT_STRING "hrFCl:o:s:n:f:"
+#define OPT_STRING "hrFCm:Mj:xOl:o:s:n:f:"
 #endif
 	while ((op=getopt(argc,argv,OPT_STRING))!=EOF){
 		switch (op){
@@ -242,8 +697,76 @@ AKAIUTIL_MAIN(int argc, char **argv)
 				goto main_exit;
 			}
 			blk_cache_enable=0; /* disable cache */
+			end_blk_cache(); /* release memory */
 			/* Note: command CMD_ENABLECACHE may enable cache again */
 			break;
+		case 'm':
+			/* Note: -m option must be prior to any disk I/O */
+			if (disk_num>0){
+				PRINTF_ERR("\n-m option must be prior to any disk-file/drive arguments\n");
+				mainret=1; /* error */
+				goto main_exit;
+			}
+			if (strncmp(optarg,"0x",2)==0){
+				j=STRHEX_TO_UINT64(optarg+2)*1024;
+			}else{
+				j=STRDEC_TO_UINT64(optarg)*1024;
+			}
+			if ((j<BLK_CACHE_SIZE_MIN)||(j>BLK_CACHE_SIZE_MAX)){
+				PRINTF_ERR("invalid cache size, must be between %u KB and %u KB\n",BLK_CACHE_SIZE_MIN/1024,BLK_CACHE_SIZE_MAX/1024);
+				mainret=1; /* error */
+				goto main_exit;
+			}
+			if (blk_cache_enable){ /* cache enabled? */
+				if (init_blk_cache((u_int)j)<0){
+					PRINTF_ERR("cannot allocate cache\n");
+					mainret=1; /* error */
+					goto main_exit;
+				}
+			}else{
+				blk_cache_size=(u_int)j; /* for command CMD_ENABLECACHE */
+			}
+			break;
+		case 'M':
+			/* Note: -M option must be prior to any disk-file/drive arguments */
+			if ((!io_map_enable)&&(disk_num>0)){
+				PRINTF_ERR("\n-M option must be prior to any disk-file/drive arguments\n");
+				mainret=1; /* error */
+				goto main_exit;
+			}
+			io_map_enable=1; /* enable memory-mapped I/O */
+			break;
+		case 'x':
+			/* Note: -x option must be prior to any disk-file/drive arguments */
+			if ((!akai_cat_enable)&&(disk_num>0)){
+				PRINTF_ERR("\n-x option must be prior to any disk-file/drive arguments\n");
+				mainret=1; /* error */
+				goto main_exit;
+			}
+			akai_cat_enable=1; /* use catalog files */
+			break;
+#ifndef _VISUALCPP
+		case 'j':
+			i=(u_int)atoi(optarg);
+			if ((i<1)||(i>BATCH_JOBS_MAX)){
+				PRINTF_ERR("invalid number of jobs, must be between 1 and %u\n",BATCH_JOBS_MAX);
+				mainret=1; /* error */
+				goto main_exit;
+			}
+			batchjobs=i;
+			break;
+		case 'O':
+			if (tarstdoutfd<0){
+				/* keep stdout for tar-file "-", console output to stderr */
+				/* Note: no FLUSH_ALL here, buffered console output (if any) shall go to stderr as well */
+				if (((tarstdoutfd=dup(STDOUT_FILENO))<0)||(dup2(STDERR_FILENO,STDOUT_FILENO)<0)){
+					PERROR("dup");
+					mainret=1; /* error */
+					goto main_exit;
+				}
+			}
+			break;
+#endif /* !_VISUALCPP */
 		case 'l':
 			if (lockflag){
 				PRINTF_ERR("\n-l option must not be used multiple times\n");
@@ -401,8 +924,22 @@ main_restart: /* restart with opened disks */
 	if (restartflag){
 		PRINTF_OUT("\nscanning disks\n");
 	}
+	akai_cat_update(); /* Note: before part[] is overwritten */
+	akai_free_nameidx(); /* Note: part[] is overwritten */
+	akai_clear_volres();
 	part_num=0; /* no partitions found so far */
-	for (i=0;i<disk_num;i++){
+	i=0;
+#ifndef _VISUALCPP
+	if ((batchjobs>1)&&(disk_num>1)){
+		if (scan_alldisks_parallel(floppyenable,restartflag)<0){
+			PRINTF_ERR("cannot scan disks in parallel, scanning serially\n");
+			part_num=0;
+		}else{
+			i=disk_num; /* done */
+		}
+	}
+#endif /* !_VISUALCPP */
+	for (;i<disk_num;i++){
 		if (restartflag){
 			PRINTF_OUT("disk%u\r",i);
 		}
@@ -430,6 +967,7 @@ main_restart: /* restart with opened disks */
 	if (restartflag){
 		PRINTF_OUT("done        \n");
 	}
+	akai_cat_sync(); /* take partitions into catalogs */
 	if (disk_num>=DISK_NUM_MAX){
 		PRINTF_OUT("\nmax. number (%u) of disks reached\n",DISK_NUM_MAX);
 	}
@@ -590,6 +1128,7 @@ main_restart: /* restart with opened disks */
 			CMD_TAKE2WAVALL,
 			CMD_TPUT,
 			CMD_WAV2TAKE,
+			CMD_WAVCONV,
 			CMD_TARC,
 			CMD_TARCWAV,
 			CMD_TARX,
@@ -613,8 +1152,10 @@ main_restart: /* restart with opened disks */
 			CMD_MKVOLI3,
 			CMD_MKVOLI3CD,
 			CMD_DIRCACHE,
+			CMD_LSCAT,
 			CMD_DISABLECACHE,
 			CMD_ENABLECACHE,
+			CMD_CACHESIZE,
 			CMD_LOCK,
 			CMD_UNLOCK,
 			CMD_PLAYWAV,
@@ -826,12 +1367,12 @@ main_restart: /* restart with opened disks */
 			{CMD_GETI,"exporti",2,4,NULL,NULL},
 			{CMD_GETALL,"getall",1,1,"","get all files (to external)"},
 			{CMD_GETALL,"exportall",1,1,NULL,NULL},
-			{CMD_SAMPLE2WAV,"sample2wav",2,2,"<file-path>","convert sample file into external WAV file"},
-			{CMD_SAMPLE2WAV,"s2wav",2,2,NULL,NULL},
-			{CMD_SAMPLE2WAV,"getwav",2,2,NULL,NULL},
-			{CMD_SAMPLE2WAVI,"sample2wavi",2,2,"<file-index>","convert sample file into external WAV file"},
-			{CMD_SAMPLE2WAVI,"s2wavi",2,2,NULL,NULL},
-			{CMD_SAMPLE2WAVI,"getwavi",2,2,NULL,NULL},
+			{CMD_SAMPLE2WAV,"sample2wav",2,4,"<file-path> [<begin-sample> [<end-sample>]]","convert sample file into external WAV file"},
+			{CMD_SAMPLE2WAV,"s2wav",2,4,NULL,NULL},
+			{CMD_SAMPLE2WAV,"getwav",2,4,NULL,NULL},
+			{CMD_SAMPLE2WAVI,"sample2wavi",2,4,"<file-index> [<begin-sample> [<end-sample>]]","convert sample file into external WAV file"},
+			{CMD_SAMPLE2WAVI,"s2wavi",2,4,NULL,NULL},
+			{CMD_SAMPLE2WAVI,"getwavi",2,4,NULL,NULL},
 			{CMD_SAMPLE2WAVALL,"sample2wavall",1,1,NULL,"convert all sample files into external WAV files"},
 			{CMD_SAMPLE2WAVALL,"s2wavall",1,1,NULL,NULL},
 			{CMD_SAMPLE2WAVALL,"getwavall",1,1,NULL,NULL},
@@ -870,6 +1411,7 @@ main_restart: /* restart with opened disks */
 			{CMD_WAV2TAKE,"wav2t",2,2,NULL,NULL},
 			{CMD_WAV2TAKE,"tputwav",2,2,NULL,NULL},
 			{CMD_WAV2TAKE,"putwavt",2,2,NULL,NULL},
+			{CMD_WAVCONV,"wavconv",1,3,"[{<sample-rate>|keep} [{dither|trunc}]]","set sample rate and bit reduction for WAV import"},
 			{CMD_TARC,"tarc",2,2,"<tar-file>","tar c from current directory (to external)"},
 			{CMD_TARC,"target",2,2,NULL,NULL},
 			{CMD_TARC,"gettar",2,2,NULL,NULL},
@@ -930,8 +1472,10 @@ main_restart: /* restart with opened disks */
 			{CMD_UNLOCK,"unlock",1,1,"","release lock"},
 			{CMD_DIRCACHE,"dircache",1,1,"","print cache information"},
 			{CMD_DIRCACHE,"lscache",1,1,NULL,NULL},
+			{CMD_LSCAT,"lscat",1,1,"","list catalogs of disk-files"},
 			{CMD_DISABLECACHE,"disablecache",1,1,"","disable cache"},
 			{CMD_ENABLECACHE,"enablecache",1,1,"","enable cache"},
+			{CMD_CACHESIZE,"cachesize",1,2,"[<cache-size>[M]]","print or set cache size (in KB or MB)"},
 			{CMD_PLAYWAV,"playwav",1,2,"[<wav-name>]","start playback of current external WAV file"},
 			{CMD_PLAYWAV,"p",1,2,NULL,NULL},
 			{CMD_STOPWAV,"stopwav",1,1,"","stop playback of current external WAV file"},
@@ -2673,6 +3217,7 @@ main_restart: /* restart with opened disks */
 						/* erase whole disk */
 						PRINTF_OUT("\nerasing disk%u\n",curdiskp->index);
 						FLUSH_ALL;
+						akai_cat_write_disk(curdiskp); /* Note: not tracked by catalog */
 						bzero(fbuf,AKAI_FL_BLOCKSIZE);
 						for (i=0;i<curdiskp->bsize;i++){
 							PRINTF_OUT("\rblock 0x%04x",i);
@@ -3147,8 +3692,9 @@ main_restart: /* restart with opened disks */
 			case CMD_GETDISK:
 				{
 					int outfd;
-					u_int blk;
-					u_char fbuf[AKAI_HD_BLOCKSIZE];
+					u_int blk,bchunk,bmax;
+					u_int i;
+					static u_char fbuf[AKAI_FILE_RUNSIZE];
 
 					save_curdir(1); /* 1: could be modifications */
 					if (curdiskp==NULL){
@@ -3162,6 +3708,13 @@ main_restart: /* restart with opened disks */
 						restore_curdir();
 						goto main_parser_next;
 					}
+					/* blocks per chunk */
+					bmax=AKAI_FILE_RUNSIZE/curdiskp->blksize;
+#ifdef _VISUALCPP
+					if (curdiskp->fldrn>=0){ /* is floppy drive? */
+						bmax=1; /* single blocks, see below */
+					}
+#endif /* _VISUALCPP */
 					/* export */
 					PRINTF_OUT("\n");
 					/* Note: possible error in akai_io_blks() below is ignored */
@@ -3172,7 +3725,7 @@ main_restart: /* restart with opened disks */
 						bzero(fldr_secbuf,AKAI_FL_SECSIZE);
 					}
 #endif /* _VISUALCPP */
-					for (blk=0;blk<curdiskp->bsize;blk++){
+					for (blk=0;blk<curdiskp->bsize;blk+=bchunk){
 						print_progressbar(curdiskp->bsize,blk);
 #ifdef _VISUALCPP
 						/* check if floppy drive but no floppy inserted */
@@ -3181,36 +3734,63 @@ main_restart: /* restart with opened disks */
 							break;
 						}
 #endif /* _VISUALCPP */
-						/* read block */
-						if (io_blks(curdiskp->fd,
+						bchunk=curdiskp->bsize-blk;
+						if (bchunk>bmax){
+							bchunk=bmax;
+						}
+						/* read chunk of blocks */
+						/* Note: bulk data, don't pollute block cache */
+						if ((bchunk==1)
+							||(io_blks(curdiskp->fd,
 #ifdef _VISUALCPP
-									curdiskp->fldrn,
+									   curdiskp->fldrn,
 #endif /* _VISUALCPP */
-									curdiskp->startoff,
-									fbuf,
-									blk,
-									1,
-									curdiskp->blksize,
-									0,IO_BLKS_READ)<0){ /* 0: don't alloc cache */
+									   curdiskp->startoff,
+									   fbuf,
+									   blk,
+									   bchunk,
+									   curdiskp->blksize,
+									   0,IO_BLKS_READ)<0)){ /* 0: don't alloc cache */
+							/* single blocks (or error in chunk) */
+							for (i=0;i<bchunk;i++){
+								/* read block */
+								if (io_blks(curdiskp->fd,
+#ifdef _VISUALCPP
+											curdiskp->fldrn,
+#endif /* _VISUALCPP */
+											curdiskp->startoff,
+											fbuf+i*curdiskp->blksize,
+											blk+i,
+											1,
+											curdiskp->blksize,
+											0,IO_BLKS_READ)<0){ /* 0: don't alloc cache */
 #if 1
-							/* Note: error -> fbuf could contain leftover */
-							PRINTF_ERR("\nerror in block 0x%08x\n\n",blk);
-							FLUSH_ALL;
-							print_progressbar(curdiskp->bsize,0); /* 0: draw scale again */
-							if (blk>0){
-								print_progressbar(curdiskp->bsize,blk); /* draw dots again */
-							}
-							/* XXX ignore error, write current fbuf */
+									/* Note: error -> fbuf could contain leftover */
+									PRINTF_ERR("\nerror in block 0x%08x\n\n",blk+i);
+									FLUSH_ALL;
+									print_progressbar(curdiskp->bsize,0); /* 0: draw scale again */
+									if (blk+i>0){
+										print_progressbar(curdiskp->bsize,blk+i); /* draw dots again */
+									}
+									/* XXX ignore error, write current fbuf */
 #else
-							break;
+									break;
+#endif
+								}
+							}
+#if 0
+							if (i<bchunk){
+								break;
+							}
 #endif
 						}
-						/* write block */
-						if (WRITE(outfd,fbuf,curdiskp->blksize)!=(int)curdiskp->blksize){
+						/* write chunk of blocks */
+						if (WRITE(outfd,fbuf,bchunk*curdiskp->blksize)!=(int)(bchunk*curdiskp->blksize)){
 							PERROR("write");
 							break;
 						}
-						if ((blk+1)>=curdiskp->bsize){ /* end? */
+						if ((blk+bchunk)>=curdiskp->bsize){ /* end? */
+							print_progressbar(curdiskp->bsize,curdiskp->bsize-1); /* remaining dots */
 							PRINTF_OUT("."); /* dot for 100% */
 						}
 					}
@@ -3225,8 +3805,8 @@ main_restart: /* restart with opened disks */
 					int inpfd;
 					struct stat instat;
 					u_int size,bsize;
-					u_int blk;
-					u_char fbuf[AKAI_HD_BLOCKSIZE];
+					u_int blk,bchunk,bmax;
+					static u_char fbuf[AKAI_FILE_RUNSIZE];
 
 					if (blk_cache_enable){ /* cache enabled? */
 						flush_blk_cache(); /* XXX if error, maybe next time more luck */
@@ -3273,18 +3853,26 @@ main_restart: /* restart with opened disks */
 						FLUSH_ALL;
 					}
 					curdiskp->bsize=bsize; /* new partition size */
+					/* blocks per chunk */
+					bmax=AKAI_FILE_RUNSIZE/curdiskp->blksize;
 					/* import */
 					ret=0;
+					akai_cat_write_disk(curdiskp); /* Note: not tracked by catalog */
 					PRINTF_OUT("\n");
-					for (blk=0;blk<curdiskp->bsize;blk++){
+					for (blk=0;blk<curdiskp->bsize;blk+=bchunk){
 						print_progressbar(curdiskp->bsize,blk);
-						/* read block */
-						if (READ(inpfd,fbuf,curdiskp->blksize)!=(int)curdiskp->blksize){
+						bchunk=curdiskp->bsize-blk;
+						if (bchunk>bmax){
+							bchunk=bmax;
+						}
+						/* read chunk of blocks */
+						if (READ(inpfd,fbuf,bchunk*curdiskp->blksize)!=(int)(bchunk*curdiskp->blksize)){
 							PERROR("read");
 							ret=1;
 							break;
 						}
-						/* write block */
+						/* write chunk of blocks */
+						/* Note: bulk data, don't pollute block cache */
 						if (io_blks(curdiskp->fd,
 #ifdef _VISUALCPP
 									curdiskp->fldrn,
@@ -3292,13 +3880,14 @@ main_restart: /* restart with opened disks */
 									curdiskp->startoff,
 									fbuf,
 									blk,
-									1,
+									bchunk,
 									curdiskp->blksize,
 									0,IO_BLKS_WRITE)<0){ /* 0: don't alloc cache */
 							ret=1;
 							break;
 						}
-						if ((blk+1)>=curdiskp->bsize){ /* end? */
+						if ((blk+bchunk)>=curdiskp->bsize){ /* end? */
+							print_progressbar(curdiskp->bsize,curdiskp->bsize-1); /* remaining dots */
 							PRINTF_OUT("."); /* dot for 100% */
 						}
 					}
@@ -4125,10 +4714,12 @@ main_restart: /* restart with opened disks */
 				{
 					struct file_s tmpfile;
 					struct vol_s tmpvol;
+					struct akai_sample2wav_s s2w;
 					u_int sfi;
 					int outfd;
 					u_int begin,end;
 					char *wavname;
+					int ret;
 
 					if ((cmdnr==CMD_GET)||(cmdnr==CMD_SAMPLE2WAV)){
 						save_curdir(0); /* 0: no modifications */
@@ -4206,13 +4797,44 @@ main_restart: /* restart with opened disks */
 						curwavcmdbuf[0]='\0';
 #endif
 						wavname=NULL;
-						if (akai_sample2wav(&tmpfile,-1,NULL,&wavname,SAMPLE2WAV_ALL)!=0){ /* error or not valid sample file? */
-							PRINTF_ERR("cannot export file to WAV\n");
-						}
-						if ((wavname!=NULL)&&(wavname[0]!='\0')){
-							/* use name of last exported WAV file */
-							SNPRINTF(curwavname,CURWAVNAMEMAXLEN,"%s",wavname);
-							PLAYWAV_PREPARE(curwavcmdbuf,CURWAVCMDBUFSIZ,curwavname);
+						if (cmdtoknr<3){
+							/* whole sample */
+							if (akai_sample2wav(&tmpfile,-1,NULL,&wavname,SAMPLE2WAV_ALL)!=0){ /* error or not valid sample file? */
+								PRINTF_ERR("cannot export file to WAV\n");
+							}
+							if ((wavname!=NULL)&&(wavname[0]!='\0')){
+								/* use name of last exported WAV file */
+								SNPRINTF(curwavname,CURWAVNAMEMAXLEN,"%s",wavname);
+								PLAYWAV_PREPARE(curwavcmdbuf,CURWAVCMDBUFSIZ,curwavname);
+							}
+						}else{
+							/* part of sample */
+							ret=-1; /* no success so far */
+							akai_sample2wav_open(&s2w,&tmpfile);
+							if (akai_sample2wav_probe(&s2w,NULL,&wavname)==0){
+								/* limits */
+								begin=(u_int)atoi(cmdtok[2]);
+								if (cmdtoknr>=4){
+									end=(u_int)atoi(cmdtok[3]);
+								}else{
+									end=s2w.samplecount;
+								}
+								if (akai_sample2wav_setrange(&s2w,begin,end,NULL)<0){
+									PRINTF_ERR("invalid range\n");
+								}else if ((outfd=OPEN(wavname,O_RDWR|O_CREAT|O_TRUNC|O_BINARY,0666))<0){
+									PERROR("create WAV");
+								}else{
+									ret=akai_sample2wav_convert(&s2w,outfd);
+									CLOSE(outfd);
+									/* use name of last exported WAV file */
+									SNPRINTF(curwavname,CURWAVNAMEMAXLEN,"%s",wavname);
+									PLAYWAV_PREPARE(curwavcmdbuf,CURWAVCMDBUFSIZ,curwavname);
+								}
+							}
+							if (ret<0){
+								PRINTF_ERR("cannot export file to WAV\n");
+							}
+							akai_sample2wav_close(&s2w);
 						}
 					}
 				}
@@ -4221,46 +4843,47 @@ main_restart: /* restart with opened disks */
 				{
 					struct file_s tmpfile;
 					u_int sfi;
-					int outfd;
-					u_int fcount;
+					u_int *fidx;
+					u_int fnum;
+					int fcount;
 
 					if (check_curnosamplervol()){ /* not inside a sampler volume? */
 						PRINTF_ERR("must be inside a volume\n");
 						goto main_parser_next;
 					}
+					fidx=(u_int *)malloc(curvolp->fimax*sizeof(u_int));
+					if (fidx==NULL){
+						PRINTF_ERR("cannot allocate memory\n");
+						goto main_parser_next;
+					}
 					/* all files in current volume */
-					fcount=0;
+					fnum=0;
 					for (sfi=0;sfi<curvolp->fimax;sfi++){
 						/* find file in current volume */
 						if (akai_get_file(curvolp,&tmpfile,sfi)<0){
 							continue; /* next */
 						}
-						/* export file */
-						PRINTF_OUT("exporting \"%s\"\n",tmpfile.name);
-						FLUSH_ALL;
-						/* create external file */
-						if ((outfd=OPEN(tmpfile.name,O_RDWR|O_CREAT|O_TRUNC|O_BINARY,0666))<0){
-							PERROR("open");
-							goto main_parser_next;
-						}
-						/* export file */
-						if (akai_read_file(outfd,NULL,&tmpfile,0,tmpfile.size)==0){
-							fcount++;
-						}else{
-							PRINTF_ERR("export error\n");
-							/* XXX continue */
-						}
-						CLOSE(outfd);
+						fidx[fnum++]=sfi;
+					}
+					/* export files */
+					fcount=batch_run(batch_getfile,(void *)curvolp,fidx,fnum,NULL);
+					free(fidx);
+					if (fcount<0){
+						goto main_parser_next;
 					}
 					FLUSH_ALL;
-					PRINTF_OUT("exported %u file(s)\n",fcount);
+					PRINTF_OUT("exported %u file(s)\n",(u_int)fcount);
 				}
 				break;
 			case CMD_SAMPLE2WAVALL:
 				{
 					struct file_s tmpfile;
+					struct akai_sample2wav_s s2w;
 					u_int sfi;
-					u_int fcount;
+					u_int *fidx;
+					u_int fnum;
+					u_int lastfi;
+					int fcount;
 					char *wavname;
 
 					if (check_curnosamplervol()){ /* not inside a sampler volume? */
@@ -4273,28 +4896,41 @@ main_restart: /* restart with opened disks */
 					curwavname[0]='\0';
 					curwavcmdbuf[0]='\0';
 #endif
+					fidx=(u_int *)malloc(curvolp->fimax*sizeof(u_int));
+					if (fidx==NULL){
+						PRINTF_ERR("cannot allocate memory\n");
+						goto main_parser_next;
+					}
 					/* all files in current volume */
-					fcount=0;
-					wavname=NULL;
+					fnum=0;
 					for (sfi=0;sfi<curvolp->fimax;sfi++){
 						/* find file in current volume */
 						if (akai_get_file(curvolp,&tmpfile,sfi)<0){
 							continue; /* next */
 						}
-						/* export file */
-						PRINTF_OUT("exporting \"%s\"\n",tmpfile.name);
-						FLUSH_ALL;
-						if (akai_sample2wav(&tmpfile,-1,NULL,&wavname,SAMPLE2WAV_ALL)==0){
-							fcount++;
-						} /* XXX else: continue */
+						fidx[fnum++]=sfi;
 					}
-					if ((wavname!=NULL)&&(wavname[0]!='\0')){
-						/* use name of last exported WAV file */
-						SNPRINTF(curwavname,CURWAVNAMEMAXLEN,"%s",wavname);
-						PLAYWAV_PREPARE(curwavcmdbuf,CURWAVCMDBUFSIZ,curwavname);
+					/* export files */
+					lastfi=curvolp->fimax; /* none so far */
+					fcount=batch_run(batch_sample2wav,(void *)curvolp,fidx,fnum,&lastfi);
+					free(fidx);
+					/* XXX else: continue */
+					if ((lastfi<curvolp->fimax)&&(akai_get_file(curvolp,&tmpfile,lastfi)==0)){
+						/* determine name of last exported WAV file */
+						akai_sample2wav_open(&s2w,&tmpfile);
+						wavname=NULL;
+						if (akai_sample2wav_probe(&s2w,NULL,&wavname)!=0){
+							wavname=NULL;
+						}
+						if ((wavname!=NULL)&&(wavname[0]!='\0')){
+							/* use name of last exported WAV file */
+							SNPRINTF(curwavname,CURWAVNAMEMAXLEN,"%s",wavname);
+							PLAYWAV_PREPARE(curwavcmdbuf,CURWAVCMDBUFSIZ,curwavname);
+						}
+						akai_sample2wav_close(&s2w);
 					}
 					FLUSH_ALL;
-					PRINTF_OUT("exported %u file(s)\n",fcount);
+					PRINTF_OUT("exported %u file(s)\n",(fcount<0)?0:(u_int)fcount);
 				}
 				break;
 			case CMD_PUT:
@@ -4853,8 +5489,12 @@ main_restart: /* restart with opened disks */
 				break;
 			case CMD_TAKE2WAVALL:
 				{
+					struct akai_take2wav_s t2w;
 					u_int ti;
-					u_int tcount;
+					static u_int tidx[AKAI_DDTAKE_MAXNUM];
+					u_int tnum;
+					u_int lastti;
+					int tcount;
 					char *wavname;
 
 					if (check_curnoddpart()){ /* not on DD partition level? */
@@ -4868,27 +5508,32 @@ main_restart: /* restart with opened disks */
 					curwavcmdbuf[0]='\0';
 #endif
 					/* all DD takes in current DD partition */
-					tcount=0;
-					wavname=NULL;
+					tnum=0;
 					for (ti=0;ti<AKAI_DDTAKE_MAXNUM;ti++){
 						/* take */
 						if (curpartp->head.dd.take[ti].stat==AKAI_DDTAKESTAT_FREE){ /* free? */
 							continue; /* next */
 						}
-						/* export take to WAV */
-						PRINTF_OUT("exporting take %u\n",ti+1);
-						FLUSH_ALL;
-						if (akai_take2wav(curpartp,ti,-1,NULL,&wavname,TAKE2WAV_ALL)==0){
-							tcount++;
-						} /* XXX else: continue */
+						tidx[tnum++]=ti;
 					}
-					if ((wavname!=NULL)&&(wavname[0]!='\0')){
-						/* use name of last exported WAV file */
-						SNPRINTF(curwavname,CURWAVNAMEMAXLEN,"%s",wavname);
-						PLAYWAV_PREPARE(curwavcmdbuf,CURWAVCMDBUFSIZ,curwavname);
+					/* export takes to WAV */
+					lastti=AKAI_DDTAKE_MAXNUM; /* none so far */
+					tcount=batch_run(batch_take2wav,(void *)curpartp,tidx,tnum,&lastti);
+					/* XXX else: continue */
+					if (lastti<AKAI_DDTAKE_MAXNUM){
+						/* determine name of last exported WAV file */
+						wavname=NULL;
+						if ((akai_take2wav_open(&t2w,curpartp,lastti)==0)
+							&&(akai_take2wav_probe(&t2w,NULL,&wavname)==0)
+							&&(wavname!=NULL)&&(wavname[0]!='\0')){
+							/* use name of last exported WAV file */
+							SNPRINTF(curwavname,CURWAVNAMEMAXLEN,"%s",wavname);
+							PLAYWAV_PREPARE(curwavcmdbuf,CURWAVCMDBUFSIZ,curwavname);
+						}
+						akai_take2wav_close(&t2w);
 					}
 					FLUSH_ALL;
-					PRINTF_OUT("exported %u take(s)\n",tcount);
+					PRINTF_OUT("exported %u take(s)\n",(tcount<0)?0:(u_int)tcount);
 				}
 				break;
 			case CMD_TPUT:
@@ -5192,12 +5837,59 @@ main_restart: /* restart with opened disks */
 					}
 				}
 				break;
+			case CMD_WAVCONV:
+				if (cmdtoknr>1){
+					/* sample rate */
+					if (strcasecmp(cmdtok[1],"keep")==0){
+						wav_conv_samprate=0; /* keep sample rate of WAV file */
+					}else{
+						u_int srate;
+
+						srate=(u_int)atoi(cmdtok[1]);
+						if ((srate<1)||(srate>0xffff)){ /* Note: 16bit sample rate in sample header */
+							PRINTF_ERR("invalid sample rate\n");
+							goto main_parser_next;
+						}
+						wav_conv_samprate=srate;
+					}
+				}
+				if (cmdtoknr>2){
+					/* bit reduction */
+					if (strcasecmp(cmdtok[2],"dither")==0){
+						wav_conv_dither=1;
+					}else if (strcasecmp(cmdtok[2],"trunc")==0){
+						wav_conv_dither=0;
+					}else{
+						PRINTF_ERR("invalid bit reduction\n");
+						goto main_parser_next;
+					}
+				}
+				if (wav_conv_samprate==0){
+					PRINTF_OUT("WAV import sample rate: keep\n");
+				}else{
+					PRINTF_OUT("WAV import sample rate: %u Hz\n",wav_conv_samprate);
+				}
+				PRINTF_OUT("WAV import bit reduction: %s\n\n",wav_conv_dither?"dither":"trunc");
+				break;
 			case CMD_TARC:
 			case CMD_TARCWAV:
 				{
 					int outfd;
+					int stdoutflag;
 					u_int flags;
 
+					stdoutflag=0;
+#ifndef _VISUALCPP
+					if (strcmp(cmdtok[1],TAR_STDOUT_NAME)==0){
+						if (tarstdoutfd<0){
+							PRINTF_ERR("tar-file \"%s\" requires -O option\n",TAR_STDOUT_NAME);
+							goto main_parser_next;
+						}
+						/* tar-file to stdout */
+						outfd=tarstdoutfd;
+						stdoutflag=1;
+					}else
+#endif /* !_VISUALCPP */
 					/* create tar-file */
 					if ((outfd=OPEN(cmdtok[1],O_RDWR|O_CREAT|O_TRUNC|O_BINARY,0666))<0){
 						PERROR("open");
@@ -5222,7 +5914,9 @@ main_restart: /* restart with opened disks */
 					if (tar_export_tailzero(outfd)<0){
 						PRINTF_ERR("tar error\n");
 					}
-					CLOSE(outfd);
+					if (!stdoutflag){
+						CLOSE(outfd);
+					}
 				}
 				break;
 			case CMD_TARX:
@@ -5457,6 +6151,11 @@ main_restart: /* restart with opened disks */
 					PRINTF_OUT("cache is not enabled\n\n");
 				}
 				break;
+			case CMD_LSCAT:
+				PRINTF_OUT("\n");
+				akai_cat_list();
+				PRINTF_OUT("\n");
+				break;
 			case CMD_DISABLECACHE:
 				if (blk_cache_enable){ /* cache enabled? */
 					if (flush_blk_cache()<0){
@@ -5465,16 +6164,59 @@ main_restart: /* restart with opened disks */
 						FLUSH_ALL;
 						flush_blk_cache(); /* XXX if error, too late */
 					}
-					free_blk_cache();
+					end_blk_cache(); /* release memory */
 					blk_cache_enable=0; /* disable cache */
+					akai_clear_volres(); /* Note: not used without cache */
 				}
 				break;
 			case CMD_ENABLECACHE:
 				if (!blk_cache_enable){ /* cache disabled? */
-					init_blk_cache(); /* XXX actually not necessary here (after init_blk_cache() or free_blk_cache()) */
+					if (init_blk_cache(0)<0){ /* 0: current cache size */
+						PRINTF_ERR("cannot allocate cache\n");
+						break;
+					}
 					blk_cache_enable=1; /* enable cache */
 				}
 				break;
+			case CMD_CACHESIZE:
+				if (cmdtoknr>=2){
+					u_int l;
+					U_INT64 cachesize;
+
+					l=(u_int)strlen(cmdtok[1]);
+					if ((l>=1)&&((cmdtok[1][l-1]=='M')||(cmdtok[1][l-1]=='m'))){ /* in MB? */
+						cmdtok[1][l-1]='\0'; /* XXX remove letter */
+						l=1024*1024; /* MB */
+					}else{
+						l=1024; /* KB */
+					}
+					cachesize=((U_INT64)l)*(U_INT64)atoi(cmdtok[1]);
+					if ((cachesize<BLK_CACHE_SIZE_MIN)||(cachesize>BLK_CACHE_SIZE_MAX)){
+						PRINTF_ERR("invalid cache size, must be between %u KB and %u KB\n",BLK_CACHE_SIZE_MIN/1024,BLK_CACHE_SIZE_MAX/1024);
+						goto main_parser_next;
+					}
+					if (blk_cache_enable){ /* cache enabled? */
+						/* Note: must not lose modified blocks */
+						if (flush_blk_cache()<0){
+							PRINTF_ERR("cannot flush cache, cache size not changed\n");
+							goto main_parser_next;
+						}
+						if (init_blk_cache((u_int)cachesize)<0){
+							PRINTF_ERR("cannot allocate cache, cache disabled\n");
+							blk_cache_enable=0; /* disable cache */
+							goto main_parser_next;
+						}
+					}else{
+						blk_cache_size=(u_int)cachesize; /* for command CMD_ENABLECACHE */
+					}
+				}
+				PRINTF_OUT("cache size: %u KB",blk_cache_size/1024);
+				if (blk_cache_enable){ /* cache enabled? */
+					PRINTF_OUT(" (%u entries)\n",blk_cache_num);
+				}else{
+					PRINTF_OUT(" (cache is not enabled)\n");
+				}
+				break;
 			case CMD_LOCK:
 #ifdef _VISUALCPP
 				if (lockh!=INVALID_HANDLE_VALUE){
@@ -5611,8 +6353,12 @@ main_exit:
 			FLUSH_ALL;
 			flush_blk_cache(); /* XXX if error, too late */
 		}
-		free_blk_cache();
 	}
+	end_blk_cache(); /* release memory */
+	akai_free_nameidx(); /* release memory */
+
+	/* save catalogs */
+	akai_cat_closeall();
 
 	/* close all disk-files/drives */
 	close_alldisks();
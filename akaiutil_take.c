@@ -312,7 +312,8 @@ akai_import_take(int inpfd,struct part_s *pp,struct akai_ddtake_s *tp,u_int ti,u
 
 	if (csizes>0){
 		/* sample */
-		if (akai_import_ddfatchain(pp,cstarts,0,samplesize,inpfd,NULL)<0){
+		/* Note: if no envelope in file, calculate envelope from sample on the fly */
+		if (akai_take_importsample(pp,cstarts,samplesize,inpfd,NULL,16,NULL,envbuf,envsiz)<0){
 			PRINTF_ERR("cannot import DD take\n");
 			goto akai_import_take_exit;
 		}
@@ -321,10 +322,7 @@ akai_import_take(int inpfd,struct part_s *pp,struct akai_ddtake_s *tp,u_int ti,u
 	if (csizee>0){
 		/* envelope */
 		if (envbuf!=NULL){ /* no envelope in file? (see above) */
-			/* calculate envelope from sample */
-			if (akai_take_setenv(pp,cstarts,samplesize,envbuf,envsiz)<0){
-				goto akai_import_take_exit;
-			}
+			/* Note: envelope has been calculated from sample above */
 			/* write envelope to DD take */
 			if (akai_import_ddfatchain(pp,cstarte,0,envsiz,-1,envbuf)<0){
 				PRINTF_ERR("cannot save envelope\n");
@@ -395,17 +393,15 @@ akai_export_take(int outfd,struct part_s *pp,struct akai_ddtake_s *tp,u_int csiz
 
 
 int
-akai_take2wav(struct part_s *pp,u_int ti,int wavfd,u_int *sizep,char **wavnamep,int what)
+akai_take2wav_open(struct akai_take2wav_s *cp,struct part_s *pp,u_int ti)
 {
-	/* Note: static for multiple calls with different what */
-	static u_int cstarts;
-	static u_int samplestart;
-	static u_int samplesize;
-	static u_int samplerate;
-	static u_int samplechnr;
-	static int ret;
-	static char wavname[AKAI_NAME_LEN+4+1]; /* name (ASCII), +4 for ".<type>", +1 for '\0' */
-	static u_int nlen;
+
+	if (cp==NULL){
+		return -1;
+	}
+
+	cp->pp=NULL;
+	cp->probed=0;
 
 	if ((pp==NULL)||(!pp->valid)||(pp->fat==NULL)){
 		return -1;
@@ -418,160 +414,236 @@ akai_take2wav(struct part_s *pp,u_int ti,int wavfd,u_int *sizep,char **wavnamep,
 		return -1;
 	}
 
-	ret=-1; /* no success so far */
+	cp->pp=pp;
+	cp->ti=ti;
 
-	if (what&TAKE2WAV_CHECK){
+	return 0;
+}
 
-		if (pp->head.dd.take[ti].stat==AKAI_DDTAKESTAT_FREE){ /* free? */
-			return -1;
-		}
 
-		/* sample start cluster */
-		cstarts=(pp->head.dd.take[ti].cstarts[1]<<8)
-			    +pp->head.dd.take[ti].cstarts[0];
-		if (cstarts!=0){ /* sample not empty? */
+
+/* check take, determine WAV file size and WAV name */
+/* Note: *wavnamep points to buffer within context */
+int
+akai_take2wav_probe(struct akai_take2wav_s *cp,u_int *sizep,char **wavnamep)
+{
+	struct part_s *pp;
+	u_int ti;
+	u_int nlen;
+
+	if ((cp==NULL)||(cp->pp==NULL)){
+		return -1;
+	}
+	pp=cp->pp;
+	ti=cp->ti;
+	cp->probed=0;
+
+	if (pp->head.dd.take[ti].stat==AKAI_DDTAKESTAT_FREE){ /* free? */
+		return -1;
+	}
+
+	/* sample start cluster */
+	cp->cstarts=(pp->head.dd.take[ti].cstarts[1]<<8)
+		    +pp->head.dd.take[ti].cstarts[0];
+	if (cp->cstarts!=0){ /* sample not empty? */
 #if 1
-			/* Note: words are 16bit */
-			/* start word */
-			samplestart=(pp->head.dd.take[ti].wstart[3]<<24)
-				+(pp->head.dd.take[ti].wstart[2]<<16)
-				+(pp->head.dd.take[ti].wstart[1]<<8)
-				+pp->head.dd.take[ti].wstart[0];
-			/* end word */
-			samplesize=(pp->head.dd.take[ti].wend[3]<<24)
-				+(pp->head.dd.take[ti].wend[2]<<16)
-				+(pp->head.dd.take[ti].wend[1]<<8)
-				+pp->head.dd.take[ti].wend[0];
-			if (samplesize<samplestart){ /* end<start? */
-				return -1;
-			}
-			samplesize-=samplestart; /* size in words */
-			samplestart*=2; /* *2 for 16bit per sample word */
-			samplesize*=2; /* *2 for 16bit per sample word */
-			/* XXX check samplestart and samplesize */
+		/* Note: words are 16bit */
+		/* start word */
+		cp->samplestart=(pp->head.dd.take[ti].wstart[3]<<24)
+			+(pp->head.dd.take[ti].wstart[2]<<16)
+			+(pp->head.dd.take[ti].wstart[1]<<8)
+			+pp->head.dd.take[ti].wstart[0];
+		/* end word */
+		cp->samplesize=(pp->head.dd.take[ti].wend[3]<<24)
+			+(pp->head.dd.take[ti].wend[2]<<16)
+			+(pp->head.dd.take[ti].wend[1]<<8)
+			+pp->head.dd.take[ti].wend[0];
+		if (cp->samplesize<cp->samplestart){ /* end<start? */
+			return -1;
+		}
+		cp->samplesize-=cp->samplestart; /* size in words */
+		cp->samplestart*=2; /* *2 for 16bit per sample word */
+		cp->samplesize*=2; /* *2 for 16bit per sample word */
+		/* XXX check samplestart and samplesize */
 #else
-			/* all clusters */
-			samplestart=0;
-			samplesize=akai_count_ddfatchain(pp,cstarts)*AKAI_DDPART_CBLKS*AKAI_HD_BLOCKSIZE; /* in bytes */
+		/* all clusters */
+		cp->samplestart=0;
+		cp->samplesize=akai_count_ddfatchain(pp,cp->cstarts)*AKAI_DDPART_CBLKS*AKAI_HD_BLOCKSIZE; /* in bytes */
 #endif
-		}else{
-			samplestart=0;
-			samplesize=0;
-		}
-		/* Note: samplesize==0 is allowed here */
+	}else{
+		cp->samplestart=0;
+		cp->samplesize=0;
+	}
+	/* Note: samplesize==0 is allowed here */
 
-		/* take parameters */
-		samplerate=(pp->head.dd.take[ti].srate[1]<<8)
-			+pp->head.dd.take[ti].srate[0];
-		samplechnr=(pp->head.dd.take[ti].stype==AKAI_DDTAKESTYPE_MONO)?1:2;
+	/* take parameters */
+	cp->samplerate=(pp->head.dd.take[ti].srate[1]<<8)
+		+pp->head.dd.take[ti].srate[0];
+	cp->samplechnr=(pp->head.dd.take[ti].stype==AKAI_DDTAKESTYPE_MONO)?1:2;
 
 #ifdef DEBUG
-		PRINTF_OUT("samplestart: %15u bytes\n",samplestart);
-		PRINTF_OUT("samplesize:  %15u bytes\n",samplesize);
-		PRINTF_OUT("samplerate:  %15u Hz\n",samplerate);
-		PRINTF_OUT("samplechnr:  %15u\n",samplechnr);
+	PRINTF_OUT("samplestart: %15u bytes\n",cp->samplestart);
+	PRINTF_OUT("samplesize:  %15u bytes\n",cp->samplesize);
+	PRINTF_OUT("samplerate:  %15u Hz\n",cp->samplerate);
+	PRINTF_OUT("samplechnr:  %15u\n",cp->samplechnr);
 #endif
 
-		if (sizep!=NULL){
-			/* WAV file size */
-			*sizep=WAV_HEAD_SIZE+samplesize;
+	if (sizep!=NULL){
+		/* WAV file size */
+		*sizep=WAV_HEAD_SIZE+cp->samplesize;
 #ifndef WAV_AKAIHEAD_DISABLE
-			*sizep+=sizeof(struct wav_chunkhead_s)+sizeof(struct akai_ddtake_s); /* DD take header chunk (see below) */
+		*sizep+=sizeof(struct wav_chunkhead_s)+sizeof(struct akai_ddtake_s); /* DD take header chunk (see below) */
 #endif
-		}
+	}
 
-		/* create WAV name */
-		akai2ascii_name(pp->head.dd.take[ti].name,wavname,0); /* 0: not S900 */
-		nlen=(u_int)strlen(wavname);
-		bcopy(".wav",wavname+nlen,5);
+	/* create WAV name */
+	akai2ascii_name(pp->head.dd.take[ti].name,cp->wavname,0); /* 0: not S900 */
+	nlen=(u_int)strlen(cp->wavname);
+	bcopy(".wav",cp->wavname+nlen,5);
 
-		if (wavnamep!=NULL){
-			/* pointer to name (wavname must be static!) */
-			*wavnamep=wavname;
-		}
+	if (wavnamep!=NULL){
+		/* pointer to name in context */
+		*wavnamep=cp->wavname;
 	}
 
-	if (what&TAKE2WAV_EXPORT){
+	cp->probed=1;
 
-		if (what&TAKE2WAV_CREATE){
-			/* create WAV file */
-			if ((wavfd=OPEN(wavname,O_RDWR|O_CREAT|O_TRUNC|O_BINARY,0666))<0){
-				PERROR("create WAV");
-				goto akai_take2wav_exit;
-			}
-		}
+	return 0;
+}
+
+
+
+/* write WAV file (header, sample and DD take header chunk) to wavfd */
+/* Note: akai_take2wav_probe() must have been successful before */
+int
+akai_take2wav_convert(struct akai_take2wav_s *cp,int wavfd)
+{
+	struct part_s *pp;
+	u_int ti;
+
+	if ((cp==NULL)||(!cp->probed)){
+		return -1;
+	}
+	pp=cp->pp;
+	ti=cp->ti;
 
-		/* write WAV header */
-		if (wav_write_head(wavfd,
-						   samplesize,samplechnr,samplerate,16, /* 16: 16bit */
+	/* write WAV header */
+	if (wav_write_head(wavfd,
+					   cp->samplesize,cp->samplechnr,cp->samplerate,16, /* 16: 16bit */
 #ifndef WAV_AKAIHEAD_DISABLE
-						   sizeof(struct wav_chunkhead_s)+sizeof(struct akai_ddtake_s) /* DD take header chunk (see below) */
+					   sizeof(struct wav_chunkhead_s)+sizeof(struct akai_ddtake_s) /* DD take header chunk (see below) */
 #else
-						   0
+					   0
 #endif
-						   )<0){
-			PRINTF_ERR("cannot write WAV header\n");
-			goto akai_take2wav_exit;
-		}
+					   )<0){
+		PRINTF_ERR("cannot write WAV header\n");
+		return -1;
+	}
 
-		if (samplesize>0){
-			/* Note: no sample format conversion necessary */
-			/* export sample */
-			if (akai_export_ddfatchain(pp,cstarts,samplestart,samplesize,wavfd,NULL)<0){
-				PERROR("write WAV samples");
-				goto akai_take2wav_exit;
-			}
+	if (cp->samplesize>0){
+		/* Note: no sample format conversion necessary */
+		/* export sample */
+		if (akai_export_ddfatchain(pp,cp->cstarts,cp->samplestart,cp->samplesize,wavfd,NULL)<0){
+			PERROR("write WAV samples");
+			return -1;
 		}
+	}
 
 #ifndef WAV_AKAIHEAD_DISABLE
-		{
-			struct wav_chunkhead_s wavchunkhead;
-			struct akai_ddtake_s t;
-			u_int hdrsize;
-			u_int csizes;
-
-			/* create DD take header chunk */
-			bcopy(WAV_CHUNKHEAD_AKAIDDTAKEHEADSTR,wavchunkhead.typestr,4);
-			hdrsize=sizeof(struct akai_ddtake_s);
-			wavchunkhead.csize[0]=0xff&hdrsize;
-			wavchunkhead.csize[1]=0xff&(hdrsize>>8);
-			wavchunkhead.csize[2]=0xff&(hdrsize>>16);
-			wavchunkhead.csize[3]=0xff&(hdrsize>>24);
-			/* write WAV chunk header */
-			if (WRITE(wavfd,(u_char *)&wavchunkhead,sizeof(struct wav_chunkhead_s))!=(int)sizeof(struct wav_chunkhead_s)){
-				PERROR("write WAV chunk");
-				goto akai_take2wav_exit;
-			}
-			/* get DD take header from directory entry */
-			bcopy((u_char *)&pp->head.dd.take[ti],&t,hdrsize);
-			/* determine csizes (sample clusters) and csizee (envelope clusters) */
-			csizes=akai_count_ddfatchain(pp,cstarts);
-			/* Note: no envelope in WAV file -> csizee=0 */
-			/* XXX use cstarts/cstarte fields in DD take header for csizes/csizee */
-			t.cstarts[1]=0xff&(csizes>>8);
-			t.cstarts[0]=0xff&csizes;
-			t.cstarte[1]=0x00;
-			t.cstarte[0]=0x00;
-			/* write DD take header */
-			if (WRITE(wavfd,(u_char *)&t,hdrsize)!=(int)hdrsize){
-				PERROR("write WAV chunk");
-				goto akai_take2wav_exit;
-			}
+	{
+		struct wav_chunkhead_s wavchunkhead;
+		struct akai_ddtake_s t;
+		u_int hdrsize;
+		u_int csizes;
+
+		/* create DD take header chunk */
+		bcopy(WAV_CHUNKHEAD_AKAIDDTAKEHEADSTR,wavchunkhead.typestr,4);
+		hdrsize=sizeof(struct akai_ddtake_s);
+		wavchunkhead.csize[0]=0xff&hdrsize;
+		wavchunkhead.csize[1]=0xff&(hdrsize>>8);
+		wavchunkhead.csize[2]=0xff&(hdrsize>>16);
+		wavchunkhead.csize[3]=0xff&(hdrsize>>24);
+		/* write WAV chunk header */
+		if (WRITE(wavfd,(u_char *)&wavchunkhead,sizeof(struct wav_chunkhead_s))!=(int)sizeof(struct wav_chunkhead_s)){
+			PERROR("write WAV chunk");
+			return -1;
 		}
+		/* get DD take header from directory entry */
+		bcopy((u_char *)&pp->head.dd.take[ti],&t,hdrsize);
+		/* determine csizes (sample clusters) and csizee (envelope clusters) */
+		csizes=akai_count_ddfatchain(pp,cp->cstarts);
+		/* Note: no envelope in WAV file -> csizee=0 */
+		/* XXX use cstarts/cstarte fields in DD take header for csizes/csizee */
+		t.cstarts[1]=0xff&(csizes>>8);
+		t.cstarts[0]=0xff&csizes;
+		t.cstarte[1]=0x00;
+		t.cstarte[0]=0x00;
+		/* write DD take header */
+		if (WRITE(wavfd,(u_char *)&t,hdrsize)!=(int)hdrsize){
+			PERROR("write WAV chunk");
+			return -1;
+		}
+	}
 #endif
 #if 1
-		PRINTF_OUT("DD take exported to WAV\n");
+	PRINTF_OUT("DD take exported to WAV\n");
 #endif
+
+	return 0;
+}
+
+
+
+void
+akai_take2wav_close(struct akai_take2wav_s *cp)
+{
+
+	if (cp==NULL){
+		return;
 	}
 
-	ret=0; /* success */
+	cp->probed=0;
+}
 
-akai_take2wav_exit:
-	if (what&TAKE2WAV_CREATE){
-		if (wavfd>=0){
+
+
+int
+akai_take2wav(struct part_s *pp,u_int ti,int wavfd,u_int *sizep,char **wavnamep,int what)
+{
+	/* Note: static for multiple calls with different what */
+	static struct akai_take2wav_s t2w;
+	int ret;
+
+	if (what&TAKE2WAV_CHECK){
+		if (akai_take2wav_open(&t2w,pp,ti)<0){
+			return -1;
+		}
+		if (akai_take2wav_probe(&t2w,sizep,wavnamep)<0){
+			akai_take2wav_close(&t2w);
+			return -1;
+		}
+	}
+
+	ret=0; /* success so far */
+
+	if (what&TAKE2WAV_EXPORT){
+		if (what&TAKE2WAV_CREATE){
+			/* create WAV file */
+			if ((wavfd=OPEN(t2w.wavname,O_RDWR|O_CREAT|O_TRUNC|O_BINARY,0666))<0){
+				PERROR("create WAV");
+				akai_take2wav_close(&t2w);
+				return -1;
+			}
+		}
+
+		ret=akai_take2wav_convert(&t2w,wavfd);
+
+		if (what&TAKE2WAV_CREATE){
 			CLOSE(wavfd);
 		}
+		akai_take2wav_close(&t2w);
 	}
+
 	return ret;
 }
 
@@ -586,10 +658,10 @@ akai_wav2take(int wavfd,char *wavname,struct part_s *pp,u_int ti,u_int *bcountp,
 	static u_int samplesize;
 	static u_int wavchnr;
 	static u_int wavbitnr;
+	static u_int wavftag;
+	static struct wav_conv_s wavconv;
 	static u_int wavsamplesize;
-	static u_int wavsamplesizealloc;
 	static u_int wavsamplecount;
-	static u_char *wavbuf;
 	static char *errstrp;
 	static u_int nlen;
 	static char name[AKAI_NAME_LEN+1]; /* name (ASCII), +1 for '\0' */
@@ -602,7 +674,7 @@ akai_wav2take(int wavfd,char *wavname,struct part_s *pp,u_int ti,u_int *bcountp,
 	static u_int extrasize;
 	static int wavakaiheadfound;
 #endif
-	static u_int i,j;
+	static int r;
 	static int ret;
 
 	if (bcountp!=NULL){
@@ -636,7 +708,7 @@ akai_wav2take(int wavfd,char *wavname,struct part_s *pp,u_int ti,u_int *bcountp,
 	ret=-1; /* no success so far */
 	bcount=0; /* no bytes read yet */
 	envbuf=NULL; /* not allocated yet */
-	wavbuf=NULL; /* not allocated yet */
+	wav_conv_free(&wavconv); /* not allocated yet */
 
 	if (what&WAV2TAKE_OPEN){
 		/* open external WAV file */
@@ -649,6 +721,7 @@ akai_wav2take(int wavfd,char *wavname,struct part_s *pp,u_int ti,u_int *bcountp,
 	/* read and parse WAV header */
 	if (wav_read_head(wavfd,&bcount,
 					  &wavsamplesize,&wavchnr,&samplerate,&wavbitnr,
+					  &wavftag,
 #ifndef WAV_AKAIHEAD_DISABLE
 					  &extrasize,
 #else
@@ -669,16 +742,30 @@ akai_wav2take(int wavfd,char *wavname,struct part_s *pp,u_int ti,u_int *bcountp,
 		ret=1; /* no error */
 		goto akai_wav2take_exit;
 	}
-	if ((wavbitnr!=8)&&(wavbitnr!=16)&&(wavbitnr!=24)&&(wavbitnr!=32)){
-		PRINTF_ERR("invalid WAV format, must be 8bit or 16bit or 24bit or 32bit PCM\n");
+
+	/* sample rate and sample format conversion if necessary */
+	r=wav_conv_init(&wavconv,wavfd,wavsamplesize,wavchnr,wavbitnr,wavftag,
+					samplerate,wav_conv_samprate,16,wav_conv_dither);
+	if (r<0){
+		goto akai_wav2take_exit;
+	}
+	if (r>0){
+		PRINTF_ERR("invalid WAV format, must be 8bit or 16bit or 24bit or 32bit PCM or 32bit or 64bit float\n");
 		/* unknown or unsupported */
 		ret=1; /* no error */
 		goto akai_wav2take_exit;
 	}
 
-	/* number of samples in WAV file */
-	/* Note: sum over all channels */
-	wavsamplecount=wavsamplesize/(wavbitnr/8);
+	if (wavconv.active){
+		samplerate=wavconv.outrate;
+		/* number of samples after conversion */
+		/* Note: sum over all channels */
+		wavsamplecount=wavconv.outcount*wavchnr;
+	}else{
+		/* number of samples in WAV file */
+		/* Note: sum over all channels */
+		wavsamplecount=wavsamplesize/(wavbitnr/8);
+	}
 #if 0
 	if (wavsamplecount==0){
 		PRINTF_ERR("no samples in WAV file\n");
@@ -730,77 +817,17 @@ akai_wav2take(int wavfd,char *wavname,struct part_s *pp,u_int ti,u_int *bcountp,
 
 	if (csizes>0){
 		/* read WAV sample and write sample to DD take */
-#if 1
-		if (wavbitnr==16){
-			/* Note: no sample format conversion necessary */
-			/* copy sample from WAV file to DD take */
-			if (akai_import_ddfatchain(pp,cstarts,0,samplesize,wavfd,NULL)<0){
-				PRINTF_ERR("cannot import DD take\n");
-				goto akai_wav2take_exit;
-			}
-			bcount+=samplesize;
-		}else
-#endif
-		{
-			/* allocate WAV sample buffer */
-			/* buffer for at least 16bit */
-			if (wavbitnr>16){
-				wavsamplesizealloc=wavsamplecount*(wavbitnr/8);
-			}else{
-				wavsamplesizealloc=wavsamplecount*(16/8);
-			}
-			wavbuf=(u_char *)malloc(wavsamplesizealloc);
-			if (wavbuf==NULL){
-				PRINTF_ERR("cannot allocate WAV buffer\n");
-				goto akai_wav2take_exit;
-			}
-
-			/* read WAV sample to memory */
-			if (READ(wavfd,wavbuf,wavsamplesize)!=(int)wavsamplesize){
-				PRINTF_ERR("cannot read sample\n");
-				goto akai_wav2take_exit;
-			}
-			bcount+=wavsamplesize;
-			if (wavbitnr==8){
-				/* convert 8bit WAV sample format into 16bit WAV sample format */
-				/* Note: write pointer must not overtake read pointer => address sequence must be downwards */
-				for (i=0;i<wavsamplecount;i++){
-					j=wavsamplecount-1-i;
-					wavbuf[j*2+1]=0x80^wavbuf[j]; /* toggle sign bit */
-					wavbuf[j*2+0]=0x00;
-				}
-			}else if (wavbitnr==24){
-				/* convert 24bit WAV sample format into 16bit WAV sample format */
-				/* Note: write pointer must not overtake read pointer => address sequence must be upwards */
-				for (i=0;i<wavsamplecount;i++){
-					/* Note: copy upper 16 bits, discard lower 8 bits */
-					wavbuf[i*2+0]=wavbuf[i*3+1];
-					wavbuf[i*2+1]=wavbuf[i*3+2];
-				}
-			}else if (wavbitnr==32){
-				/* convert 32bit WAV sample format into 16bit WAV sample format */
-				/* Note: write pointer must not overtake read pointer => address sequence must be upwards */
-				for (i=0;i<wavsamplecount;i++){
-					/* Note: copy upper 16 bits, discard lower 16 bits */
-					wavbuf[i*2+0]=wavbuf[i*4+2];
-					wavbuf[i*2+1]=wavbuf[i*4+3];
-				}
-			}
-
-			/* write sample to DD take */
-			if (akai_import_ddfatchain(pp,cstarts,0,samplesize,-1,wavbuf)<0){
-				PRINTF_ERR("cannot import DD take\n");
-				goto akai_wav2take_exit;
-			}
+		/* Note: sample format is converted into 16bit on the fly, calculate envelope on the fly */
+		if (akai_take_importsample(pp,cstarts,samplesize,wavfd,NULL,wavbitnr,wavconv.active?&wavconv:NULL,envbuf,envsiz)<0){
+			PRINTF_ERR("cannot import DD take\n");
+			goto akai_wav2take_exit;
 		}
+		bcount+=wavsamplesize;
 	}
 
 	if (csizee>0){
 		/* Note: no envelope in WAV file */
-		/* calculate envelope from sample */
-		if (akai_take_setenv(pp,cstarts,samplesize,envbuf,envsiz)<0){
-			goto akai_wav2take_exit;
-		}
+		/* Note: envelope has been calculated from sample above */
 		/* write envelope to DD take */
 		if (akai_import_ddfatchain(pp,cstarte,0,envsiz,-1,envbuf)<0){
 			PRINTF_ERR("cannot save envelope\n");
@@ -824,6 +851,11 @@ akai_wav2take(int wavfd,char *wavname,struct part_s *pp,u_int ti,u_int *bcountp,
 		if ((wavakaiheadtype==(int)WAV_AKAIHEADTYPE_DDTAKE)&&(wavakaiheadsize==sizeof(struct akai_ddtake_s))){
 			/* found matching DD take header chunk */
 			wavakaiheadfound=1;
+			if (wavconv.active&&(wavconv.outrate!=wavconv.inrate)){
+				/* Note: sample positions in header do not match converted sample rate */
+				PRINTF_OUT("DD take header in WAV ignored due to sample rate conversion\n");
+				wavakaiheadfound=0;
+			}
 		}else{
 			wavakaiheadfound=0;
 		}
@@ -921,6 +953,7 @@ akai_wav2take(int wavfd,char *wavname,struct part_s *pp,u_int ti,u_int *bcountp,
 	ret=0; /* success */
 
 akai_wav2take_exit:
+	wav_conv_free(&wavconv);
 	if (what&WAV2TAKE_OPEN){
 		if (wavfd>=0){
 			CLOSE(wavfd);
@@ -932,24 +965,22 @@ akai_wav2take_exit:
 	if (envbuf!=NULL){
 		free(envbuf);
 	}
-	if (wavbuf!=NULL){
-		free(wavbuf);
-	}
 	return ret;
 }
 
 
 
-/* set envelope for take */
-int
-akai_take_setenv(struct part_s *pp,u_int cstarts,u_int samplesize,u_char *envbuf,u_int envsiz)
+/* calculate envelope of samples in sbuf */
+/* Note: sbuf contains bsize bytes of sample starting at byte ba */
+/* Note: ba must be a multiple of envelope block size in bytes, i.e. pieces can be passed in sequence */
+void
+akai_take_calcenv(u_char *sbuf,u_int ba,u_int bsize,u_char *envbuf,u_int envsiz)
 {
 	static u_char logabstab[0x100]; /* must be static */
 	static int logabstabready=0; /* must be static */
 	u_char l,lmax;
 	u_int i,j;
-	u_int ba,bremain,bchunk,la,lchunk;
-	static u_char sbuf[AKAI_DDPART_CBLKS*AKAI_HD_BLOCKSIZE]; /* 1 cluster */
+	u_int la,lchunk;
 
 	if (!logabstabready){ /* logabstab not initialized yet? */
 		double lconst;
@@ -968,12 +999,44 @@ akai_take_setenv(struct part_s *pp,u_int cstarts,u_int samplesize,u_char *envbuf
 		logabstabready=1; /* logabstab is initialized */
 	}
 
-	if ((pp==NULL)||(!pp->valid)||(pp->fat==NULL)){
-		return -1;
+	if ((sbuf==NULL)||(envbuf==NULL)){
+		return;
 	}
-	if (pp->type!=PART_TYPE_DD){
-		return -1;
+
+	i=ba/(AKAI_DDTAKE_ENVBLKSIZW<<1); /* first envelope index, *2 for 16bit per sample word */
+	la=0;
+	while ((bsize>0)&&(i<envsiz)){
+		/* envelope block */
+		lchunk=AKAI_DDTAKE_ENVBLKSIZW<<1; /* *2 for 16bit per sample word */
+		if (lchunk>bsize){
+			lchunk=bsize;
+		}
+		/* determine peak level within envelope block */
+		lmax=0;
+		for (j=0;j<lchunk;j+=2){ /* 2 for 16bit per sample word */
+			l=logabstab[sbuf[la+j+1]]; /* logabs of MSB */
+			if (l>lmax){
+				lmax=l;
+			}
+		}
+		envbuf[i]=lmax;
+
+		la+=lchunk;
+		bsize-=lchunk;
+		i++;
 	}
+}
+
+
+
+/* set envelope for take */
+/* Note: reads samples from take, walks FAT chain only once */
+int
+akai_take_setenv(struct part_s *pp,u_int cstarts,u_int samplesize,u_char *envbuf,u_int envsiz)
+{
+	struct akai_ddcursor_s c;
+	u_int ba,bchunk;
+	static u_char sbuf[AKAI_DDPART_CBLKS*AKAI_HD_BLOCKSIZE]; /* 1 cluster */
 
 	if (envbuf==NULL){
 		return -1;
@@ -986,53 +1049,151 @@ akai_take_setenv(struct part_s *pp,u_int cstarts,u_int samplesize,u_char *envbuf
 		return 0;
 	}
 
+	if (akai_ddcursor_init(&c,pp,cstarts)<0){
+		akai_ddcursor_end(&c);
+		return -1;
+	}
+
 	/* calculate envelope of samples */
-	ba=0;
-	bremain=samplesize;
-	i=0;
-	while ((bremain>0)&&(i<envsiz)){
+	for (ba=0;(ba<samplesize)&&((ba/(AKAI_DDTAKE_ENVBLKSIZW<<1))<envsiz);ba+=bchunk){
 		/* cluster */
 		bchunk=AKAI_DDPART_CBLKS*AKAI_HD_BLOCKSIZE;
-		if (bchunk>bremain){
-			bchunk=bremain;
+		if (bchunk>samplesize-ba){
+			bchunk=samplesize-ba;
 		}
 
 		/* read samples from take */
-		if (akai_export_ddfatchain(pp,cstarts,ba,bchunk,-1,sbuf)<0){
+		if (akai_ddcursor_read(&c,bchunk,-1,sbuf)<0){
 			PRINTF_ERR("cannot read take\n");
-#if 1
 			break;
-#else
-			return -1;
-#endif
 		}
 
-		la=0;
-		while ((bchunk>0)&&(i<envsiz)){
-			/* envelope block */
-			lchunk=AKAI_DDTAKE_ENVBLKSIZW<<1; /* *2 for 16bit per sample word */
-			if (lchunk>bchunk){
-				lchunk=bchunk;
+		akai_take_calcenv(sbuf,ba,bchunk,envbuf,envsiz);
+	}
+
+	akai_ddcursor_end(&c);
+	return 0;
+}
+
+
+
+/* import sample of take from file or buffer into FAT chain at cstarts */
+/* and calculate envelope on the fly (if envbuf!=NULL) */
+/* Note: samplesize is in bytes of 16bit sample words in take */
+/* Note: input is inpbitnr bits per sample word (8bit unsigned or 16/24/32bit signed as in WAV), */
+/*       converted into 16bit on the fly */
+/* Note: if convp!=NULL, input is read and converted via convp instead */
+/* Note: walks FAT chain only once */
+int
+akai_take_importsample(struct part_s *pp,u_int cstarts,u_int samplesize,int inpfd,u_char *inpbuf,u_int inpbitnr,struct wav_conv_s *convp,u_char *envbuf,u_int envsiz)
+{
+	struct akai_ddcursor_s c;
+	u_int ba,bchunk;
+	u_int rchunk;
+	u_int i,n;
+	u_char *rp;
+	int err;
+	int ret;
+	static u_char sbuf[AKAI_DDPART_CBLKS*AKAI_HD_BLOCKSIZE]; /* 1 cluster */
+	static u_char rbuf[2*AKAI_DDPART_CBLKS*AKAI_HD_BLOCKSIZE]; /* 1 cluster with up to 32bit per sample word */
+
+	if ((inpfd<0)&&(inpbuf==NULL)&&(convp==NULL)){
+		return -1;
+	}
+	if ((convp==NULL)&&(inpbitnr!=8)&&(inpbitnr!=16)&&(inpbitnr!=24)&&(inpbitnr!=32)){
+		return -1;
+	}
+
+	if (envbuf!=NULL){
+		/* zero envbuf */
+		bzero(envbuf,envsiz);
+	}
+
+	if (akai_ddcursor_init(&c,pp,cstarts)<0){
+		akai_ddcursor_end(&c);
+		return -1;
+	}
+
+	ret=-1; /* no success so far */
+	for (ba=0;ba<samplesize;ba+=bchunk){
+		/* cluster */
+		bchunk=AKAI_DDPART_CBLKS*AKAI_HD_BLOCKSIZE;
+		if (bchunk>samplesize-ba){
+			bchunk=samplesize-ba;
+		}
+		n=bchunk/2; /* number of sample words, /2 for 16bit per sample word */
+
+		if (convp!=NULL){
+			/* read and convert input */
+			if (wav_conv_read(convp,sbuf,n/convp->chnr)<0){
+				PRINTF_ERR("cannot convert sample\n");
+				goto akai_take_importsample_exit;
+			}
+		}else{
+			rchunk=n*(inpbitnr/8); /* input bytes */
+
+			/* get input */
+			if (inpbitnr==16){
+				rp=sbuf; /* no sample format conversion necessary */
+			}else{
+				rp=rbuf;
 			}
-			/* determine peak level within envelope block */
-			lmax=0;
-			for (j=0;j<lchunk;j+=2){ /* 2 for 16bit per sample word */
-				l=logabstab[sbuf[la+j+1]]; /* logabs of MSB */
-				if (l>lmax){
-					lmax=l;
+			if (inpbuf!=NULL){
+				/* from buffer */
+				bcopy(inpbuf,rp,rchunk);
+				inpbuf+=rchunk;
+			}else{
+				/* read from file */
+				err=READ(inpfd,rp,rchunk);
+				if (err<0){
+					PERROR("read");
+					goto akai_take_importsample_exit;
+				}
+				if (err!=(int)rchunk){
+					PRINTF_ERR("read: incomplete\n");
+					goto akai_take_importsample_exit;
 				}
 			}
-			envbuf[i]=lmax;
 
-			ba+=lchunk;
-			bremain-=lchunk;
-			la+=lchunk;
-			bchunk-=lchunk;
-			i++;
+			if (inpbitnr==8){
+				/* convert 8bit WAV sample format into 16bit WAV sample format */
+				for (i=0;i<n;i++){
+					sbuf[i*2+1]=0x80^rbuf[i]; /* toggle sign bit */
+					sbuf[i*2+0]=0x00;
+				}
+			}else if (inpbitnr==24){
+				/* convert 24bit WAV sample format into 16bit WAV sample format */
+				for (i=0;i<n;i++){
+					/* Note: copy upper 16 bits, discard lower 8 bits */
+					sbuf[i*2+0]=rbuf[i*3+1];
+					sbuf[i*2+1]=rbuf[i*3+2];
+				}
+			}else if (inpbitnr==32){
+				/* convert 32bit WAV sample format into 16bit WAV sample format */
+				for (i=0;i<n;i++){
+					/* Note: copy upper 16 bits, discard lower 16 bits */
+					sbuf[i*2+0]=rbuf[i*4+2];
+					sbuf[i*2+1]=rbuf[i*4+3];
+				}
+			}
+		}
+
+		if (envbuf!=NULL){
+			/* envelope of this piece */
+			akai_take_calcenv(sbuf,ba,bchunk,envbuf,envsiz);
+		}
+
+		/* write to take */
+		if (akai_ddcursor_write(&c,bchunk,-1,sbuf)<0){
+			goto akai_take_importsample_exit;
 		}
 	}
 
-	return 0;
+	ret=0; /* success */
+
+akai_take_importsample_exit:
+	akai_ddcursor_end(&c);
+	return ret;
 }
 
 
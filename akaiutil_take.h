@@ -24,6 +24,7 @@
 
 #include "commoninclude.h"
 #include "akaiutil.h"
+#include "akaiutil_wav.h"
 
 
 
@@ -52,16 +53,35 @@ extern int akai_import_take(int inpfd,struct part_s *pp,struct akai_ddtake_s *tp
 
 extern int akai_export_take(int outfd,struct part_s *pp,struct akai_ddtake_s *tp,u_int csizes,u_int csizee,u_int cstarts,u_int cstarte);
 
+/* context for conversion of DD take into WAV file */
+struct akai_take2wav_s{
+	struct part_s *pp;
+	u_int ti; /* take index */
+	u_int cstarts; /* sample start cluster */
+	u_int samplestart;
+	u_int samplesize;
+	u_int samplerate;
+	u_int samplechnr;
+	char wavname[AKAI_NAME_LEN+4+1]; /* name (ASCII), +4 for ".<type>", +1 for '\0' */
+	int probed; /* take has been checked */
+};
+
 #define TAKE2WAV_CHECK		1
 #define TAKE2WAV_EXPORT		2
 #define TAKE2WAV_CREATE		4
 #define TAKE2WAV_ALL		0xff
+extern int akai_take2wav_open(struct akai_take2wav_s *cp,struct part_s *pp,u_int ti);
+extern int akai_take2wav_probe(struct akai_take2wav_s *cp,u_int *sizep,char **wavnamep);
+extern int akai_take2wav_convert(struct akai_take2wav_s *cp,int wavfd);
+extern void akai_take2wav_close(struct akai_take2wav_s *cp);
 extern int akai_take2wav(struct part_s *pp,u_int ti,int wavfd,u_int *sizep,char **wavnamep,int what);
 
 #define WAV2TAKE_OPEN		1
 extern int akai_wav2take(int wavfd,char *wavname,struct part_s *pp,u_int ti,u_int *bcountp,int what);
 
+extern void akai_take_calcenv(u_char *sbuf,u_int ba,u_int bsize,u_char *envbuf,u_int envsiz);
 extern int akai_take_setenv(struct part_s *pp,u_int cstarts,u_int samplesize,u_char *envbuf,u_int envsiz);
+extern int akai_take_importsample(struct part_s *pp,u_int cstarts,u_int samplesize,int inpfd,u_char *inpbuf,u_int inpbitnr,struct wav_conv_s *convp,u_char *envbuf,u_int envsiz);
 
 
 
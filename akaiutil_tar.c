@@ -60,6 +60,105 @@ tar_checksum(u_char *hp)
 	return sum;
 }
 
+
+
+/* output buffer for tar export */
+static u_char tar_obuf[TAR_OBUF_SIZE];
+static u_int tar_obuf_len=0; /* number of bytes in output buffer */
+
+/* write n bytes to fd */
+/* Note: fd might be a pipe (e.g. stdout), short writes are possible */
+static int
+tar_write_all(int fd,u_char *p,u_int n)
+{
+	int m;
+
+	while (n>0){
+		m=WRITE(fd,(void *)p,n);
+		if (m<0){
+			if (errno==EINTR){
+				continue; /* retry */
+			}
+			return -1;
+		}
+		if (m==0){
+			return -1; /* no progress */
+		}
+		p+=m;
+		n-=(u_int)m;
+	}
+
+	return 0;
+}
+
+static int
+tar_obuf_flush(int fd)
+{
+	u_int n;
+
+	n=tar_obuf_len;
+	tar_obuf_len=0; /* Note: also in case of error */
+	if (n>0){
+		if (tar_write_all(fd,tar_obuf,n)<0){
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+static u_char *
+tar_obuf_reserve(int fd,u_int n)
+{
+	/* Note: data must be committed by caller via tar_obuf_len+=n */
+
+	if (n>TAR_OBUF_SIZE){
+		return NULL;
+	}
+	if (tar_obuf_len+n>TAR_OBUF_SIZE){ /* no space left? */
+		if (tar_obuf_flush(fd)<0){
+			return NULL;
+		}
+	}
+
+	return tar_obuf+tar_obuf_len;
+}
+
+static int
+tar_obuf_write(int fd,void *p,u_int n)
+{
+	u_char *bp;
+
+	/* Note: p==NULL means zeroes */
+	if (n>TAR_OBUF_SIZE){
+		if (p==NULL){
+			return -1;
+		}
+		/* write directly */
+		if (tar_obuf_flush(fd)<0){
+			return -1;
+		}
+		if (tar_write_all(fd,(u_char *)p,n)<0){
+			return -1;
+		}
+		return 0;
+	}
+
+	if ((bp=tar_obuf_reserve(fd,n))==NULL){
+		return -1;
+	}
+	if (p==NULL){
+		bzero(bp,n);
+	}else{
+		bcopy(p,bp,n);
+	}
+	tar_obuf_len+=n;
+
+	return 0;
+}
+
+
+
 int
 tar_export(int fd,struct disk_s *dp,struct part_s *pp,struct vol_s *vp,struct file_s *fp,u_int ti,u_int flags,int verbose,u_char *filtertagp)
 {
@@ -67,7 +166,7 @@ tar_export(int fd,struct disk_s *dp,struct part_s *pp,struct vol_s *vp,struct fi
 	u_int chksum;
 	u_int size;
 	u_int n;
-	u_char buf[TAR_BLOCKSIZE];
+	u_char *bp;
 	int wavret;
 	char *wavname;
 	int wavconvflag;
@@ -336,7 +435,7 @@ tar_export(int fd,struct disk_s *dp,struct part_s *pp,struct vol_s *vp,struct fi
 	sprintf(tarhd.chksum,"%06o",chksum);
 	
 	/* write tar header */
-	if (WRITE(fd,(void *)&tarhd,sizeof(struct tar_head_s))!=sizeof(struct tar_head_s)){
+	if (tar_obuf_write(fd,(void *)&tarhd,sizeof(struct tar_head_s))<0){
 		PRINTF_ERR("cannot write tar header\n");
 		return -1;
 	}
@@ -347,6 +446,11 @@ tar_export(int fd,struct disk_s *dp,struct part_s *pp,struct vol_s *vp,struct fi
 
 	if (flags&TAR_EXPORT_DDFILE){
 		/* export DD take */
+		/* Note: written directly */
+		if (tar_obuf_flush(fd)<0){
+			PRINTF_ERR("cannot write tar-file\n");
+			return -1;
+		}
 		if (wavconvflag){
 			if (akai_take2wav(pp,ti,fd,NULL,NULL,SAMPLE2WAV_EXPORT)<0){
 				return -1;
@@ -361,21 +465,38 @@ tar_export(int fd,struct disk_s *dp,struct part_s *pp,struct vol_s *vp,struct fi
 
 	if (flags&TAR_EXPORT_FILE){
 		/* export sampler file */
-		if (wavconvflag){
-			if (akai_sample2wav(fp,fd,NULL,NULL,SAMPLE2WAV_EXPORT)<0){
+		if ((!wavconvflag)&&(fp->size<=TAR_OBUF_FILEMAX)){
+			/* read file into output buffer */
+			if ((bp=tar_obuf_reserve(fd,fp->size))==NULL){
+				PRINTF_ERR("cannot write tar-file\n");
 				return -1;
 			}
+			if (akai_read_file(-1,bp,fp,0,fp->size)<0){
+				return -1;
+			}
+			tar_obuf_len+=fp->size;
 		}else{
-			if (akai_read_file(fd,NULL,fp,0,fp->size)<0){
+			/* large file or WAV conversion: written directly */
+			if (tar_obuf_flush(fd)<0){
+				PRINTF_ERR("cannot write tar-file\n");
 				return -1;
 			}
+			if (wavconvflag){
+				if (akai_sample2wav(fp,fd,NULL,NULL,SAMPLE2WAV_EXPORT)<0){
+					return -1;
+				}
+			}else{
+				if (akai_read_file(fd,NULL,fp,0,fp->size)<0){
+					return -1;
+				}
+			}
 		}
 	}
 
 #ifndef TAR_NOTAGSFILE
 	if (flags&TAR_EXPORT_TAGSFILE){
 		/* export tags-file */
-		if (WRITE(fd,(void *)pp->head.hd.tagsmagic,size)!=(int)size){
+		if (tar_obuf_write(fd,(void *)pp->head.hd.tagsmagic,size)<0){
 			PRINTF_ERR("cannot export tags-file\n");
 			return -1;
 		}
@@ -384,7 +505,7 @@ tar_export(int fd,struct disk_s *dp,struct part_s *pp,struct vol_s *vp,struct fi
 #ifndef TAR_NOVOLPARAMFILE
 	if (flags&TAR_EXPORT_VOLPARAMFILE){
 		/* export volparam-file */
-		if (WRITE(fd,(void *)vp->param,size)!=(int)size){
+		if (tar_obuf_write(fd,(void *)vp->param,size)<0){
 			PRINTF_ERR("cannot export volparam-file\n");
 			return -1;
 		}
@@ -395,9 +516,8 @@ tar_export(int fd,struct disk_s *dp,struct part_s *pp,struct vol_s *vp,struct fi
 	n=size%TAR_BLOCKSIZE;
 	n=(TAR_BLOCKSIZE-n)%TAR_BLOCKSIZE;
 	if (n>0){
-		bzero(buf,n);
-		/* write */
-		if (WRITE(fd,(void *)buf,n)!=(int)n){
+		/* write zeroes */
+		if (tar_obuf_write(fd,NULL,n)<0){
 			PRINTF_ERR("cannot write rest of block\n");
 			return -1;
 		}
@@ -566,6 +686,7 @@ tar_export_alldisks(int fd,u_int flags,int verbose,u_char *filtertagp)
 int
 tar_export_curdir(int fd,int verbose,u_int flags)
 {
+	int ret;
 
 	if (fd<0){
 		return -1;
@@ -573,30 +694,35 @@ tar_export_curdir(int fd,int verbose,u_int flags)
 
 	if (curdiskp==NULL){ /* no disk? */
 		/* now, on system level */
-		return tar_export_alldisks(fd,flags,verbose,curfiltertag);
-	}
-	if (curpartp==NULL){ /* no partition? */
+		ret=tar_export_alldisks(fd,flags,verbose,curfiltertag);
+	}else if (curpartp==NULL){ /* no partition? */
 		/* now, on disk */
-		return tar_export_disk(fd,curdiskp,flags,verbose,curfiltertag);
-	}
-	if (curvolp==NULL){ /* no sampler volume? */
+		ret=tar_export_disk(fd,curdiskp,flags,verbose,curfiltertag);
+	}else if (curvolp==NULL){ /* no sampler volume? */
 		/* now, in partition (sampler or DD) */
-		return tar_export_part(fd,curpartp,flags,verbose,curfiltertag);
+		ret=tar_export_part(fd,curpartp,flags,verbose,curfiltertag);
+	}else{
+		/* now, in sampler volume */
+		ret=tar_export_vol(fd,curvolp,flags,verbose,curfiltertag);
+	}
+
+	/* write rest of output buffer */
+	/* Note: also in case of error */
+	if (tar_obuf_flush(fd)<0){
+		PRINTF_ERR("cannot write tar-file\n");
+		ret=-1;
 	}
-	/* now, in sampler volume */
-	return tar_export_vol(fd,curvolp,flags,verbose,curfiltertag);
+
+	return ret;
 }
 
 int
 tar_export_tailzero(int fd)
 {
-	u_char buf[TAR_TAILZERO_BLOCKS*TAR_BLOCKSIZE];
-
-	/* zero blocks */
-	bzero(buf,TAR_TAILZERO_BLOCKS*TAR_BLOCKSIZE);
 
-	/* write blocks */
-	if (WRITE(fd,buf,TAR_TAILZERO_BLOCKS*TAR_BLOCKSIZE)!=TAR_TAILZERO_BLOCKS*TAR_BLOCKSIZE){
+	/* write zero blocks */
+	if ((tar_obuf_write(fd,NULL,TAR_TAILZERO_BLOCKS*TAR_BLOCKSIZE)<0)
+		||(tar_obuf_flush(fd)<0)){
 		PRINTF_ERR("cannot write zero blocks\n");
 		return -1;
 	}
@@ -610,7 +736,9 @@ int
 tar_import_curdir(int fd,u_int vtype0,int verbose,u_int flags)
 {
 	struct tar_head_s tarhd;
-	u_int byteend,skip;
+	u_int byteend;
+	OFF64_T off; /* offset of next header */
+	OFF64_T dataoff; /* offset of file data */
 	u_int chksum,chksum0;
 	u_int nlen;
 	u_int l;
@@ -633,7 +761,8 @@ tar_import_curdir(int fd,u_int vtype0,int verbose,u_int flags)
 	save_curdir(1); /* 1: could be modifications */
 
 	/* interpret tar file */
-	skip=0;
+	/* Note: fd must be at start of tar file, headers are read via positional I/O */
+	off=0;
 	ret=-1; /* no success so far */
 	for (;;){
 		if (verbose){
@@ -641,20 +770,9 @@ tar_import_curdir(int fd,u_int vtype0,int verbose,u_int flags)
 		}
 		restore_curdir();
 
-		/* skip if necessary */
-		if (skip>0){
-			/* skip file */
-			if (LSEEK64(fd,(OFF64_T)skip,SEEK_CUR)<0){
-				PERROR("lseek");
-				ret=-1;
-				goto tar_import_done;
-			}
-		}
-		skip=0;
-
 		/* read header */
 		/* XXX size must not exceed SSIZE_MAX! */
-		ret=(int)READ(fd,(void *)&tarhd,sizeof(struct tar_head_s));
+		ret=PREAD64(fd,(void *)&tarhd,sizeof(struct tar_head_s),off);
 		if (ret==0){
 			/* end of file */
 			ret=0; /* success */
@@ -664,6 +782,8 @@ tar_import_curdir(int fd,u_int vtype0,int verbose,u_int flags)
 			ret=-1;
 			goto tar_import_done;
 		}
+		dataoff=off+sizeof(struct tar_head_s);
+		off=dataoff; /* default: next header follows */
 
 		/* check header */
 		chksum0=tar_checksum((u_char *)&tarhd);
@@ -683,15 +803,14 @@ tar_import_curdir(int fd,u_int vtype0,int verbose,u_int flags)
 		byteend=0; /* default */
 		sscanf(tarhd.size,"%o",&byteend);
 		/* Note: if sscanf finds nothing, vtype remains! */
-		/* skip rest of full TAR_BLOCKSIZE */
-		skip=byteend%TAR_BLOCKSIZE;
-		skip=(TAR_BLOCKSIZE-skip)%TAR_BLOCKSIZE;
+		/* next header behind file, rounded up to full TAR_BLOCKSIZE */
+		/* Note: independent of how much of the file is read below */
+		off=dataoff+(OFF64_T)(((byteend+TAR_BLOCKSIZE-1)/TAR_BLOCKSIZE)*TAR_BLOCKSIZE);
 
 		/* check type */
 		if ((tarhd.type!=TAR_TYPE_DIR)
 			&&(tarhd.type!=TAR_TYPE_REG)
 			&&(tarhd.type!=TAR_TYPE_REG0)){
-			skip+=byteend; /* skip file */
 			continue; /* next */
 		}
 		/* now, directory or regular file */
@@ -712,7 +831,6 @@ tar_import_curdir(int fd,u_int vtype0,int verbose,u_int flags)
 				PRINTF_OUT("empty name, skipping file\n");
 				FLUSH_ALL;
 			}
-			skip+=byteend; /* skip file */
 			continue; /* next */
 		}
 
@@ -830,7 +948,6 @@ tar_import_curdir(int fd,u_int vtype0,int verbose,u_int flags)
 				}
 			}
 
-			skip+=byteend; /* skip file */
 			continue; /* next */
 		}
 		/* now, regular file */
@@ -842,7 +959,7 @@ tar_import_curdir(int fd,u_int vtype0,int verbose,u_int flags)
 			if ((curpartp!=NULL)&&(curpartp->type==PART_TYPE_HD)&&(curvolp==NULL)){ /* in S1000/S3000 harddisk partition on partition level? */
 				if (byteend==(4+AKAI_PARTHEAD_TAGNUM*AKAI_NAME_LEN)){ /* valid file size? (Note: tags magic and tag names) */
 					/* read tags-file into partition header */
-					if (READ(fd,(void *)curpartp->head.hd.tagsmagic,byteend)!=(int)byteend){
+					if (PREAD64(fd,(void *)curpartp->head.hd.tagsmagic,byteend,dataoff)!=(int)byteend){
 						PRINTF_ERR("cannot read tags-file\n");
 						ret=-1;
 						goto tar_import_done;
@@ -866,7 +983,6 @@ tar_import_curdir(int fd,u_int vtype0,int verbose,u_int flags)
 						PRINTF_OUT("invalid file size of tags-file, skipping file\n");
 						FLUSH_ALL;
 					}
-					skip+=byteend; /* skip file */
 					continue; /* next */
 				}
 			}else{
@@ -874,7 +990,6 @@ tar_import_curdir(int fd,u_int vtype0,int verbose,u_int flags)
 					PRINTF_OUT("tags-file must be on partition level of S1000/S3000 harddisk, skipping file\n");
 					FLUSH_ALL;
 				}
-				skip+=byteend; /* skip file */
 				continue; /* next */
 			}
 			continue; /* next */
@@ -886,7 +1001,7 @@ tar_import_curdir(int fd,u_int vtype0,int verbose,u_int flags)
 			if ((curvolp!=NULL)&&(curvolp->param!=NULL)){ /* on volume level and volume has parameters? */
 				if (byteend==sizeof(struct akai_volparam_s)){ /* valid file size? */
 					/* read volparam-file into volume */
-					if (READ(fd,(void *)curvolp->param,byteend)!=(int)byteend){
+					if (PREAD64(fd,(void *)curvolp->param,byteend,dataoff)!=(int)byteend){
 						PRINTF_ERR("cannot read volparam-file\n");
 						ret=-1;
 						goto tar_import_done;
@@ -906,7 +1021,6 @@ tar_import_curdir(int fd,u_int vtype0,int verbose,u_int flags)
 						PRINTF_OUT("invalid file size of volparam-file, skipping file\n");
 						FLUSH_ALL;
 					}
-					skip+=byteend; /* skip file */
 					continue; /* next */
 				}
 			}else{
@@ -918,7 +1032,6 @@ tar_import_curdir(int fd,u_int vtype0,int verbose,u_int flags)
 					}
 					FLUSH_ALL;
 				}
-				skip+=byteend; /* skip file */
 				continue; /* next */
 			}
 			continue; /* next */
@@ -935,14 +1048,9 @@ tar_import_curdir(int fd,u_int vtype0,int verbose,u_int flags)
 		if (strcmp(dirnamebuf,TAR_VOLINFO1FILENAME)==0){
 			if ((curvolp!=NULL)&&(curvolp->param!=NULL)){ /* on volume level and volume has parameters? */
 				if (byteend==(TAR_VOLINFO1FILE_SKIPB+sizeof(struct akai_volparam_s))){ /* valid file size? */
-					if (LSEEK64(fd,(OFF64_T)TAR_VOLINFO1FILE_SKIPB,SEEK_CUR)<0){
-						PERROR("lseek");
-						ret=-1;
-						goto tar_import_done;
-					}
 					/* read volume parameters from volinfo1-file into volume */
 					l=sizeof(struct akai_volparam_s);
-					if (READ(fd,(void *)curvolp->param,l)!=(int)l){
+					if (PREAD64(fd,(void *)curvolp->param,l,dataoff+TAR_VOLINFO1FILE_SKIPB)!=(int)l){
 						PRINTF_ERR("cannot read volinfo1-file\n");
 						ret=-1;
 						goto tar_import_done;
@@ -962,7 +1070,6 @@ tar_import_curdir(int fd,u_int vtype0,int verbose,u_int flags)
 						PRINTF_OUT("invalid file size of volinfo1-file, skipping file\n");
 						FLUSH_ALL;
 					}
-					skip+=byteend; /* skip file */
 					continue; /* next */
 				}
 			}else{
@@ -974,7 +1081,6 @@ tar_import_curdir(int fd,u_int vtype0,int verbose,u_int flags)
 					}
 					FLUSH_ALL;
 				}
-				skip+=byteend; /* skip file */
 				continue; /* next */
 			}
 			continue; /* next */
@@ -987,7 +1093,6 @@ tar_import_curdir(int fd,u_int vtype0,int verbose,u_int flags)
 				PRINTF_OUT("skipping dat-file\n");
 				FLUSH_ALL;
 			}
-			skip+=byteend; /* skip file */
 			continue; /* next */
 		}
 #endif
@@ -1020,6 +1125,12 @@ tar_import_curdir(int fd,u_int vtype0,int verbose,u_int flags)
 				}
 
 				/* Note: don't check if name already used, create new DD take */
+				/* position fd at file data for sequential reading */
+				if (LSEEK64(fd,dataoff,SEEK_SET)<0){
+					PERROR("lseek");
+					ret=-1;
+					goto tar_import_done;
+				}
 				wavret=akai_wav2take(fd,dirnamebuf,
 									 curpartp,
 									 ti,
@@ -1029,14 +1140,12 @@ tar_import_curdir(int fd,u_int vtype0,int verbose,u_int flags)
 					ret=-1;
 					goto tar_import_done;
 				}
-				skip+=byteend-wavbcount; /* skip unread rest */
 				continue; /* file done, next */
 			}
 
 			/* check file name */
 			if ((nlen<3)||(strcmp(dirnamebuf+nlen-3,AKAI_DDTAKE_FNAMEEND)!=0)){
 					PRINTF_ERR("invalid file name for DD take, skipping file\n");
-					skip+=byteend; /* skip file */
 					continue; /* next */
 			}
 
@@ -1053,6 +1162,12 @@ tar_import_curdir(int fd,u_int vtype0,int verbose,u_int flags)
 				goto tar_import_done;
 			}
 
+			/* position fd at file data for sequential reading */
+			if (LSEEK64(fd,dataoff,SEEK_SET)<0){
+				PERROR("lseek");
+				ret=-1;
+				goto tar_import_done;
+			}
 			/* get DD take header (DD directory entry) */
 			if (READ(fd,&t,sizeof(struct akai_ddtake_s))!=(int)sizeof(struct akai_ddtake_s)){
 				PRINTF_ERR("cannot read DD take header\n");
@@ -1091,8 +1206,6 @@ tar_import_curdir(int fd,u_int vtype0,int verbose,u_int flags)
 				goto tar_import_done;
 			}
 
-			/* skip unread rest */
-			skip+=byteend-tsize;
 			continue; /* next */
 		}
 
@@ -1104,7 +1217,6 @@ tar_import_curdir(int fd,u_int vtype0,int verbose,u_int flags)
 			goto tar_import_done;
 		}
 #if 0
-		skip+=byteend; /* skip file */
 		continue; /* next */
 #endif
 
@@ -1152,6 +1264,12 @@ tar_import_curdir(int fd,u_int vtype0,int verbose,u_int flags)
 				/* Note: if S900 sample, use non-compressed sample format */
 			}
 
+			/* position fd at file data for sequential reading */
+			if (LSEEK64(fd,dataoff,SEEK_SET)<0){
+				PERROR("lseek");
+				ret=-1;
+				goto tar_import_done;
+			}
 			/* Note: akai_wav2sample() will correct osver if necessary */
 			wavret=akai_wav2sample(fd,dirnamebuf,
 								   curvolp,
@@ -1166,7 +1284,6 @@ tar_import_curdir(int fd,u_int vtype0,int verbose,u_int flags)
 				ret=-1;
 				goto tar_import_done;
 			}
-			skip+=byteend-wavbcount; /* skip unread rest */
 			continue; /* file done, next */
 		}
 
@@ -1181,7 +1298,6 @@ tar_import_curdir(int fd,u_int vtype0,int verbose,u_int flags)
 					PRINTF_OUT("invalid file name/type, skipping file\n");
 					FLUSH_ALL;
 				}
-				skip+=byteend; /* skip file */
 				continue; /* next */
 			}
 		}
@@ -1209,6 +1325,12 @@ tar_import_curdir(int fd,u_int vtype0,int verbose,u_int flags)
 				ret=-1;
 				goto tar_import_done;
 		}
+		/* position fd at file data for sequential reading */
+		if (LSEEK64(fd,dataoff,SEEK_SET)<0){
+			PERROR("lseek");
+			ret=-1;
+			goto tar_import_done;
+		}
 		/* import file */
 		if (akai_write_file(fd,NULL,&tmpfile,0,tmpfile.size)<0){
 			ret=-1;
@@ -60,6 +60,11 @@ struct tar_head_s{
 
 #define TAR_TAILZERO_BLOCKS	6 /* number or zero blocks at file end */
 
+/* output buffer for tar export */
+/* Note: headers, small file bodies and padding are collected and written in large chunks */
+#define TAR_OBUF_SIZE		(1024*1024) /* in bytes, multiple of TAR_BLOCKSIZE */
+#define TAR_OBUF_FILEMAX	(256*1024) /* max. file size in bytes to be copied into output buffer, larger files are written directly */
+
 
 
 /* Declarations */
@@ -82,6 +87,7 @@ extern int tar_export_disk(int fd,struct disk_s *dp,u_int flags,int verbose,u_ch
 extern int tar_export_alldisks(int fd,u_int flags,int verbose,u_char *filtertagp);
 extern int tar_export_curdir(int fd,int verbose,u_int flags);
 extern int tar_export_tailzero(int fd);
+/* Note: tar_export*() output is buffered, tar_export_curdir() and tar_export_tailzero() flush the output buffer */
 
 #define TAR_IMPORT_WAV				0x0100
 #define TAR_IMPORT_WAVS9			0x1000
@@ -25,6 +25,64 @@
 
 
 
+/* header of last WAV file read by wav_read_head() */
+/* Note: kept for wav_find_akaihead() after data chunk */
+static struct wav_headbuf_s wav_headbuf;
+
+
+
+/* position fd at offset off */
+static int
+wav_headbuf_seek(struct wav_headbuf_s *hp,u_int off)
+{
+
+	if (off>hp->fdpos){
+		if (LSEEK64(hp->fd,(OFF64_T)(off-hp->fdpos),SEEK_CUR)<0){
+			return -1;
+		}
+	}else if (off<hp->fdpos){
+		/* Note: LSEEK64 might not return file position, backward distance is small */
+		if (LSEEK(hp->fd,-(OFF_T)(hp->fdpos-off),SEEK_CUR)<0){
+			return -1;
+		}
+	}
+	hp->fdpos=off;
+	return 0;
+}
+
+
+
+/* get len bytes at offset off from WAV header buffer, refill buffer if necessary */
+/* returns number of bytes, <0 on error */
+static int
+wav_headbuf_get(struct wav_headbuf_s *hp,u_int off,void *p,u_int len)
+{
+	int n;
+
+	if ((off<hp->base)||(off+len>hp->base+hp->len)){
+		/* not in buffer: refill buffer starting at off */
+		hp->base=hp->len=0;
+		if (wav_headbuf_seek(hp,off)<0){
+			return -1;
+		}
+		n=READ(hp->fd,hp->buf,WAV_HEADBUF_SIZE);
+		if (n<0){
+			return -1;
+		}
+		hp->base=off;
+		hp->len=(u_int)n;
+		hp->fdpos=off+(u_int)n;
+		if (len>hp->len){
+			len=hp->len;
+		}
+	}
+
+	bcopy(hp->buf+(off-hp->base),p,len);
+	return (int)len;
+}
+
+
+
 int
 wav_write_head(int outdes,
 			   u_int datasize,u_int chnr,u_int samprate,u_int bitnr,
@@ -119,12 +177,15 @@ int
 wav_read_head(int indes,
 			  u_int *bcountp,
 			  u_int *datasizep,u_int *chnrp,u_int *sampratep,u_int *bitnrp,
+			  u_int *ftagp,
 			  u_int *extrasizep,
 			  char **errstrp)
 {
 	struct wav_riffhead_s wavriffhead;
 	struct wav_chunkhead_s wavchunkhead;
 	struct wav_fmthead_s wavfmthead;
+	struct wav_headbuf_s *hp;
+	u_char subfmt[2];
 	u_int i;
 	u_int bcount;
 	u_int remain;
@@ -132,11 +193,21 @@ wav_read_head(int indes,
 	u_int chnr;
 	u_int samprate;
 	u_int bitnr;
+	u_int ftag;
 
 	bcount=0; /* no bytes read yet */
 
+	/* start new header buffer */
+	/* Note: whole header is normally read by a single READ */
+	hp=&wav_headbuf;
+	hp->fd=indes;
+	hp->base=0;
+	hp->len=0;
+	hp->fdpos=0;
+	hp->dataoff=0; /* no data chunk yet */
+
 	/* read WAVE RIFF header */
-	if (READ(indes,(char *)&wavriffhead,sizeof(struct wav_riffhead_s))!=sizeof(struct wav_riffhead_s)){
+	if (wav_headbuf_get(hp,bcount,(char *)&wavriffhead,sizeof(struct wav_riffhead_s))!=sizeof(struct wav_riffhead_s)){
 		if (errstrp!=NULL){
 			*errstrp="read WAVE RIFF header";
 		}
@@ -186,7 +257,7 @@ wav_read_head(int indes,
 			}
 			return -1;
 		}
-		if (READ(indes,(char *)&wavchunkhead,sizeof(struct wav_chunkhead_s))!=sizeof(struct wav_chunkhead_s)){
+		if (wav_headbuf_get(hp,bcount,(char *)&wavchunkhead,sizeof(struct wav_chunkhead_s))!=sizeof(struct wav_chunkhead_s)){
 			if (errstrp!=NULL){
 				*errstrp="read WAVE FMT header";
 			}
@@ -217,16 +288,12 @@ wav_read_head(int indes,
 		}
 
 		/* skip rest of chunk */
-		if (LSEEK64(indes,(OFF64_T)csize,SEEK_CUR)<0){
-			if (errstrp!=NULL){
-				*errstrp="lseek WAVE FMT header";
-			}
-			return -1;
-		}
 		bcount+=csize;
 		remain-=csize;
 	}
-	if (csize!=sizeof(struct wav_fmthead_s)){
+	/* Note: extended fmt chunk (e.g. for float or WAVE_FORMAT_EXTENSIBLE) only if ftagp!=NULL */
+	if ((csize<sizeof(struct wav_fmthead_s))
+		||((ftagp==NULL)&&(csize!=sizeof(struct wav_fmthead_s)))){
 		if (errstrp!=NULL){
 			*errstrp="invalid FMT csize";
 		}
@@ -234,23 +301,47 @@ wav_read_head(int indes,
 	}
 
 	/* read rest of fmt chunk */
-	if (READ(indes,(char *)&wavfmthead,sizeof(struct wav_fmthead_s))!=sizeof(struct wav_fmthead_s)){
+	hp->fmtoff=bcount;
+	if (wav_headbuf_get(hp,bcount,(char *)&wavfmthead,sizeof(struct wav_fmthead_s))!=sizeof(struct wav_fmthead_s)){
 		if (errstrp!=NULL){
 			*errstrp="read WAVE FMT header";
 		}
 		return -1;
 	}
-	bcount+=sizeof(struct wav_fmthead_s);
-	remain-=sizeof(struct wav_fmthead_s);
+
+	/* get ftag */
+	ftag=wavfmthead.ftag[0]
+		+(wavfmthead.ftag[1]<<8);
+	if ((ftag==WAV_HEAD_FTAG_EXTENSIBLE)&&(csize>=WAV_FMTHEAD_SUBFMTOFF+2)){
+		/* actual format tag in first two bytes of sub-format GUID */
+		if (wav_headbuf_get(hp,bcount+WAV_FMTHEAD_SUBFMTOFF,(char *)subfmt,2)!=2){
+			if (errstrp!=NULL){
+				*errstrp="read WAVE FMT header";
+			}
+			return -1;
+		}
+		ftag=subfmt[0]
+			+(subfmt[1]<<8);
+	}
+	bcount+=csize;
+	remain-=csize;
 
 	/* check ftag */
-	/* XXX allow only PCM */
-	if ((wavfmthead.ftag[0]!=(0xff&WAV_HEAD_FTAG_PCM))
-		||(wavfmthead.ftag[1]!=(0xff&(WAV_HEAD_FTAG_PCM>>8)))){
-		if (errstrp!=NULL){
-			*errstrp="invalid ftag, must be PCM format";
+	if (ftagp==NULL){
+		/* XXX allow only PCM */
+		if (ftag!=WAV_HEAD_FTAG_PCM){
+			if (errstrp!=NULL){
+				*errstrp="invalid ftag, must be PCM format";
+			}
+			return -1;
+		}
+	}else{
+		if ((ftag!=WAV_HEAD_FTAG_PCM)&&(ftag!=WAV_HEAD_FTAG_FLOAT)){
+			if (errstrp!=NULL){
+				*errstrp="invalid ftag, must be PCM or float format";
+			}
+			return -1;
 		}
-		return -1;
 	}
 
 	/* get chnr */
@@ -292,7 +383,7 @@ wav_read_head(int indes,
 			}
 			return -1;
 		}
-		if (READ(indes,(char *)&wavchunkhead,sizeof(struct wav_chunkhead_s))!=sizeof(struct wav_chunkhead_s)){
+		if (wav_headbuf_get(hp,bcount,(char *)&wavchunkhead,sizeof(struct wav_chunkhead_s))!=sizeof(struct wav_chunkhead_s)){
 			if (errstrp!=NULL){
 				*errstrp="read WAVE DATA header";
 			}
@@ -323,12 +414,6 @@ wav_read_head(int indes,
 		}
 
 		/* skip rest of chunk */
-		if (LSEEK64(indes,(OFF64_T)csize,SEEK_CUR)<0){
-			if (errstrp!=NULL){
-				*errstrp="lseek WAVE DATA header";
-			}
-			return -1;
-		}
 		bcount+=csize;
 		remain-=csize;
 	}
@@ -339,6 +424,17 @@ wav_read_head(int indes,
 		return -1;
 	}
 
+	/* position fd at start of data chunk body */
+	if (wav_headbuf_seek(hp,bcount)<0){
+		if (errstrp!=NULL){
+			*errstrp="lseek WAVE DATA header";
+		}
+		return -1;
+	}
+	hp->dataoff=bcount;
+	hp->datasize=csize;
+	hp->extrasize=remain-csize;
+
 	if (bcountp!=NULL){
 		*bcountp=bcount;
 	}
@@ -354,6 +450,9 @@ wav_read_head(int indes,
 	if (bitnrp!=NULL){
 		*bitnrp=bitnr;
 	}
+	if (ftagp!=NULL){
+		*ftagp=ftag;
+	}
 	if (extrasizep!=NULL){
 		*extrasizep=remain-csize;
 	}
@@ -368,10 +467,30 @@ int
 wav_find_akaihead(int indes,u_int *bcountp,u_int *csizep,u_int remain,u_int searchtype)
 {
 	struct wav_chunkhead_s wavchunkhead;
+	struct wav_headbuf_s *hp;
+	u_int start;
 	u_int bcount;
 	u_int csize;
 	u_int type;
 	u_int i;
+	int n;
+
+	hp=&wav_headbuf;
+	if ((hp->fd==indes)&&(hp->dataoff!=0)&&(hp->extrasize==remain)){
+		/* continue with header of wav_read_head() */
+		/* Note: fd must be at end of data chunk */
+		/* Note: chunks after data chunk might still be in buf */
+		start=hp->dataoff+hp->datasize;
+		hp->fdpos=start;
+	}else{
+		/* start new header buffer at current position */
+		hp->fd=indes;
+		hp->base=0;
+		hp->len=0;
+		hp->fdpos=0;
+		start=0;
+	}
+	hp->dataoff=0; /* header used up */
 
 	bcount=0; /* no bytes read yet */
 	csize=0; /* no chunk yet */
@@ -383,10 +502,14 @@ wav_find_akaihead(int indes,u_int *bcountp,u_int *csizep,u_int remain,u_int sear
 		if (remain<sizeof(struct wav_chunkhead_s)){
 			break;
 		}
-		if (READ(indes,(char *)&wavchunkhead,sizeof(struct wav_chunkhead_s))<0){
+		n=wav_headbuf_get(hp,start+bcount,(char *)&wavchunkhead,sizeof(struct wav_chunkhead_s));
+		if (n<0){
 			PRINTF_ERR("cannot read WAV chunk");
 			return -1;
 		}
+		if (n!=sizeof(struct wav_chunkhead_s)){
+			break;
+		}
 		bcount+=sizeof(struct wav_chunkhead_s);
 		remain-=sizeof(struct wav_chunkhead_s);
 
@@ -456,16 +579,18 @@ wav_find_akaihead(int indes,u_int *bcountp,u_int *csizep,u_int remain,u_int sear
 		}
 
 		/* skip rest of chunk */
-		if (LSEEK64(indes,(OFF64_T)csize,SEEK_CUR)<0){
-			PERROR("cannot lseek WAV chunk");
-			return -1;
-		}
 		bcount+=csize;
 		remain-=csize;
 	}
 	if (type==WAV_AKAIHEADTYPE_NONE){ /* no AKAI header chunk found? */
 		csize=0;
 	}
+	/* position fd at start of AKAI header chunk body or behind chunks read so far */
+	/* Note: caller might continue relative to bcount */
+	if (wav_headbuf_seek(hp,start+bcount)<0){
+		PERROR("cannot lseek WAV chunk");
+		return -1;
+	}
 
 	if (bcountp!=NULL){
 		*bcountp=bcount;
@@ -479,4 +604,462 @@ wav_find_akaihead(int indes,u_int *bcountp,u_int *csizep,u_int remain,u_int sear
 
 
 
+#define WAV_CONV_PI	3.14159265358979323846
+
+u_int wav_conv_samprate=0; /* keep sample rate */
+int wav_conv_dither=0; /* no dither, truncate */
+
+/* raw input chunk, up to WAV_CONV_CHMAX channels with 64bit */
+static u_char wav_conv_rbuf[WAV_CONV_XFRAMES*WAV_CONV_CHMAX*8];
+
+
+
+/* modified Bessel function of order 0 for Kaiser window */
+static double
+wav_conv_i0(double x)
+{
+	double sum,term;
+	u_int k;
+
+	sum=1.0;
+	term=1.0;
+	for (k=1;k<100;k++){
+		term*=(x/(2.0*(double)k))*(x/(2.0*(double)k));
+		sum+=term;
+		if (term<1.0e-12*sum){
+			break;
+		}
+	}
+	return sum;
+}
+
+
+
+static u_int
+wav_conv_gcd(u_int a,u_int b)
+{
+	u_int t;
+
+	while (b!=0){
+		t=a%b;
+		a=b;
+		b=t;
+	}
+	return a;
+}
+
+
+
+/* returns 0 on success, 1 if format not supported, -1 on error */
+int
+wav_conv_init(struct wav_conv_s *cp,int fd,u_int datasize,
+			  u_int chnr,u_int bitnr,u_int ftag,u_int inrate,
+			  u_int outrate,u_int outbits,int dither)
+{
+	U_INT64 count;
+	double fc,d,h,sum,w;
+	float *cf;
+	u_int g;
+	u_int j,k;
+	u_int c;
+
+	if (cp==NULL){
+		return -1;
+	}
+	bzero(cp,sizeof(struct wav_conv_s));
+
+	if ((chnr==0)||(chnr>WAV_CONV_CHMAX)){
+		return 1;
+	}
+	if (ftag==WAV_HEAD_FTAG_PCM){
+		if ((bitnr!=8)&&(bitnr!=16)&&(bitnr!=24)&&(bitnr!=32)){
+			return 1;
+		}
+	}else if (ftag==WAV_HEAD_FTAG_FLOAT){
+		if ((bitnr!=32)&&(bitnr!=64)){
+			return 1;
+		}
+	}else{
+		return 1;
+	}
+	if ((outbits!=16)&&(outbits!=12)){
+		return -1;
+	}
+	if (outrate==0){
+		outrate=inrate; /* keep sample rate */
+	}
+
+	cp->fd=fd;
+	cp->chnr=chnr;
+	cp->bitnr=bitnr;
+	cp->ftag=ftag;
+	cp->bpf=chnr*(bitnr/8);
+	cp->inrate=inrate;
+	cp->outrate=outrate;
+	cp->outbits=outbits;
+	cp->dither=dither&&(bitnr>outbits); /* Note: no dither without bit reduction */
+	cp->seed=0x12345678; /* XXX fixed seed: reproducible result */
+	cp->inremain=datasize/cp->bpf;
+	cp->inextra=datasize-cp->inremain*cp->bpf;
+	cp->outcount=cp->inremain;
+
+	if ((ftag==WAV_HEAD_FTAG_PCM)&&(outrate==inrate)&&(!cp->dither)){
+		/* no conversion necessary */
+		/* Note: bit reduction by truncation, done by caller */
+		cp->active=0;
+		return 0;
+	}
+	cp->active=1;
+
+	if (outrate!=inrate){
+		/* resampling */
+		if ((inrate==0)||(inrate>WAV_CONV_RATEMAX)||(outrate>WAV_CONV_RATEMAX)){
+			return 1;
+		}
+		g=wav_conv_gcd(outrate,inrate);
+		cp->l=outrate/g;
+		cp->m=inrate/g;
+		count=(((U_INT64)cp->inremain)*((U_INT64)cp->l)+((U_INT64)cp->m)-1)/((U_INT64)cp->m); /* round up */
+		if (count>(U_INT64)0x7fffffff){
+			return 1;
+		}
+		cp->outcount=(u_int)count;
+
+		/* polyphase windowed-sinc filter */
+		/* cutoff frequency in cycles per input frame */
+		fc=0.5*WAV_CONV_ROLLOFF;
+		if (outrate<inrate){
+			fc*=((double)outrate)/((double)inrate);
+		}
+		cp->half=(u_int)ceil(((double)WAV_CONV_ZEROS)/(2.0*fc));
+		cp->taps=(2*cp->half+WAV_CONV_LANES-1)&~(WAV_CONV_LANES-1); /* multiple of WAV_CONV_LANES for dot product */
+		cp->phnr=(cp->l<WAV_CONV_PHASEMAX)?cp->l:WAV_CONV_PHASEMAX;
+		cp->coef=(float *)malloc(cp->phnr*cp->taps*sizeof(float));
+		if (cp->coef==NULL){
+			PERROR("malloc");
+			return -1;
+		}
+		for (j=0;j<cp->phnr;j++){
+			cf=cp->coef+j*cp->taps;
+			sum=0.0;
+			for (k=0;k<cp->taps;k++){
+				/* distance of input frame to output position */
+				/* Note: tap k is input frame i-half+1+k, output at i+j/phnr */
+				d=((double)k)-((double)cp->half)+1.0-((double)j)/((double)cp->phnr);
+				if (fabs(d)>=(double)cp->half){
+					h=0.0;
+				}else{
+					w=d/((double)cp->half);
+					w=wav_conv_i0(WAV_CONV_BETA*sqrt(1.0-w*w))/wav_conv_i0(WAV_CONV_BETA);
+					if (d==0.0){
+						h=2.0*fc;
+					}else{
+						h=sin(2.0*WAV_CONV_PI*fc*d)/(WAV_CONV_PI*d);
+					}
+					h*=w;
+				}
+				cf[k]=(float)h;
+				sum+=h;
+			}
+			/* normalize for unity gain */
+			for (k=0;k<cp->taps;k++){
+				cf[k]=(float)(((double)cf[k])/sum);
+			}
+		}
+		cp->xsize=cp->taps+WAV_CONV_XFRAMES;
+		/* input frames before first one are zero */
+		cp->xpos=-((INT64)cp->half)+1;
+		cp->xlen=cp->half-1;
+	}else{
+		cp->xsize=WAV_CONV_XFRAMES;
+		cp->xpos=0;
+		cp->xlen=0;
+	}
+	cp->outremain=cp->outcount;
+	cp->n=0;
+
+	for (c=0;c<chnr;c++){
+		cp->x[c]=(float *)malloc(cp->xsize*sizeof(float));
+		if (cp->x[c]==NULL){
+			PERROR("malloc");
+			wav_conv_free(cp);
+			return -1;
+		}
+		bzero(cp->x[c],cp->xlen*sizeof(float));
+	}
+
+	return 0;
+}
+
+
+
+void
+wav_conv_free(struct wav_conv_s *cp)
+{
+	u_int c;
+
+	if (cp==NULL){
+		return;
+	}
+	for (c=0;c<WAV_CONV_CHMAX;c++){
+		if (cp->x[c]!=NULL){
+			free(cp->x[c]);
+			cp->x[c]=NULL;
+		}
+	}
+	if (cp->coef!=NULL){
+		free(cp->coef);
+		cp->coef=NULL;
+	}
+	cp->active=0;
+}
+
+
+
+/* read n input frames from file and append them to x */
+static int
+wav_conv_readin(struct wav_conv_s *cp,u_int n)
+{
+	u_char *rp;
+	u_int i,c;
+	int v;
+	union{
+		u_int u;
+		float f;
+	} f32;
+	union{
+		U_INT64 u;
+		double f;
+	} f64;
+	float *xp[WAV_CONV_CHMAX];
+
+	if (READ(cp->fd,wav_conv_rbuf,n*cp->bpf)!=(int)(n*cp->bpf)){
+		PRINTF_ERR("cannot read sample\n");
+		return -1;
+	}
+	cp->inremain-=n;
+
+	for (c=0;c<cp->chnr;c++){
+		xp[c]=cp->x[c]+cp->xlen;
+	}
+	rp=wav_conv_rbuf;
+	/* de-interleave WAV channels, convert into float in [-1,1) */
+	if (cp->ftag==WAV_HEAD_FTAG_FLOAT){
+		if (cp->bitnr==32){
+			for (i=0;i<n;i++){
+				for (c=0;c<cp->chnr;c++,rp+=4){
+					f32.u=rp[0]+(rp[1]<<8)+(rp[2]<<16)+(((u_int)rp[3])<<24);
+					xp[c][i]=f32.f;
+				}
+			}
+		}else{
+			for (i=0;i<n;i++){
+				for (c=0;c<cp->chnr;c++,rp+=8){
+					f64.u=((U_INT64)(rp[0]+(rp[1]<<8)+(rp[2]<<16)+(((u_int)rp[3])<<24)))
+						+(((U_INT64)(rp[4]+(rp[5]<<8)+(rp[6]<<16)+(((u_int)rp[7])<<24)))<<32);
+					xp[c][i]=(float)f64.f;
+				}
+			}
+		}
+	}else if (cp->bitnr==8){
+		for (i=0;i<n;i++){
+			for (c=0;c<cp->chnr;c++,rp+=1){
+				xp[c][i]=((float)(((int)rp[0])-0x80))*(1.0f/128.0f);
+			}
+		}
+	}else if (cp->bitnr==16){
+		for (i=0;i<n;i++){
+			for (c=0;c<cp->chnr;c++,rp+=2){
+				v=(int)(short)(rp[0]+(rp[1]<<8));
+				xp[c][i]=((float)v)*(1.0f/32768.0f);
+			}
+		}
+	}else if (cp->bitnr==24){
+		for (i=0;i<n;i++){
+			for (c=0;c<cp->chnr;c++,rp+=3){
+				v=((int)((rp[0]<<8)+(rp[1]<<16)+(((u_int)rp[2])<<24)))>>8;
+				xp[c][i]=((float)v)*(1.0f/8388608.0f);
+			}
+		}
+	}else{
+		for (i=0;i<n;i++){
+			for (c=0;c<cp->chnr;c++,rp+=4){
+				v=(int)(rp[0]+(rp[1]<<8)+(rp[2]<<16)+(((u_int)rp[3])<<24));
+				xp[c][i]=((float)v)*(1.0f/2147483648.0f);
+			}
+		}
+	}
+	cp->xlen+=n;
+
+	return 0;
+}
+
+
+
+/* convert float sample into 16bit sample word with outbits resolution */
+static void
+wav_conv_quant(struct wav_conv_s *cp,float x,u_char *op)
+{
+	float q,v;
+	int s;
+
+	q=(float)(1<<(16-cp->outbits)); /* quantization step in 16bit sample word */
+	v=x*(32768.0f/q);
+	if (cp->dither){
+		/* TPDF dither with +/-1 LSB */
+		cp->seed=cp->seed*1664525+1013904223;
+		v+=((float)(cp->seed>>8))*(1.0f/16777216.0f);
+		cp->seed=cp->seed*1664525+1013904223;
+		v-=((float)(cp->seed>>8))*(1.0f/16777216.0f);
+	}
+	v=(float)floor(v+0.5f); /* round */
+	if (v>32767.0f/q){
+		v=(float)floor(32767.0f/q);
+	}else if (v<-32768.0f/q){
+		v=-32768.0f/q;
+	}
+	s=((int)v)*((int)q);
+	op[0]=0xff&s;
+	op[1]=0xff&(s>>8);
+}
+
+
+
+/* dot product of filter coefficients and input frames */
+/* Note: n is a multiple of WAV_CONV_LANES, one partial sum per lane */
+/* Note: the inner loop over the lanes is vectorized by the compiler at -O2 (e.g. mulps/addps), */
+/*       each lane is summed in order, so the result does not depend on vectorization */
+static float
+wav_conv_dot(const float *RESTRICT a,const float *RESTRICT b,u_int n)
+{
+	float s[WAV_CONV_LANES];
+	size_t k,m;
+	u_int i,j;
+
+	for (j=0;j<WAV_CONV_LANES;j++){
+		s[j]=0.0f;
+	}
+	m=n/WAV_CONV_LANES;
+	for (k=0;k<m;k++){
+		for (j=0;j<WAV_CONV_LANES;j++){
+			s[j]+=a[k*WAV_CONV_LANES+j]*b[k*WAV_CONV_LANES+j];
+		}
+	}
+	/* pairwise sum of lanes, e.g. (s0+s1)+(s2+s3) */
+	for (j=1;j<WAV_CONV_LANES;j*=2){
+		for (i=0;i<WAV_CONV_LANES;i+=2*j){
+			s[i]+=s[i+j];
+		}
+	}
+	return s[0];
+}
+
+
+
+/* convert next framecount output frames into outbuf (16bit interleaved) */
+/* Note: after last output frame, file is positioned at end of data chunk */
+int
+wav_conv_read(struct wav_conv_s *cp,u_char *outbuf,u_int framecount)
+{
+	U_INT64 t;
+	INT64 lo;
+	u_int i,c;
+	u_int n,d,p;
+	float *cf;
+
+	if ((cp==NULL)||(!cp->active)){
+		return -1;
+	}
+	if (framecount>cp->outremain){
+		return -1;
+	}
+
+	if (cp->coef==NULL){
+		/* no resampling */
+		while (framecount>0){
+			n=framecount;
+			if (n>WAV_CONV_XFRAMES){
+				n=WAV_CONV_XFRAMES;
+			}
+			cp->xlen=0;
+			if (wav_conv_readin(cp,n)<0){
+				return -1;
+			}
+			for (i=0;i<n;i++){
+				for (c=0;c<cp->chnr;c++,outbuf+=2){
+					wav_conv_quant(cp,cp->x[c][i],outbuf);
+				}
+			}
+			framecount-=n;
+			cp->outremain-=n;
+		}
+	}else{
+		while (framecount>0){
+			/* output frame n is at input position n*m/l */
+			t=cp->n*((U_INT64)cp->m);
+			lo=((INT64)(t/((U_INT64)cp->l)))-((INT64)cp->half)+1; /* first input frame for filter */
+			if (lo+((INT64)cp->taps)>cp->xpos+((INT64)cp->xlen)){
+				/* need more input: discard input frames before lo */
+				d=(u_int)(lo-cp->xpos);
+				if (d>cp->xlen){
+					return -1; /* XXX should not happen */
+				}
+				for (c=0;c<cp->chnr;c++){
+					memmove(cp->x[c],cp->x[c]+d,(cp->xlen-d)*sizeof(float));
+				}
+				cp->xpos+=d;
+				cp->xlen-=d;
+				n=cp->xsize-cp->xlen;
+				if (cp->inremain>0){
+					if (n>cp->inremain){
+						n=cp->inremain;
+					}
+					if (n>WAV_CONV_XFRAMES){
+						n=WAV_CONV_XFRAMES;
+					}
+					if (wav_conv_readin(cp,n)<0){
+						return -1;
+					}
+				}else{
+					/* end of input: zero padding */
+					n=(u_int)(lo+((INT64)cp->taps)-cp->xpos)-cp->xlen;
+					for (c=0;c<cp->chnr;c++){
+						bzero(cp->x[c]+cp->xlen,n*sizeof(float));
+					}
+					cp->xlen+=n;
+				}
+				continue;
+			}
+			/* filter phase */
+			p=(u_int)(t%((U_INT64)cp->l));
+			if (cp->phnr<cp->l){
+				p=(u_int)((((U_INT64)p)*((U_INT64)cp->phnr))/((U_INT64)cp->l));
+			}
+			cf=cp->coef+p*cp->taps;
+			for (c=0;c<cp->chnr;c++,outbuf+=2){
+				wav_conv_quant(cp,wav_conv_dot(cf,cp->x[c]+(lo-cp->xpos),cp->taps),outbuf);
+			}
+			cp->n++;
+			framecount--;
+			cp->outremain--;
+		}
+	}
+
+	if (cp->outremain==0){
+		/* skip rest of data chunk */
+		if ((cp->inremain>0)||(cp->inextra>0)){
+			if (LSEEK64(cp->fd,((OFF64_T)cp->inremain)*((OFF64_T)cp->bpf)+((OFF64_T)cp->inextra),SEEK_CUR)<0){
+				PERROR("lseek");
+				return -1;
+			}
+			cp->inremain=0;
+			cp->inextra=0;
+		}
+	}
+
+	return 0;
+}
+
+
+
 /* EOF */
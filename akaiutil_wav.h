@@ -49,6 +49,8 @@ struct wav_chunkhead_s{
 struct wav_fmthead_s{
 /* continued FormatChunk */
 #define WAV_HEAD_FTAG_PCM 0x0001 /* 1: PCM/umcompressed */
+#define WAV_HEAD_FTAG_FLOAT 0x0003 /* 3: IEEE float */
+#define WAV_HEAD_FTAG_EXTENSIBLE 0xfffe /* format tag in sub-format */
 	u_char ftag[2];    /* format tag */
 	u_char chnr[2];    /* number of channels */
 	u_char srate[4];   /* sample rate in samples/sec */
@@ -57,6 +59,8 @@ struct wav_fmthead_s{
 	u_char bitnr[2];   /* number of Bits per sample */
 /* end FormatChunk */
 };
+/* offset of sub-format in extended fmt chunk of WAVE_FORMAT_EXTENSIBLE */
+#define WAV_FMTHEAD_SUBFMTOFF	24
 
 
 
@@ -64,6 +68,24 @@ struct wav_fmthead_s{
 
 
 
+/* buffered WAV header */
+/* Note: header chunks are parsed from memory, file is only read if a chunk lies outside of buf */
+/* Note: offsets are relative to start of RIFF header */
+#define WAV_HEADBUF_SIZE	0x2000
+struct wav_headbuf_s{
+	int fd;            /* file descriptor */
+	u_int base;        /* offset of buf[0] */
+	u_int len;         /* number of valid bytes in buf */
+	u_int fdpos;       /* current offset of fd */
+	u_int fmtoff;      /* offset of fmt chunk body */
+	u_int dataoff;     /* offset of data chunk body, 0: none */
+	u_int datasize;    /* size of data chunk body */
+	u_int extrasize;   /* remaining bytes after data chunk */
+	u_char buf[WAV_HEADBUF_SIZE];
+};
+
+
+
 #ifndef WAV_AKAIHEAD_DISABLE
 /* AKAI header chunks */
 #define WAV_CHUNKHEAD_AKAIS900SAMPLEHEADSTR		"S9H "
@@ -82,9 +104,58 @@ extern int wav_write_head(int outdes,
 
 extern int wav_read_head(int indes,u_int *bcountp,
 						 u_int *datasizep,u_int *chnrp,u_int *sampratep,u_int *bitnrp,
+						 u_int *ftagp,
 						 u_int *extrasizep,
 						 char **errstrp);
 
+/* sample format and sample rate conversion for WAV import */
+/* Note: input is read from file in chunks, output is 16bit interleaved (as 16bit PCM WAV) */
+#define WAV_CONV_CHMAX		2		/* max. number of channels */
+#define WAV_CONV_RATEMAX	1000000	/* max. input sample rate */
+#define WAV_CONV_XFRAMES	4096	/* input frames per chunk */
+#define WAV_CONV_ZEROS		16		/* zero crossings of sinc filter per side */
+#define WAV_CONV_ROLLOFF	0.92	/* cutoff frequency relative to Nyquist frequency */
+#define WAV_CONV_BETA		8.0		/* Kaiser window parameter */
+#define WAV_CONV_PHASEMAX	1024	/* max. number of filter phases */
+#define WAV_CONV_LANES		4		/* partial sums in dot product, power of 2 */
+struct wav_conv_s{
+	int active;          /* conversion necessary? */
+	int fd;              /* input file descriptor */
+	u_int chnr;          /* number of channels */
+	u_int bitnr;         /* bits per input sample word */
+	u_int ftag;          /* input format tag */
+	u_int bpf;           /* bytes per input frame */
+	u_int inrate;        /* input sample rate */
+	u_int outrate;       /* output sample rate */
+	u_int outbits;       /* output resolution within 16bit sample word (16 or 12) */
+	int dither;          /* dither for bit reduction? */
+	u_int seed;          /* random generator for dither */
+	u_int inremain;      /* number of input frames not read yet */
+	u_int inextra;       /* number of bytes after last input frame */
+	u_int outcount;      /* total number of output frames */
+	u_int outremain;     /* number of output frames not converted yet */
+	/* resampling, if inrate!=outrate */
+	u_int l,m;           /* outrate/inrate=l/m */
+	u_int phnr;          /* number of filter phases */
+	u_int half;          /* half filter length in input frames */
+	u_int taps;          /* filter taps per phase (multiple of 4) */
+	float *coef;         /* filter coefficients, phnr*taps */
+	float *x[WAV_CONV_CHMAX]; /* input samples per channel */
+	u_int xsize;         /* size of x in frames */
+	u_int xlen;          /* number of valid frames in x */
+	INT64 xpos;          /* input frame index of x[][0] */
+	U_INT64 n;           /* next output frame index */
+};
+
+extern u_int wav_conv_samprate; /* output sample rate for WAV import, 0: keep */
+extern int wav_conv_dither; /* dither for bit reduction in WAV import? */
+
+extern int wav_conv_init(struct wav_conv_s *cp,int fd,u_int datasize,
+						 u_int chnr,u_int bitnr,u_int ftag,u_int inrate,
+						 u_int outrate,u_int outbits,int dither);
+extern void wav_conv_free(struct wav_conv_s *cp);
+extern int wav_conv_read(struct wav_conv_s *cp,u_char *outbuf,u_int framecount);
+
 #ifndef WAV_AKAIHEAD_DISABLE
 #define WAV_AKAIHEADTYPE_NONE			0x00
 #define WAV_AKAIHEADTYPE_SAMPLE900		0x09
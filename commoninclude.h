@@ -107,6 +107,7 @@ extern int optopt;
 #include <string.h>
 #include <ctype.h>
 #include <time.h>
+#include <sys/wait.h>
 
 #define INT64 __int64_t
 #define U_INT64 __uint64_t
@@ -162,6 +163,16 @@ extern int optopt;
 
 #include <math.h>
 
+/* restrict qualifier (C99 restrict not available in VC++) */
+#ifndef RESTRICT
+#define RESTRICT __restrict
+#endif
+
+/* host byte order */
+#if defined(_VISUALCPP)||(defined(__BYTE_ORDER__)&&(__BYTE_ORDER__==__ORDER_LITTLE_ENDIAN__))
+#define HOST_LITTLE_ENDIAN
+#endif
+
 /* O_BINARY important for Windows-based systems (esp. cygwin or VC++) */
 #ifndef O_BINARY
 #define O_BINARY 0
@@ -184,6 +195,17 @@ extern int optopt;
 #ifndef LSEEK64
 #define LSEEK64 lseek64
 #endif
+/* positional read/write, Note: file offset is unchanged (except for fallback via LSEEK64) */
+#ifndef PREAD64
+extern int mypread64(int filedes,void *buf,u_int nbyte,OFF64_T offset);
+#define PREAD64	mypread64
+#define USE_MY_PREAD64
+#endif
+#ifndef PWRITE64
+extern int mypwrite64(int filedes,const void *buf,u_int nbyte,OFF64_T offset);
+#define PWRITE64	mypwrite64
+#define USE_MY_PWRITE64
+#endif
 
 extern void bcopy(const void *src,void *dst,size_t len);
 extern void bzero(void *b,size_t len);
@@ -353,6 +353,48 @@ mylseek64(int filedes,OFF64_T offset,int whence)
 
 
 
+#ifdef USE_MY_PREAD64
+int
+mypread64(int filedes,void *buf,u_int nbyte,OFF64_T offset)
+{
+
+#ifndef _VISUALCPP
+	if ((offset>=0)&&(((OFF64_T)(OFF_T)offset)==offset)){ /* offset fits into OFF_T? */
+		return (int)pread(filedes,buf,(size_t)nbyte,(OFF_T)offset);
+	}
+#endif /* !_VISUALCPP */
+
+	/* fallback */
+	if (LSEEK64(filedes,offset,SEEK_SET)<0){
+		return -1;
+	}
+	return (int)READ(filedes,buf,nbyte);
+}
+#endif
+
+
+
+#ifdef USE_MY_PWRITE64
+int
+mypwrite64(int filedes,const void *buf,u_int nbyte,OFF64_T offset)
+{
+
+#ifndef _VISUALCPP
+	if ((offset>=0)&&(((OFF64_T)(OFF_T)offset)==offset)){ /* offset fits into OFF_T? */
+		return (int)pwrite(filedes,buf,(size_t)nbyte,(OFF_T)offset);
+	}
+#endif /* !_VISUALCPP */
+
+	/* fallback */
+	if (LSEEK64(filedes,offset,SEEK_SET)<0){
+		return -1;
+	}
+	return (int)WRITE(filedes,buf,nbyte);
+}
+#endif
+
+
+
 #ifdef USE_MY_STRHEX_TO_UINT64
 U_INT64
 my_strhex_to_uint64(char *s)